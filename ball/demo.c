@@ -59,25 +59,20 @@ static const char *demo_name(const char *path)
 
 static int demo_header_read(fs_file fp, struct demo *d)
 {
-    int magic;
-    int version;
-    int t;
+    int head[6];
+    int tail[6];
 
     struct tm date;
     char datestr[DATELEN];
 
-    magic   = get_index(fp);
-    version = get_index(fp);
+    get_index_array(fp, head, ARRAYSIZE(head));
 
-    t = get_index(fp);
-
-    if (magic == DEMO_MAGIC && version == DEMO_VERSION && t)
+    if (head[0] == DEMO_MAGIC && head[1] == DEMO_VERSION && head[2])
     {
-        d->timer = t;
-
-        d->coins  = get_index(fp);
-        d->status = get_index(fp);
-        d->mode   = get_index(fp);
+        d->timer  = head[2];
+        d->coins  = head[3];
+        d->status = head[4];
+        d->mode   = head[5];
 
         get_string(fp, d->player, sizeof (d->player));
         get_string(fp, datestr, sizeof (datestr));
@@ -100,12 +95,13 @@ static int demo_header_read(fs_file fp, struct demo *d)
         get_string(fp, d->shot, PATHMAX);
         get_string(fp, d->file, PATHMAX);
 
-        d->time  = get_index(fp);
-        d->goal  = get_index(fp);
-        (void)     get_index(fp);
-        d->score = get_index(fp);
-        d->balls = get_index(fp);
-        d->times = get_index(fp);
+        get_index_array(fp, tail, ARRAYSIZE(tail));
+
+        d->time  = tail[0];
+        d->goal  = tail[1];
+        d->score = tail[3];
+        d->balls = tail[4];
+        d->times = tail[5];
 
         return 1;
     }
@@ -116,14 +112,26 @@ static void demo_header_write(fs_file fp, struct demo *d)
 {
     char datestr[DATELEN];
 
+    int head[6];
+    int tail[6];
+
     strftime(datestr, sizeof (datestr), "%Y-%m-%dT%H:%M:%S", gmtime(&d->date));
 
-    put_index(fp, DEMO_MAGIC);
-    put_index(fp, DEMO_VERSION);
-    put_index(fp, 0);
-    put_index(fp, 0);
-    put_index(fp, 0);
-    put_index(fp, d->mode);
+    head[0] = DEMO_MAGIC;
+    head[1] = DEMO_VERSION;
+    head[2] = 0;
+    head[3] = 0;
+    head[4] = 0;
+    head[5] = d->mode;
+
+    tail[0] = d->time;
+    tail[1] = d->goal;
+    tail[2] = 0;                        /* Unused (was goal enabled flag).   */
+    tail[3] = d->score;
+    tail[4] = d->balls;
+    tail[5] = d->times;
+
+    put_index_array(fp, head, ARRAYSIZE(head));
 
     put_string(fp, d->player);
     put_string(fp, datestr);
@@ -131,12 +139,7 @@ static void demo_header_write(fs_file fp, struct demo *d)
     put_string(fp, d->shot);
     put_string(fp, d->file);
 
-    put_index(fp, d->time);
-    put_index(fp, d->goal);
-    put_index(fp, 0);                   /* Unused (was goal enabled flag).   */
-    put_index(fp, d->score);
-    put_index(fp, d->balls);
-    put_index(fp, d->times);
+    put_index_array(fp, tail, ARRAYSIZE(tail));
 }
 
 /*---------------------------------------------------------------------------*/
@@ -302,12 +305,15 @@ void demo_play_stat(int status, int coins, int timer)
     if (demo_fp)
     {
         long pos = fs_tell(demo_fp);
+        int v[3];
+
+        v[0] = timer;
+        v[1] = coins;
+        v[2] = status;
 
         fs_seek(demo_fp, 8, SEEK_SET);
 
-        put_index(demo_fp, timer);
-        put_index(demo_fp, coins);
-        put_index(demo_fp, status);
+        put_index_array(demo_fp, v, ARRAYSIZE(v));
 
         fs_seek(demo_fp, pos, SEEK_SET);
     }
@@ -130,22 +130,7 @@ static void game_run_cmd(const union cmd *cmd)
             break;
 
         case CMD_MAKE_ITEM:
-            /* Allocate and initialize a new item. */
-
-            if ((hp = realloc(vary->hv, sizeof (*hp) * (vary->hc + 1))))
-            {
-                vary->hv = hp;
-                hp = &vary->hv[vary->hc];
-                vary->hc++;
-
-                memset(hp, 0, sizeof (*hp));
-
-                v_cpy(hp->p, cmd->mkitem.p);
-
-                hp->t = cmd->mkitem.t;
-                hp->n = cmd->mkitem.n;
-            }
-
+            sol_vary_cmd(vary, &cs, cmd);
             break;
 
         case CMD_PICK_ITEM:
@@ -158,7 +143,7 @@ static void game_run_cmd(const union cmd *cmd)
                 item_color(hp, v);
                 part_burst(hp->p, v);
 
-                hp->t = ITEM_NONE;
+                sol_vary_cmd(vary, &cs, cmd);
             }
             break;
 
@@ -255,9 +240,7 @@ static void game_run_cmd(const union cmd *cmd)
             break;
 
         case CMD_CLEAR_ITEMS:
-            free(vary->hv);
-            vary->hv = NULL;
-            vary->hc = 0;
+            sol_vary_cmd(vary, &cs, cmd);
             break;
 
         case CMD_CLEAR_BALLS:
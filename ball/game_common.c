@@ -66,49 +66,6 @@ int cam_speed(int c)
 
 /*---------------------------------------------------------------------------*/
 
-const float GRAVITY_UP[] = { 0.0f, +9.8f, 0.0f };
-const float GRAVITY_DN[] = { 0.0f, -9.8f, 0.0f };
-
-void game_tilt_init(struct game_tilt *tilt)
-{
-    tilt->x[0] = 1.0f;
-    tilt->x[1] = 0.0f;
-    tilt->x[2] = 0.0f;
-
-    tilt->rx = 0.0f;
-
-    tilt->z[0] = 0.0f;
-    tilt->z[1] = 0.0f;
-    tilt->z[2] = 1.0f;
-
-    tilt->rz = 0.0f;
-}
-
-/*
- * Compute appropriate tilt axes from the view basis.
- */
-void game_tilt_axes(struct game_tilt *tilt, float view_e[3][3])
-{
-    v_cpy(tilt->x, view_e[0]);
-    v_cpy(tilt->z, view_e[2]);
-}
-
-void game_tilt_grav(float h[3], const float g[3], const struct game_tilt *tilt)
-{
-    float X[16];
-    float Z[16];
-    float M[16];
-
-    /* Compute the gravity vector from the given world rotations. */
-
-    m_rot (Z, tilt->z, V_RAD(tilt->rz));
-    m_rot (X, tilt->x, V_RAD(tilt->rx));
-    m_mult(M, Z, X);
-    m_vxfm(h, M, g);
-}
-
-/*---------------------------------------------------------------------------*/
-
 void game_view_init(struct game_view *view)
 {
     /* In VR, ensure the default view is level. */
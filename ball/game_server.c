@@ -702,7 +702,11 @@ static int game_update_state(int bt)
 
         /* Discard item. */
 
-        hp->t = ITEM_NONE;
+        {
+            union cmd cmd = { CMD_PICK_ITEM };
+            cmd.pkitem.hi = hi;
+            sol_vary_cmd(&vary, NULL, &cmd);
+        }
     }
 
     /* Test for a switch. */
@@ -130,15 +130,31 @@ int level_load(const char *filename, struct level *level)
 {
     struct s_base base;
 
-    memset(level, 0, sizeof (struct level));
     memset(&base, 0, sizeof (base));
 
     if (!sol_load_meta(&base, filename))
     {
+        memset(level, 0, sizeof (struct level));
         log_printf("Failure to load level file '%s'\n", filename);
         return 0;
     }
 
+    level_load_dict(filename, level, &base);
+
+    sol_free_base(&base);
+
+    return 1;
+}
+
+/*
+ * Initialize a level from the dictionary of its SOL, which may have come
+ * from a set index rather than from the file itself.
+ */
+void level_load_dict(const char *filename, struct level *level,
+                     const struct s_base *base)
+{
+    memset(level, 0, sizeof (struct level));
+
     SAFECPY(level->file, filename);
     SAFECPY(level->name, "00");
 
@@ -146,11 +162,7 @@ int level_load(const char *filename, struct level *level)
     score_init_hs(&level->scores[SCORE_GOAL], 59999, 0);
     score_init_hs(&level->scores[SCORE_COIN], 59999, 0);
 
-    scan_level_attribs(level, &base);
-
-    sol_free_base(&base);
-
-    return 1;
+    scan_level_attribs(level, base);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -2,6 +2,7 @@
 #define LEVEL_H
 
 #include "base_config.h"
+#include "solid_base.h"
 #include "score.h"
 
 /*---------------------------------------------------------------------------*/
@@ -48,6 +49,7 @@ struct level
 };
 
 int  level_load(const char *, struct level *);
+void level_load_dict(const char *, struct level *, const struct s_base *);
 
 /*---------------------------------------------------------------------------*/
 
@@ -475,6 +475,101 @@ const struct score *set_score(int i, int s)
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Set indices are written by "mapc --index".  For each level of the set
+ * they hold its file name and its dictionary as NUL-terminated strings,
+ * keys and values alternating, ended by an empty string.
+ */
+
+#define INDEX_VERSION 1
+
+/* Return the string after the one at P, or NULL if P is not before END. */
+
+static const char *index_next(const char *p, const char *end)
+{
+    return (p && p < end) ? p + strlen(p) + 1 : NULL;
+}
+
+/*
+ * Load all level dictionaries of set S from its index in a single read.
+ * The index is ignored unless it lists the levels of the set in order.
+ */
+static int set_load_index(struct set *s)
+{
+    char path[PATHMAX];
+    char *data;
+    int size, version, count, n = 0, i;
+
+    const char *p, *end;
+
+    if (!str_ends_with(s->file, ".txt"))
+        return 0;
+
+    SAFECPY(path, s->file);
+    strcpy(path + strlen(path) - 4, ".idx");
+
+    if (!(data = fs_load(path, &size)))
+        return 0;
+
+    /* The last string ends the file, so no string runs past it. */
+
+    if (data[size - 1] != 0 ||
+        sscanf(data, "index %d %d%n", &version, &count, &n) < 2 || n == 0 ||
+        data[n] != '\n' || version != INDEX_VERSION || count != s->count)
+    {
+        free(data);
+        return 0;
+    }
+
+    p   = data + n + 1;
+    end = data + size;
+
+    for (i = 0; i < count && p; i++)
+    {
+        struct s_base base;
+        const char *q;
+        int di;
+
+        memset(&base, 0, sizeof (base));
+
+        if (strcmp(p, s->level_name_v[i]) != 0)
+            break;
+
+        /* Count the key-value pairs, then note where each one starts. */
+
+        for (q = index_next(p, end); q && q < end && *q; base.dc++)
+            q = index_next(index_next(q, end), end);
+
+        if (!q || q >= end)
+            break;
+
+        if (!(base.dv = (struct b_dict *) calloc(base.dc + 1,
+                                                 sizeof (struct b_dict))))
+            break;
+
+        base.ac = size;
+        base.av = data;
+
+        for (di = 0, q = index_next(p, end); di < base.dc; di++)
+        {
+            base.dv[di].ai = q - data;
+            q = index_next(q, end);
+            base.dv[di].aj = q - data;
+            q = index_next(q, end);
+        }
+
+        level_load_dict(p, &level_v[i], &base);
+
+        free(base.dv);
+
+        p = index_next(q, end);
+    }
+
+    free(data);
+
+    return i == count;
+}
+
 static void set_load_levels(void)
 {
     static const char *roman[] = {
@@ -490,11 +585,16 @@ static void set_load_levels(void)
     int regular = 1, bonus = 1;
     int i;
 
+    /* Parse each level file only without an index for the set. */
+
+    const int indexed = set_load_index(s);
+
     for (i = 0; i < s->count; i++)
     {
         struct level *l = &level_v[i];
 
-        level_load(s->level_name_v[i], l);
+        if (!indexed)
+            level_load(s->level_name_v[i], l);
 
         l->number = i;
 
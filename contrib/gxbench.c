@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+/*
+ * gxbench: renderer cost on real levels, without a Wii.
+ *
+ * Built against the host GX recorder in contrib/gxhost, this loads each
+ * named level, draws it through share/wiigl.c as the game's level pose
+ * does, orbiting the camera about the ball start, and reports what the
+ * frames pushed into the GX FIFO:
+ *
+ *     gxbench [--data <dir>]... [--frames <n>] [--csv] [--budget <bytes>]
+ *             [--log <file>] <level.sol>...
+ *     gxbench --replay <file> [--csv] [--dump]
+ *
+ * Levels and their textures are looked up in each --data directory, or
+ * in ./data if none is given.
+ * Each level gets one line with the per-frame means: FIFO bytes, vertex
+ * bytes, BP/CP/XF writes, state calls, draws, vertices, display list
+ * calls and the bytes they fetch, matrix loads, texture loads, the
+ * bytes of texture the frame samples, as modelled in gxhost.h, with
+ * the largest of any one frame, and the GX state writes share/wiigl.c
+ * skipped as redundant.  With --budget,
+ * the exit status is non-zero if any level averages more FIFO bytes per
+ * frame than given, which is meant for CI.  --log records the frames of
+ * the last level into a command log, which --replay runs back through
+ * the cost model frame by frame and --dump prints as text.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "glext.h"
+#include "solid_draw.h"
+#include "config.h"
+#include "mtrl.h"
+#include "vec3.h"
+#include "fs.h"
+
+#include "gxhost.h"
+
+#define BENCH_FRAMES 60
+#define BENCH_DT     (1.0f / 60.0f)
+
+/*---------------------------------------------------------------------------*/
+
+static void print_head(int csv)
+{
+    if (csv)
+        printf("level,frames,fifo,vtx,bp,cp,xf,state,draws,verts,"
+               "dl,dlbytes,mtx,tex,texfoot,texpeak,skipped\n");
+    else
+        printf("%-32s %6s %9s %9s %6s %6s %6s %6s %6s %7s %5s %8s %5s %5s "
+               "%8s %8s %7s\n",
+               "level", "frames", "fifo", "vtx", "bp", "cp", "xf",
+               "state", "draws", "verts", "dl", "dlbytes", "mtx", "tex",
+               "texfoot", "texpeak", "skipped");
+}
+
+static double print_stats(const char *name, int csv,
+                          const struct gxhost_stats *s, unsigned long skipped)
+{
+    double n = s->frames ? (double) s->frames : 1.0;
+
+    if (csv)
+        printf("%s,%lu,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,"
+               "%.0f,%.0f,%.0f,%lu,%.0f\n",
+               name, s->frames,
+               s->fifo  / n, s->vtx   / n,
+               s->bp    / n, s->cp    / n, s->xf  / n,
+               s->state / n, s->draws / n, s->verts / n,
+               s->dl    / n, s->dl_bytes / n,
+               s->mtx   / n, s->tex   / n,
+               s->tex_bytes / n, s->tex_peak, skipped / n);
+    else
+        printf("%-32s %6lu %9.0f %9.0f %6.0f %6.0f %6.0f %6.0f %6.0f "
+               "%7.0f %5.0f %8.0f %5.0f %5.0f %8.0f %8lu %7.0f\n",
+               name, s->frames,
+               s->fifo  / n, s->vtx   / n,
+               s->bp    / n, s->cp    / n, s->xf  / n,
+               s->state / n, s->draws / n, s->verts / n,
+               s->dl    / n, s->dl_bytes / n,
+               s->mtx   / n, s->tex   / n,
+               s->tex_bytes / n, s->tex_peak, skipped / n);
+
+    return s->fifo / n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void draw_init(void)
+{
+    static const float a[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+    static const float d[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    wiigl_create_context();
+    glext_init();
+
+    glEnable(GL_NORMALIZE);
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_BLEND);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthFunc(GL_LEQUAL);
+
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, a);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, d);
+    glLightfv(GL_LIGHT1, GL_DIFFUSE, d);
+}
+
+/*
+ * One frame of the level pose, seen from angle a about the ball start.
+ */
+static void draw_frame(struct s_full *full, const float *c, float a, float t)
+{
+    static const float l0[4] = { -8.0f, +32.0f, -8.0f, 0.0f };
+    static const float l1[4] = { +8.0f, +32.0f, +8.0f, 0.0f };
+
+    struct s_rend rend;
+    float T[16], M[16];
+
+    r_draw_enable(&rend);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glFrustum(-0.1 * 4 / 3, +0.1 * 4 / 3, -0.1, +0.1, 0.1, 1000.0);
+    glMatrixMode(GL_MODELVIEW);
+
+    glPushMatrix();
+    {
+        float e[3], x[3], y[3], z[3], u[3] = { 0.0f, 1.0f, 0.0f };
+
+        e[0] = c[0] + 2.0f * sinf(a);
+        e[1] = c[1] + 0.75f;
+        e[2] = c[2] + 2.0f * cosf(a);
+
+        /* View basis as in video_calc_view. */
+
+        v_sub(z, e, c);
+        v_nrm(z, z);
+        v_crs(x, u, z);
+        v_nrm(x, x);
+        v_crs(y, z, x);
+
+        m_basis(T, x, y, z);
+        m_xps(M, T);
+
+        glLoadIdentity();
+        glMultMatrixf(M);
+        glTranslatef(-e[0], -e[1], -e[2]);
+
+        glLightfv(GL_LIGHT0, GL_POSITION, l0);
+        glLightfv(GL_LIGHT1, GL_POSITION, l1);
+        glEnable(GL_LIGHT0);
+        glEnable(GL_LIGHT1);
+
+        sol_refl(&full->draw, &rend);
+        sol_draw(&full->draw, &rend, 0, 1);
+
+        glDepthMask(GL_FALSE);
+        glDisable(GL_LIGHTING);
+        {
+            sol_bill(&full->draw, &rend, M, t);
+        }
+        glEnable(GL_LIGHTING);
+        glDepthMask(GL_TRUE);
+    }
+    glPopMatrix();
+
+    r_draw_disable(&rend);
+
+    wiigl_swap_buffers();
+}
+
+/*
+ * GX state writes the wrapper skipped as redundant in the last frame.
+ */
+static unsigned long frame_skipped(void)
+{
+    struct wiigl_stats w;
+    unsigned long n = 0;
+    int i;
+
+    wiigl_get_stats(&w);
+
+    for (i = 0; i < WIIGL_STATE_COUNT; i++)
+        n += w.avoided[i];
+
+    return n;
+}
+
+static int bench_level(const char *path, int frames, int csv,
+                       int log, double *fifo)
+{
+    struct s_full full;
+    struct gxhost_stats s;
+    float c[3] = { 0.0f, 0.0f, 0.0f };
+    unsigned long skipped = 0;
+    int i;
+
+    if (!sol_load_full(&full, path, 0))
+    {
+        fprintf(stderr, "%s: failed to load\n", path);
+        return 0;
+    }
+
+    if (full.base.uc > 0)
+        v_cpy(c, full.base.uv[0].p);
+
+    /* Draw one frame untimed, so that setup costs stay out. */
+
+    draw_frame(&full, c, 0.0f, 0.0f);
+
+    if (log)
+        gxhost_log_begin();
+
+    gxhost_reset_stats();
+
+    for (i = 0; i < frames; i++)
+    {
+        draw_frame(&full, c, 2.0f * V_PI * i / frames, i * BENCH_DT);
+        skipped += frame_skipped();
+    }
+
+    gxhost_log_end();
+    gxhost_get_stats(&s);
+
+    *fifo = print_stats(path, csv, &s, skipped);
+
+    sol_free_full(&full);
+
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int bench_replay(const char *path, int csv, int dump)
+{
+    struct gxhost_stats s;
+    int pos = 0;
+
+    if (!gxhost_log_load(path))
+    {
+        fprintf(stderr, "%s: not a GX command log\n", path);
+        return 1;
+    }
+
+    if (dump)
+        gxhost_log_dump(stdout);
+    else
+    {
+        print_head(csv);
+
+        gxhost_reset_stats();
+
+        while (gxhost_log_replay(&pos))
+            ;
+
+        gxhost_get_stats(&s);
+        print_stats(path, csv, &s, 0);
+    }
+
+    gxhost_log_free();
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    const char *log    = NULL;
+    const char *replay = NULL;
+
+    double budget = 0.0;
+    int frames = BENCH_FRAMES;
+    int csv    = 0;
+    int dump   = 0;
+    int status = 0;
+    int paths  = 0;
+    int argi;
+
+    if (!fs_init(argv[0]))
+    {
+        fprintf(stderr, "Failure to initialize virtual file system: %s\n",
+                fs_error());
+        return 1;
+    }
+
+    for (argi = 1; argi < argc; argi++)
+    {
+        if      (strcmp(argv[argi], "--csv")  == 0) csv  = 1;
+        else if (strcmp(argv[argi], "--dump") == 0) dump = 1;
+
+        else if (argi + 1 < argc && strcmp(argv[argi], "--data") == 0)
+            paths += fs_add_path(argv[++argi]);
+        else if (argi + 1 < argc && strcmp(argv[argi], "--frames") == 0)
+            frames = atoi(argv[++argi]);
+        else if (argi + 1 < argc && strcmp(argv[argi], "--budget") == 0)
+            budget = atof(argv[++argi]);
+        else if (argi + 1 < argc && strcmp(argv[argi], "--log") == 0)
+            log = argv[++argi];
+        else if (argi + 1 < argc && strcmp(argv[argi], "--replay") == 0)
+            replay = argv[++argi];
+        else
+            break;
+    }
+
+    if (replay)
+        return bench_replay(replay, csv, dump);
+
+    if (argi == argc || frames < 1)
+    {
+        fprintf(stderr,
+                "Usage: %s [--data <dir>] [--frames <n>] [--csv] "
+                "[--budget <bytes>] [--log <file>] <level.sol>...\n"
+                "       %s --replay <file> [--csv] [--dump]\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+
+    if (!paths)
+        fs_add_path("data");
+
+    config_init();
+    draw_init();
+    mtrl_init();
+
+    print_head(csv);
+
+    for (; argi < argc; argi++)
+    {
+        double fifo;
+
+        if (!bench_level(argv[argi], frames, csv, log != NULL, &fifo))
+            status = 1;
+        else if (budget > 0.0 && fifo > budget)
+        {
+            fprintf(stderr, "%s: %.0f FIFO bytes per frame, over %.0f\n",
+                    argv[argi], fifo, budget);
+            status = 1;
+        }
+    }
+
+    if (log && !gxhost_log_save(log))
+    {
+        fprintf(stderr, "%s: failed to write\n", log);
+        status = 1;
+    }
+
+    mtrl_quit();
+    fs_quit();
+
+    return status;
+}
+
+/*---------------------------------------------------------------------------*/
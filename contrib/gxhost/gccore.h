@@ -0,0 +1,474 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+#ifndef GXHOST_GCCORE_H
+#define GXHOST_GCCORE_H
+
+/*
+ * Host stand-in for the parts of libogc that share/wiigl.c uses: the GX
+ * command API, the GU matrix routines and enough of VIDEO and the system
+ * calls to get a frame on screen.  Nothing is drawn.  Every GX call is
+ * recorded and costed instead, see gxhost.h.  Constants have the values
+ * libogc gives them, so that recorded logs read the same as the real
+ * thing.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*---------------------------------------------------------------------------*/
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+typedef float    f32;
+typedef double   f64;
+
+#ifndef TRUE
+#define TRUE  1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define MEM_K0_TO_K1(p) ((void *) (p))
+
+void DCStoreRange(void *, u32);
+void DCFlushRange(void *, u32);
+void DCInvalidateRange(void *, u32);
+
+/*---------------------------------------------------------------------------*/
+
+typedef f32 Mtx[3][4];
+typedef f32 Mtx44[4][4];
+typedef f32 (*MtxP)[4];
+
+typedef struct { f32 x, y, z; } guVector;
+
+#define guMtxRowCol(m, r, c) ((m)[(r)][(c)])
+
+void guMtxIdentity(Mtx);
+void guMtxCopy(Mtx, Mtx);
+void guMtxConcat(Mtx, Mtx, Mtx);
+u32  guMtxInverse(Mtx, Mtx);
+u32  guMtxInvXpose(Mtx, Mtx);
+void guMtxApplyTrans(Mtx, Mtx, f32, f32, f32);
+void guMtxApplyScale(Mtx, Mtx, f32, f32, f32);
+void guVecNormalize(guVector *);
+void guVecMultiply(Mtx, guVector *, guVector *);
+void guFrustum(Mtx44, f32, f32, f32, f32, f32, f32);
+void guOrtho  (Mtx44, f32, f32, f32, f32, f32, f32);
+
+/*---------------------------------------------------------------------------*/
+
+typedef struct
+{
+    u32 viTVMode;
+    u16 fbWidth;
+    u16 efbHeight;
+    u16 xfbHeight;
+    u16 viXOrigin;
+    u16 viYOrigin;
+    u16 viWidth;
+    u16 viHeight;
+    u32 xfbMode;
+    u8  field_rendering;
+    u8  aa;
+    u8  sample_pattern[12][2];
+    u8  vfilter[7];
+} GXRModeObj;
+
+void        VIDEO_Init(void);
+GXRModeObj *VIDEO_GetPreferredMode(GXRModeObj *);
+void        VIDEO_Configure(GXRModeObj *);
+void        VIDEO_SetNextFramebuffer(void *);
+void        VIDEO_SetBlack(int);
+void        VIDEO_Flush(void);
+void        VIDEO_WaitVSync(void);
+
+void *SYS_AllocateFramebuffer(GXRModeObj *);
+
+/*---------------------------------------------------------------------------*/
+
+typedef struct { u8 r, g, b, a; } GXColor;
+
+/* Texture and light objects are CPU-side until loaded. */
+
+typedef struct
+{
+    void *img;
+    u16   width;
+    u16   height;
+    u8    format;
+    u8    wrap_s;
+    u8    wrap_t;
+    u8    mipmap;
+    u8    min_filt;
+    u8    mag_filt;
+    f32   min_lod;
+    f32   max_lod;
+    f32   lod_bias;
+} GXTexObj;
+
+typedef struct
+{
+    GXColor color;
+    f32     pos[3];
+    f32     dir[3];
+    f32     a[3];
+    f32     k[3];
+} GXLightObj;
+
+typedef struct { u32 val[4]; } GXTexRegion;
+typedef struct { u32 val[4]; } GXTlutRegion;
+
+#define GX_FALSE   0
+#define GX_TRUE    1
+#define GX_DISABLE 0
+#define GX_ENABLE  1
+
+/* Primitives */
+
+#define GX_POINTS        0xB8
+#define GX_LINES         0xA8
+#define GX_LINESTRIP     0xB0
+#define GX_TRIANGLES     0x90
+#define GX_TRIANGLESTRIP 0x98
+#define GX_TRIANGLEFAN   0xA0
+#define GX_QUADS         0x80
+
+/* Vertex formats and attributes */
+
+#define GX_VTXFMT0 0
+#define GX_VTXFMT1 1
+#define GX_MAXVTXFMT 8
+
+#define GX_VA_PTNMTXIDX 0
+#define GX_VA_POS       9
+#define GX_VA_NRM       10
+#define GX_VA_CLR0      11
+#define GX_VA_CLR1      12
+#define GX_VA_TEX0      13
+#define GX_VA_TEX1      14
+#define GX_VA_MAXATTR   21
+
+#define GX_NONE    0
+#define GX_DIRECT  1
+#define GX_INDEX8  2
+#define GX_INDEX16 3
+
+#define GX_U8  0
+#define GX_S8  1
+#define GX_U16 2
+#define GX_S16 3
+#define GX_F32 4
+
+#define GX_RGB565 0
+#define GX_RGB8   1
+#define GX_RGBX8  2
+#define GX_RGBA4  3
+#define GX_RGBA6  4
+#define GX_RGBA8  5
+
+#define GX_POS_XY   0
+#define GX_POS_XYZ  1
+#define GX_NRM_XYZ  0
+#define GX_CLR_RGB  0
+#define GX_CLR_RGBA 1
+#define GX_TEX_S    0
+#define GX_TEX_ST   1
+
+/* Comparison, culling, blending */
+
+#define GX_NEVER   0
+#define GX_LESS    1
+#define GX_EQUAL   2
+#define GX_LEQUAL  3
+#define GX_GREATER 4
+#define GX_NEQUAL  5
+#define GX_GEQUAL  6
+#define GX_ALWAYS  7
+
+#define GX_CULL_NONE  0
+#define GX_CULL_FRONT 1
+#define GX_CULL_BACK  2
+#define GX_CULL_ALL   3
+
+#define GX_BM_NONE     0
+#define GX_BM_BLEND    1
+#define GX_BM_LOGIC    2
+#define GX_BM_SUBTRACT 3
+
+#define GX_BL_ZERO        0
+#define GX_BL_ONE         1
+#define GX_BL_SRCCLR      2
+#define GX_BL_INVSRCCLR   3
+#define GX_BL_SRCALPHA    4
+#define GX_BL_INVSRCALPHA 5
+#define GX_BL_DSTALPHA    6
+#define GX_BL_INVDSTALPHA 7
+#define GX_BL_DSTCLR      GX_BL_SRCCLR
+#define GX_BL_INVDSTCLR   GX_BL_INVSRCCLR
+
+#define GX_LO_CLEAR 0
+
+/* Textures */
+
+#define GX_TF_I4     0x0
+#define GX_TF_I8     0x1
+#define GX_TF_IA4    0x2
+#define GX_TF_IA8    0x3
+#define GX_TF_RGB565 0x4
+#define GX_TF_RGB5A3 0x5
+#define GX_TF_RGBA8  0x6
+#define GX_TF_CMPR   0xE
+
+#define GX_CLAMP  0
+#define GX_REPEAT 1
+#define GX_MIRROR 2
+
+#define GX_NEAR          0
+#define GX_LINEAR        1
+#define GX_NEAR_MIP_NEAR 2
+#define GX_LIN_MIP_NEAR  3
+#define GX_NEAR_MIP_LIN  4
+#define GX_LIN_MIP_LIN   5
+
+#define GX_ANISO_1 0
+#define GX_ANISO_2 1
+#define GX_ANISO_4 2
+
+#define GX_TEXMAP0     0
+#define GX_TEXMAP1     1
+#define GX_MAX_TEXMAP  8
+#define GX_TEXMAP_NULL 0xFF
+
+#define GX_TEXCOORD0     0
+#define GX_TEXCOORD1     1
+#define GX_MAXCOORD      8
+#define GX_TEXCOORDNULL  0xFF
+
+/* TEV */
+
+#define GX_TEVSTAGE0 0
+#define GX_TEVSTAGE1 1
+#define GX_TEVSTAGE2 2
+#define GX_MAX_TEVSTAGE 16
+
+#define GX_TEVPREV  0
+#define GX_TEVREG0  1
+#define GX_TEVREG1  2
+#define GX_TEVREG2  3
+
+#define GX_CC_CPREV 0
+#define GX_CC_APREV 1
+#define GX_CC_C0    2
+#define GX_CC_A0    3
+#define GX_CC_C1    4
+#define GX_CC_A1    5
+#define GX_CC_C2    6
+#define GX_CC_A2    7
+#define GX_CC_TEXC  8
+#define GX_CC_TEXA  9
+#define GX_CC_RASC  10
+#define GX_CC_RASA  11
+#define GX_CC_ONE   12
+#define GX_CC_HALF  13
+#define GX_CC_KONST 14
+#define GX_CC_ZERO  15
+
+#define GX_CA_APREV 0
+#define GX_CA_A0    1
+#define GX_CA_A1    2
+#define GX_CA_A2    3
+#define GX_CA_TEXA  4
+#define GX_CA_RASA  5
+#define GX_CA_KONST 6
+#define GX_CA_ZERO  7
+#define GX_CA_ONE   GX_CA_ZERO
+
+#define GX_TEV_ADD 0
+#define GX_TEV_SUB 1
+
+#define GX_TB_ZERO    0
+#define GX_TB_ADDHALF 1
+#define GX_TB_SUBHALF 2
+
+#define GX_CS_SCALE_1   0
+#define GX_CS_SCALE_2   1
+#define GX_CS_SCALE_4   2
+#define GX_CS_DIVIDE_2  3
+
+/* Lighting channels */
+
+#define GX_COLOR0    0
+#define GX_COLOR1    1
+#define GX_ALPHA0    2
+#define GX_ALPHA1    3
+#define GX_COLOR0A0  4
+#define GX_COLOR1A1  5
+#define GX_COLORNULL 0xFF
+
+#define GX_SRC_REG 0
+#define GX_SRC_VTX 1
+
+#define GX_LIGHT0    0x001
+#define GX_LIGHT1    0x002
+#define GX_LIGHT2    0x004
+#define GX_LIGHT3    0x008
+#define GX_LIGHT4    0x010
+#define GX_LIGHT5    0x020
+#define GX_LIGHT6    0x040
+#define GX_LIGHT7    0x080
+#define GX_LIGHTNULL 0x000
+
+#define GX_DF_NONE  0
+#define GX_DF_SIGN  1
+#define GX_DF_CLAMP 2
+
+#define GX_AF_SPEC 0
+#define GX_AF_SPOT 1
+#define GX_AF_NONE 2
+
+/* Texture coordinate generation and matrices */
+
+#define GX_TG_MTX3x4 0
+#define GX_TG_MTX2x4 1
+
+#define GX_TG_POS       0
+#define GX_TG_NRM       1
+#define GX_TG_BINRM     2
+#define GX_TG_TANGENT   3
+#define GX_TG_TEX0      4
+#define GX_TG_TEX1      5
+#define GX_TG_TEXCOORD0 13
+#define GX_TG_COLOR0    20
+#define GX_TG_COLOR1    21
+
+#define GX_PNMTX0   0
+#define GX_TEXMTX0  30
+#define GX_IDENTITY 60
+
+#define GX_MTX3x4 0
+#define GX_MTX2x4 1
+
+#define GX_PERSPECTIVE  0
+#define GX_ORTHOGRAPHIC 1
+
+/* Pixel engine and copies */
+
+#define GX_PF_RGB8_Z24   0
+#define GX_PF_RGBA6_Z24  1
+#define GX_ZC_LINEAR     0
+
+#define GX_GM_1_0 0
+#define GX_GM_1_7 1
+#define GX_GM_2_2 2
+
+#define GX_TO_ZERO 0
+
+/*---------------------------------------------------------------------------*/
+
+void GX_Init(void *, u32);
+void GX_DrawDone(void);
+void GX_Flush(void);
+f32  GX_GetYScaleFactor(u16, u16);
+
+void GX_SetViewport(f32, f32, f32, f32, f32, f32);
+void GX_SetScissor(u32, u32, u32, u32);
+void GX_SetDispCopySrc(u16, u16, u16, u16);
+void GX_SetDispCopyDst(u16, u16);
+u32  GX_SetDispCopyYScale(f32);
+void GX_SetDispCopyGamma(u8);
+void GX_SetCopyFilter(u8, u8[12][2], u8, u8[7]);
+void GX_SetCopyClear(GXColor, u32);
+void GX_SetFieldMode(u8, u8);
+void GX_SetPixelFmt(u8, u8);
+void GX_CopyDisp(void *, u8);
+
+void GX_SetZMode(u8, u8, u8);
+void GX_SetBlendMode(u8, u8, u8, u8);
+void GX_SetAlphaUpdate(u8);
+void GX_SetColorUpdate(u8);
+void GX_SetCullMode(u8);
+void GX_SetPointSize(u8, u8);
+
+void GX_ClearVtxDesc(void);
+void GX_SetVtxDesc(u8, u8);
+void GX_SetVtxAttrFmt(u8, u32, u32, u32, u8);
+void GX_SetArray(u32, void *, u8);
+void GX_InvVtxCache(void);
+
+void GX_SetNumChans(u8);
+void GX_SetNumTexGens(u32);
+void GX_SetNumTevStages(u8);
+void GX_SetChanCtrl(s32, u8, u8, u8, u8, u8, u8);
+void GX_SetChanAmbColor(s32, GXColor);
+void GX_SetChanMatColor(s32, GXColor);
+void GX_SetTexCoordGen(u16, u32, u32, u32);
+
+void GX_SetTevOrder(u8, u8, u32, u8);
+void GX_SetTevColorIn(u8, u8, u8, u8, u8);
+void GX_SetTevAlphaIn(u8, u8, u8, u8, u8);
+void GX_SetTevColorOp(u8, u8, u8, u8, u8, u8);
+void GX_SetTevAlphaOp(u8, u8, u8, u8, u8, u8);
+void GX_SetTevColor(u8, GXColor);
+
+void GX_LoadPosMtxImm(Mtx, u32);
+void GX_LoadNrmMtxImm(Mtx, u32);
+void GX_LoadTexMtxImm(Mtx, u32, u8);
+void GX_LoadProjectionMtx(Mtx44, u8);
+
+void GX_InitTexObj(GXTexObj *, void *, u16, u16, u8, u8, u8, u8);
+void GX_InitTexObjFilterMode(GXTexObj *, u8, u8);
+void GX_InitTexObjLOD(GXTexObj *, u8, u8, f32, f32, f32, u8, u8, u8);
+void GX_InitTexObjWrapMode(GXTexObj *, u8, u8);
+void GX_GetTexObjAll(GXTexObj *, void **, u16 *, u16 *, u8 *, u8 *, u8 *,
+                     u8 *);
+void GX_LoadTexObj(GXTexObj *, u8);
+void GX_InvalidateTexAll(void);
+
+void GX_InitLightPos(GXLightObj *, f32, f32, f32);
+void GX_InitLightColor(GXLightObj *, GXColor);
+void GX_LoadLightObj(GXLightObj *, u8);
+
+void GX_Begin(u8, u8, u16);
+void GX_End(void);
+
+void GX_BeginDispList(void *, u32);
+u32  GX_EndDispList(void);
+void GX_CallDispList(void *, u32);
+
+void GX_Position1x16(u16);
+void GX_Position1x8(u8);
+void GX_Position3f32(f32, f32, f32);
+void GX_Normal1x16(u16);
+void GX_Normal1x8(u8);
+void GX_Normal3f32(f32, f32, f32);
+void GX_Color1x16(u16);
+void GX_Color1x8(u8);
+void GX_Color1u32(u32);
+void GX_Color4u8(u8, u8, u8, u8);
+void GX_TexCoord1x16(u16);
+void GX_TexCoord1x8(u8);
+void GX_TexCoord2f32(f32, f32);
+
+/*---------------------------------------------------------------------------*/
+
+#endif
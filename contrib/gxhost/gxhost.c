@@ -0,0 +1,2237 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "gccore.h"
+#include "gxhost.h"
+
+/*---------------------------------------------------------------------------*/
+
+/* Recorded commands. */
+
+enum
+{
+    OP_STATE = 0,
+    OP_INIT,
+
+    OP_VIEWPORT,
+    OP_SCISSOR,
+    OP_COPY_YSCALE,
+    OP_COPY_FILTER,
+    OP_COPY_CLEAR,
+    OP_FIELD_MODE,
+    OP_PIXEL_FMT,
+    OP_COPY_DISP,
+    OP_DRAW_DONE,
+
+    OP_Z_MODE,
+    OP_BLEND_MODE,
+    OP_ALPHA_UPDATE,
+    OP_COLOR_UPDATE,
+    OP_CULL_MODE,
+    OP_POINT_SIZE,
+
+    OP_CLEAR_VTX_DESC,
+    OP_VTX_DESC,
+    OP_VTX_ATTR_FMT,
+    OP_ARRAY,
+    OP_INV_VTX_CACHE,
+
+    OP_NUM_CHANS,
+    OP_NUM_TEX_GENS,
+    OP_NUM_TEV_STAGES,
+    OP_CHAN_CTRL,
+    OP_CHAN_AMB,
+    OP_CHAN_MAT,
+    OP_TEX_COORD_GEN,
+
+    OP_TEV_ORDER,
+    OP_TEV_COLOR_IN,
+    OP_TEV_ALPHA_IN,
+    OP_TEV_COLOR_OP,
+    OP_TEV_ALPHA_OP,
+    OP_TEV_COLOR,
+
+    OP_POS_MTX,
+    OP_NRM_MTX,
+    OP_TEX_MTX,
+    OP_PROJ_MTX,
+
+    OP_TEX_OBJ,
+    OP_INV_TEX_ALL,
+    OP_LIGHT_OBJ,
+
+    OP_BEGIN,
+    OP_VTX,
+    OP_END,
+
+    OP_BEGIN_DL,
+    OP_END_DL,
+    OP_CALL_DL,
+
+    OP_TEXELS,
+
+    OP_MAX
+};
+
+/*
+ * Names and argument formats for the text dump.  Format characters are
+ * d (decimal), x (hex tag), c (RGBA color) and f (float); the last one
+ * repeats for any remaining arguments.  State calls are counted in the
+ * statistics.
+ */
+
+#define F_STATE 1
+
+static const struct
+{
+    const char *name;
+    const char *fmt;
+    int flags;
+} ops[OP_MAX] = {
+    { "State",          "x",   0       },
+    { "Init",           "d",   0       },
+
+    { "SetViewport",    "f",   F_STATE },
+    { "SetScissor",     "d",   F_STATE },
+    { "SetDispCopyYScale", "f", F_STATE },
+    { "SetCopyFilter",  "d",   F_STATE },
+    { "SetCopyClear",   "cx",  F_STATE },
+    { "SetFieldMode",   "d",   F_STATE },
+    { "SetPixelFmt",    "d",   F_STATE },
+    { "CopyDisp",       "xd",  0       },
+    { "DrawDone",       "d",   0       },
+
+    { "SetZMode",       "d",   F_STATE },
+    { "SetBlendMode",   "d",   F_STATE },
+    { "SetAlphaUpdate", "d",   F_STATE },
+    { "SetColorUpdate", "d",   F_STATE },
+    { "SetCullMode",    "d",   F_STATE },
+    { "SetPointSize",   "d",   F_STATE },
+
+    { "ClearVtxDesc",   "d",   F_STATE },
+    { "SetVtxDesc",     "d",   F_STATE },
+    { "SetVtxAttrFmt",  "d",   F_STATE },
+    { "SetArray",       "dxd", F_STATE },
+    { "InvVtxCache",    "d",   0       },
+
+    { "SetNumChans",    "d",   F_STATE },
+    { "SetNumTexGens",  "d",   F_STATE },
+    { "SetNumTevStages", "d",  F_STATE },
+    { "SetChanCtrl",    "d",   F_STATE },
+    { "SetChanAmbColor", "dc", F_STATE },
+    { "SetChanMatColor", "dc", F_STATE },
+    { "SetTexCoordGen", "d",   F_STATE },
+
+    { "SetTevOrder",    "d",   F_STATE },
+    { "SetTevColorIn",  "d",   F_STATE },
+    { "SetTevAlphaIn",  "d",   F_STATE },
+    { "SetTevColorOp",  "d",   F_STATE },
+    { "SetTevAlphaOp",  "d",   F_STATE },
+    { "SetTevColor",    "dc",  F_STATE },
+
+    { "LoadPosMtxImm",  "df",  F_STATE },
+    { "LoadNrmMtxImm",  "df",  F_STATE },
+    { "LoadTexMtxImm",  "ddf", F_STATE },
+    { "LoadProjectionMtx", "df", F_STATE },
+
+    { "LoadTexObj",     "dxd", F_STATE },
+    { "InvalidateTexAll", "d", 0       },
+    { "LoadLightObj",   "dcf", F_STATE },
+
+    { "Begin",          "xdd", 0       },
+    { "Vertex",         "d",   0       },
+    { "End",            "d",   0       },
+
+    { "BeginDispList",  "xd",  0       },
+    { "EndDispList",    "d",   0       },
+    { "CallDispList",   "xd",  0       },
+
+    { "Texels",         "xd",  0       },
+};
+
+#define STATE_WORDS 9
+
+/*---------------------------------------------------------------------------*/
+
+static struct gxhost_stats stats;
+
+/* State that GX_Begin writes out, as libogc does. */
+
+#define DIRTY_GENMODE  0x1
+#define DIRTY_NUMCHANS 0x2
+#define DIRTY_NUMTEX   0x4
+#define DIRTY_VCD      0x8
+
+static u32 dirty;
+static u32 dirty_chan;                  /* Channel controls, by channel      */
+static u32 dirty_amb;                   /* Ambient colors, by channel pair   */
+static u32 dirty_mat;                   /* Material colors, by channel pair  */
+static u32 dirty_texgen;                /* Texture coordinates               */
+static u32 dirty_order;                 /* TEV orders, by stage pair         */
+static u32 dirty_vat;                   /* Vertex formats                    */
+static u32 dirty_size;                  /* Texture map sizes                 */
+
+/* Display list under construction.  Its commands bypass the FIFO. */
+
+static struct
+{
+    int on;
+    u32 max;
+    u32 size;
+    u32 draws;
+    u32 verts;
+} dl;
+
+static void fifo_raw(unsigned long n)
+{
+    if (dl.on)
+        dl.size += n;
+    else
+        stats.fifo += n;
+}
+
+static void fifo_bp(int n)
+{
+    fifo_raw(5 * n);
+
+    if (!dl.on)
+        stats.bp += n;
+}
+
+static void fifo_cp(int n)
+{
+    fifo_raw(6 * n);
+
+    if (!dl.on)
+        stats.cp += n;
+}
+
+static void fifo_xf(int n)
+{
+    fifo_raw(5 + 4 * n);
+
+    if (!dl.on)
+        stats.xf += 1;
+}
+
+static int count_bits(u32 m)
+{
+    int n = 0;
+
+    for (; m; m &= m - 1)
+        n++;
+
+    return n;
+}
+
+static u32 chan_bits(u32 chan)
+{
+    switch (chan)
+    {
+    case GX_COLOR0:   return 0x1;
+    case GX_COLOR1:   return 0x2;
+    case GX_ALPHA0:   return 0x4;
+    case GX_ALPHA1:   return 0x8;
+    case GX_COLOR0A0: return 0x5;
+    case GX_COLOR1A1: return 0xA;
+    }
+    return 0;
+}
+
+static void dirty_flush(void)
+{
+    int i, n;
+
+    if (dirty & DIRTY_GENMODE)  fifo_bp(1);
+    if (dirty & DIRTY_NUMCHANS) fifo_xf(1);
+    if (dirty & DIRTY_NUMTEX)   fifo_xf(1);
+
+    if (dirty & DIRTY_VCD)
+    {
+        fifo_cp(2);
+        fifo_xf(1);
+    }
+
+    /* Channel and texgen registers go out one XF write apiece. */
+
+    n = count_bits(dirty_chan) +
+        count_bits(dirty_amb) +
+        count_bits(dirty_mat) +
+        count_bits(dirty_texgen) * 2;
+
+    for (i = 0; i < n; i++)
+        fifo_xf(1);
+
+    fifo_bp(count_bits(dirty_order));
+    fifo_cp(count_bits(dirty_vat) * 3);
+    fifo_bp(count_bits(dirty_size) * 2);
+
+    dirty        = 0;
+    dirty_chan   = 0;
+    dirty_amb    = 0;
+    dirty_mat    = 0;
+    dirty_texgen = 0;
+    dirty_order  = 0;
+    dirty_vat    = 0;
+    dirty_size   = 0;
+}
+
+static void dirty_all(void)
+{
+    dirty        = DIRTY_GENMODE | DIRTY_NUMCHANS | DIRTY_NUMTEX | DIRTY_VCD;
+    dirty_chan   = 0xF;
+    dirty_amb    = 0x3;
+    dirty_mat    = 0x3;
+    dirty_texgen = 0xFF;
+    dirty_order  = 0xFF;
+    dirty_vat    = 0xFF;
+    dirty_size   = 0xFF;
+}
+
+/*
+ * Texture tiles touched so far in this frame, by image and level, with
+ * the size of each level in tiles.
+ */
+
+struct texels
+{
+    u32 tag;
+    u32 level;
+    u32 cap;
+    unsigned long tiles;
+};
+
+static struct texels *texels_v;
+static int            texels_n;
+static int            texels_m;
+
+static void texels_add(u32 t, u32 level, u32 tiles, u32 cap)
+{
+    int i;
+
+    for (i = 0; i < texels_n; i++)
+        if (texels_v[i].tag == t && texels_v[i].level == level)
+            break;
+
+    if (i == texels_n)
+    {
+        if (texels_n == texels_m)
+        {
+            int m = texels_m ? texels_m * 2 : 64;
+            struct texels *v;
+
+            if (!(v = realloc(texels_v, m * sizeof (*v))))
+                return;
+
+            texels_v = v;
+            texels_m = m;
+        }
+        texels_v[i].tag   = t;
+        texels_v[i].level = level;
+        texels_v[i].tiles = 0;
+        texels_n++;
+    }
+    texels_v[i].cap    = cap;
+    texels_v[i].tiles += tiles;
+}
+
+static void texels_frame(void)
+{
+    unsigned long n = 0;
+    int i;
+
+    for (i = 0; i < texels_n; i++)
+        n += 32 * (texels_v[i].tiles < texels_v[i].cap ?
+                   texels_v[i].tiles : texels_v[i].cap);
+
+    stats.tex_bytes += n;
+
+    if (stats.tex_peak < n)
+        stats.tex_peak = n;
+
+    texels_n = 0;
+}
+
+/*
+ * Apply the cost of one command.  Live calls and replayed logs both come
+ * through here, so that both count the same.
+ */
+static void gx_exec(int op, int n, const u32 *v)
+{
+    if (ops[op].flags & F_STATE)
+        stats.state++;
+
+    switch (op)
+    {
+    case OP_STATE:
+        if (n == STATE_WORDS)
+        {
+            dirty        = v[0];
+            dirty_chan   = v[1];
+            dirty_amb    = v[2];
+            dirty_mat    = v[3];
+            dirty_texgen = v[4];
+            dirty_order  = v[5];
+            dirty_vat    = v[6];
+            dirty_size   = v[7];
+        }
+        break;
+
+    case OP_INIT:
+        dirty_all();
+        break;
+
+    case OP_VIEWPORT:     fifo_xf(6); break;
+    case OP_SCISSOR:      fifo_bp(2); break;
+    case OP_COPY_YSCALE:  fifo_bp(1); break;
+    case OP_COPY_FILTER:  fifo_bp(6); break;
+    case OP_COPY_CLEAR:   fifo_bp(3); break;
+    case OP_FIELD_MODE:   fifo_bp(2); break;
+    case OP_PIXEL_FMT:    fifo_bp(2); break;
+
+    case OP_COPY_DISP:
+        fifo_bp(n > 1 && v[1] ? 7 : 4);
+        texels_frame();
+        stats.frames++;
+        break;
+
+    case OP_DRAW_DONE:    fifo_bp(2); break;
+
+    case OP_Z_MODE:
+    case OP_BLEND_MODE:
+    case OP_ALPHA_UPDATE:
+    case OP_COLOR_UPDATE:
+    case OP_POINT_SIZE:
+        fifo_bp(1);
+        break;
+
+    case OP_CULL_MODE:
+    case OP_NUM_TEV_STAGES:
+        dirty |= DIRTY_GENMODE;
+        break;
+
+    case OP_CLEAR_VTX_DESC:
+    case OP_VTX_DESC:
+        dirty |= DIRTY_VCD;
+        break;
+
+    case OP_VTX_ATTR_FMT:
+        if (n > 0) dirty_vat |= 1u << (v[0] & 7);
+        break;
+
+    case OP_ARRAY:        fifo_cp(2); break;
+    case OP_INV_VTX_CACHE: fifo_raw(1); break;
+
+    case OP_NUM_CHANS:
+        dirty |= DIRTY_GENMODE | DIRTY_NUMCHANS;
+        break;
+
+    case OP_NUM_TEX_GENS:
+        dirty |= DIRTY_GENMODE | DIRTY_NUMTEX;
+        break;
+
+    case OP_CHAN_CTRL:
+        if (n > 0) dirty_chan |= chan_bits(v[0]);
+        break;
+
+    case OP_CHAN_AMB:
+        if (n > 0) dirty_amb |= 1u << (v[0] & 1);
+        break;
+
+    case OP_CHAN_MAT:
+        if (n > 0) dirty_mat |= 1u << (v[0] & 1);
+        break;
+
+    case OP_TEX_COORD_GEN:
+        if (n > 0) dirty_texgen |= 1u << (v[0] & 7);
+        break;
+
+    case OP_TEV_ORDER:
+        if (n > 0) dirty_order |= 1u << ((v[0] & 15) / 2);
+        break;
+
+    case OP_TEV_COLOR_IN:
+    case OP_TEV_ALPHA_IN:
+    case OP_TEV_COLOR_OP:
+    case OP_TEV_ALPHA_OP:
+        fifo_bp(1);
+        break;
+
+    case OP_TEV_COLOR:    fifo_bp(4); break;
+
+    case OP_POS_MTX:
+    case OP_NRM_MTX:
+    case OP_PROJ_MTX:
+        fifo_xf(n - 1);
+        stats.mtx++;
+        break;
+
+    case OP_TEX_MTX:
+        fifo_xf(n - 2);
+        stats.mtx++;
+        break;
+
+    case OP_TEX_OBJ:
+        fifo_bp(6);
+        if (n > 0) dirty_size |= 1u << (v[0] & 7);
+        stats.tex++;
+        break;
+
+    case OP_INV_TEX_ALL:  fifo_bp(2); break;
+    case OP_LIGHT_OBJ:    fifo_xf(16); break;
+
+    case OP_BEGIN:
+        dirty_flush();
+        fifo_raw(3);
+
+        if (dl.on)
+        {
+            dl.draws++;
+            if (n > 2) dl.verts += v[2];
+        }
+        else
+        {
+            stats.draws++;
+            if (n > 2) stats.verts += v[2];
+        }
+        break;
+
+    case OP_VTX:
+        if (n > 0)
+        {
+            fifo_raw(v[0]);
+
+            if (!dl.on)
+                stats.vtx += v[0];
+        }
+        break;
+
+    /* libogc flushes dirty state before a display list is begun or called. */
+
+    case OP_BEGIN_DL:
+        dirty_flush();
+
+        dl.on    = 1;
+        dl.max   = (n > 1) ? v[1] : 0;
+        dl.size  = 0;
+        dl.draws = 0;
+        dl.verts = 0;
+        break;
+
+    case OP_END_DL:
+        dl.on   = 0;
+        dl.size = (dl.size + 31) & ~31u;
+
+        if (dl.size > dl.max)
+            dl.size = 0;
+        break;
+
+    case OP_CALL_DL:
+        dirty_flush();
+        fifo_raw(9);
+
+        stats.dl++;
+
+        if (n > 3)
+        {
+            stats.dl_bytes += v[1];
+            stats.draws    += v[2];
+            stats.verts    += v[3];
+        }
+        break;
+
+    case OP_TEXELS:
+        if (n > 3)
+            texels_add(v[0], v[1], v[2], v[3]);
+        break;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static u32 *log_v;
+static int  log_n;
+static int  log_m;
+static int  log_on;
+
+static int log_grow(int n)
+{
+    if (log_n + n > log_m)
+    {
+        int m = log_m ? log_m : 4096;
+        u32 *w;
+
+        while (m < log_n + n)
+            m *= 2;
+
+        if (!(w = realloc(log_v, m * sizeof (u32))))
+            return 0;
+
+        log_v = w;
+        log_m = m;
+    }
+    return 1;
+}
+
+static void gx_cmd(int op, int n, const u32 *v)
+{
+    if (log_on && log_grow(n + 1))
+    {
+        log_v[log_n++] = ((u32) op << 16) | (u32) n;
+
+        if (n > 0)
+            memcpy(log_v + log_n, v, n * sizeof (u32));
+
+        log_n += n;
+    }
+    gx_exec(op, n, v);
+}
+
+#define GX_CMD(op, ...) do {                                    \
+        const u32 v_[] = { __VA_ARGS__ };                       \
+        gx_cmd(op, (int) (sizeof (v_) / sizeof (*v_)), v_);     \
+    } while (0)
+
+static u32 fbits(f32 f)
+{
+    u32 u;
+    memcpy(&u, &f, sizeof (u));
+    return u;
+}
+
+static f32 ffrom(u32 u)
+{
+    f32 f;
+    memcpy(&f, &u, sizeof (f));
+    return f;
+}
+
+static u32 cbits(GXColor c)
+{
+    return ((u32) c.r << 24) | ((u32) c.g << 16) | ((u32) c.b << 8) | c.a;
+}
+
+static u32 tag(const void *p)
+{
+    return (u32) (uintptr_t) p;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void gxhost_get_stats(struct gxhost_stats *s)
+{
+    *s = stats;
+}
+
+void gxhost_reset_stats(void)
+{
+    memset(&stats, 0, sizeof (stats));
+}
+
+void gxhost_log_begin(void)
+{
+    log_n  = 0;
+    log_on = 1;
+
+    /* Open with the pending state, so that replay flushes the same. */
+
+    GX_CMD(OP_STATE, dirty, dirty_chan, dirty_amb, dirty_mat, dirty_texgen,
+           dirty_order, dirty_vat, dirty_size, 0);
+}
+
+void gxhost_log_end(void)
+{
+    log_on = 0;
+}
+
+void gxhost_log_free(void)
+{
+    free(log_v);
+
+    log_v  = NULL;
+    log_n  = 0;
+    log_m  = 0;
+    log_on = 0;
+}
+
+/*
+ * Replay the log from *pos up to and including the next frame end.
+ * Return zero once the log is exhausted.
+ */
+int gxhost_log_replay(int *pos)
+{
+    int on = log_on;
+    int i  = *pos;
+
+    if (i >= log_n)
+        return 0;
+
+    log_on = 0;
+
+    while (i < log_n)
+    {
+        int op = (int) (log_v[i] >> 16);
+        int n  = (int) (log_v[i] & 0xFFFF);
+
+        gx_exec(op, n, log_v + i + 1);
+
+        i += n + 1;
+
+        if (op == OP_COPY_DISP)
+            break;
+    }
+
+    log_on = on;
+    *pos   = i;
+
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#define LOG_MAGIC   0x474C5847          /* "GXLG" */
+#define LOG_VERSION 1
+
+static void put_u32(FILE *fp, u32 u)
+{
+    unsigned char b[4];
+
+    b[0] = (u      ) & 0xFF;
+    b[1] = (u >>  8) & 0xFF;
+    b[2] = (u >> 16) & 0xFF;
+    b[3] = (u >> 24) & 0xFF;
+
+    fwrite(b, 1, 4, fp);
+}
+
+static int get_u32(FILE *fp, u32 *u)
+{
+    unsigned char b[4];
+
+    if (fread(b, 1, 4, fp) != 4)
+        return 0;
+
+    *u = ((u32) b[0]      ) | ((u32) b[1] <<  8) |
+         ((u32) b[2] << 16) | ((u32) b[3] << 24);
+    return 1;
+}
+
+int gxhost_log_save(const char *path)
+{
+    FILE *fp;
+    int i;
+
+    if ((fp = fopen(path, "wb")))
+    {
+        put_u32(fp, LOG_MAGIC);
+        put_u32(fp, LOG_VERSION);
+        put_u32(fp, (u32) log_n);
+
+        for (i = 0; i < log_n; i++)
+            put_u32(fp, log_v[i]);
+
+        return (fclose(fp) == 0);
+    }
+    return 0;
+}
+
+int gxhost_log_load(const char *path)
+{
+    FILE *fp;
+    u32 magic, version, n;
+    int i, ok = 0;
+
+    if (!(fp = fopen(path, "rb")))
+        return 0;
+
+    if (get_u32(fp, &magic)   && magic   == LOG_MAGIC &&
+        get_u32(fp, &version) && version == LOG_VERSION &&
+        get_u32(fp, &n)       && n < 0x10000000)
+    {
+        log_n  = 0;
+        log_on = 0;
+
+        if (log_grow((int) n))
+        {
+            for (i = 0; i < (int) n; i++)
+                if (!get_u32(fp, log_v + i))
+                    break;
+
+            /* Check that the records tile the log. */
+
+            if (i == (int) n)
+            {
+                for (i = 0; i < (int) n; i += (log_v[i] & 0xFFFF) + 1)
+                    if ((log_v[i] >> 16) >= OP_MAX)
+                        break;
+
+                if (i == (int) n)
+                {
+                    log_n = (int) n;
+                    ok    = 1;
+                }
+            }
+        }
+    }
+    fclose(fp);
+
+    return ok;
+}
+
+void gxhost_log_dump(FILE *fp)
+{
+    int frame = 0;
+    int i = 0;
+
+    fprintf(fp, "# frame %d\n", frame);
+
+    while (i < log_n)
+    {
+        int op = (int) (log_v[i] >> 16);
+        int n  = (int) (log_v[i] & 0xFFFF);
+
+        const u32 *v = log_v + i + 1;
+        const char *f = ops[op].fmt;
+        int j;
+
+        fputs(ops[op].name, fp);
+
+        if (op == OP_VTX)
+        {
+            /* Show the payload size, not the payload. */
+
+            if (n > 0)
+                fprintf(fp, " %u bytes", v[0]);
+        }
+        else for (j = 0; j < n; j++)
+        {
+            switch (*f)
+            {
+            case 'x': fprintf(fp, " %08x", v[j]); break;
+            case 'c': fprintf(fp, " #%08x", v[j]); break;
+            case 'f': fprintf(fp, " %g", ffrom(v[j])); break;
+            default:  fprintf(fp, " %u", v[j]); break;
+            }
+            if (f[1])
+                f++;
+        }
+        fputc('\n', fp);
+
+        i += n + 1;
+
+        if (op == OP_COPY_DISP && i < log_n)
+            fprintf(fp, "# frame %d\n", ++frame);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Vertex data goes out between GX_Begin and GX_End as one payload, kept
+ * big-endian as it would be in the FIFO.
+ */
+
+static u8 *vtx_v;
+static int vtx_n;
+static int vtx_m;
+
+static void vtx_put(const u8 *b, int n)
+{
+    if (vtx_n + n > vtx_m)
+    {
+        int m = vtx_m ? vtx_m : 4096;
+        u8 *w;
+
+        while (m < vtx_n + n)
+            m *= 2;
+
+        if (!(w = realloc(vtx_v, m)))
+            return;
+
+        vtx_v = w;
+        vtx_m = m;
+    }
+    memcpy(vtx_v + vtx_n, b, n);
+    vtx_n += n;
+}
+
+static void vtx_u8(u8 u)
+{
+    vtx_put(&u, 1);
+}
+
+static void vtx_u16(u16 u)
+{
+    u8 b[2] = { u >> 8, u & 0xFF };
+    vtx_put(b, 2);
+}
+
+static void vtx_u32(u32 u)
+{
+    u8 b[4] = { u >> 24, (u >> 16) & 0xFF, (u >> 8) & 0xFF, u & 0xFF };
+    vtx_put(b, 4);
+}
+
+static void vtx_f32(f32 f)
+{
+    vtx_u32(fbits(f));
+}
+
+static void vtx_end(void)
+{
+    int w = (vtx_n + 3) / 4;
+    u32 *v;
+
+    if ((v = calloc(w + 1, sizeof (u32))))
+    {
+        int i;
+
+        v[0] = (u32) vtx_n;
+
+        for (i = 0; i < vtx_n; i++)
+            v[1 + i / 4] |= (u32) vtx_v[i] << (24 - 8 * (i % 4));
+
+        gx_cmd(OP_VTX, w + 1, v);
+        free(v);
+    }
+    vtx_n = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Host stand-ins for memory and video.  There is no display. */
+
+void DCStoreRange(void *p, u32 n) {}
+void DCFlushRange(void *p, u32 n) {}
+void DCInvalidateRange(void *p, u32 n) {}
+
+static GXRModeObj mode = {
+    0, 640, 480, 480, 40, 0, 640, 480, 0, 0, 0,
+    {
+        { 6, 6 }, { 6, 6 }, { 6, 6 }, { 6, 6 },
+        { 6, 6 }, { 6, 6 }, { 6, 6 }, { 6, 6 },
+        { 6, 6 }, { 6, 6 }, { 6, 6 }, { 6, 6 }
+    },
+    { 0, 0, 21, 22, 21, 0, 0 }
+};
+
+void VIDEO_Init(void) {}
+
+GXRModeObj *VIDEO_GetPreferredMode(GXRModeObj *m)
+{
+    return m ? m : &mode;
+}
+
+void VIDEO_Configure(GXRModeObj *m) {}
+void VIDEO_SetNextFramebuffer(void *p) {}
+void VIDEO_SetBlack(int b) {}
+void VIDEO_Flush(void) {}
+void VIDEO_WaitVSync(void) {}
+
+void *SYS_AllocateFramebuffer(GXRModeObj *m)
+{
+    return calloc((size_t) m->fbWidth * m->xfbHeight, 2);
+}
+
+/* libogc's register shadow, which share/wiigl.c pokes directly. */
+
+u8 __gxregs[4096] __attribute__((aligned(32)));
+
+/*
+ * What the texel footprint model needs of the GX state.  Only live calls
+ * keep it, as it holds real pointers.
+ */
+
+static struct
+{
+    u8 vcd[GX_VA_MAXATTR];
+    u8 cnt [GX_MAXVTXFMT][GX_VA_MAXATTR];
+    u8 type[GX_MAXVTXFMT][GX_VA_MAXATTR];
+    u8 frac[GX_MAXVTXFMT][GX_VA_MAXATTR];
+
+    const u8 *array[GX_VA_MAXATTR];
+    u8 stride[GX_VA_MAXATTR];
+
+    Mtx   pos;
+    Mtx   tex;
+    Mtx44 proj;
+    f32   view[4];
+    u8    cull;
+
+    u32 texgen_src;
+    u32 texgen_mtx;
+
+    GXTexObj obj;
+    int      obj_on;
+} hw;
+
+/*---------------------------------------------------------------------------*/
+
+void GX_Init(void *fifo, u32 size)
+{
+    memset(&hw, 0, sizeof (hw));
+
+    guMtxIdentity(hw.pos);
+    guMtxIdentity(hw.tex);
+
+    hw.proj[0][0] = hw.proj[1][1] = hw.proj[2][2] = hw.proj[3][3] = 1.0f;
+
+    hw.view[2] = mode.fbWidth;
+    hw.view[3] = mode.efbHeight;
+
+    hw.texgen_src = GX_TG_TEX0;
+    hw.texgen_mtx = GX_IDENTITY;
+
+    GX_CMD(OP_INIT, size);
+}
+
+void GX_DrawDone(void)
+{
+    gx_cmd(OP_DRAW_DONE, 0, NULL);
+}
+
+void GX_Flush(void) {}
+
+f32 GX_GetYScaleFactor(u16 efb, u16 xfb)
+{
+    return (f32) xfb / (f32) efb;
+}
+
+void GX_SetViewport(f32 x, f32 y, f32 w, f32 h, f32 n, f32 f)
+{
+    hw.view[0] = x;
+    hw.view[1] = y;
+    hw.view[2] = w;
+    hw.view[3] = h;
+
+    GX_CMD(OP_VIEWPORT, fbits(x), fbits(y), fbits(w), fbits(h),
+           fbits(n), fbits(f));
+}
+
+void GX_SetScissor(u32 x, u32 y, u32 w, u32 h)
+{
+    GX_CMD(OP_SCISSOR, x, y, w, h);
+}
+
+void GX_SetDispCopySrc(u16 x, u16 y, u16 w, u16 h) {}
+void GX_SetDispCopyDst(u16 w, u16 h) {}
+void GX_SetDispCopyGamma(u8 gamma) {}
+
+u32 GX_SetDispCopyYScale(f32 s)
+{
+    GX_CMD(OP_COPY_YSCALE, fbits(s));
+    return (u32) (mode.efbHeight * s);
+}
+
+void GX_SetCopyFilter(u8 aa, u8 pattern[12][2], u8 vf, u8 vfilter[7])
+{
+    GX_CMD(OP_COPY_FILTER, aa, vf);
+}
+
+void GX_SetCopyClear(GXColor c, u32 z)
+{
+    GX_CMD(OP_COPY_CLEAR, cbits(c), z);
+}
+
+void GX_SetFieldMode(u8 field, u8 half)
+{
+    GX_CMD(OP_FIELD_MODE, field, half);
+}
+
+void GX_SetPixelFmt(u8 pix, u8 z)
+{
+    GX_CMD(OP_PIXEL_FMT, pix, z);
+}
+
+void GX_CopyDisp(void *dst, u8 clear)
+{
+    GX_CMD(OP_COPY_DISP, tag(dst), clear);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void GX_SetZMode(u8 enable, u8 func, u8 update)
+{
+    GX_CMD(OP_Z_MODE, enable, func, update);
+}
+
+void GX_SetBlendMode(u8 type, u8 src, u8 dst, u8 op)
+{
+    GX_CMD(OP_BLEND_MODE, type, src, dst, op);
+}
+
+void GX_SetAlphaUpdate(u8 enable)
+{
+    GX_CMD(OP_ALPHA_UPDATE, enable);
+}
+
+void GX_SetColorUpdate(u8 enable)
+{
+    GX_CMD(OP_COLOR_UPDATE, enable);
+}
+
+void GX_SetCullMode(u8 mode)
+{
+    hw.cull = mode;
+    GX_CMD(OP_CULL_MODE, mode);
+}
+
+void GX_SetPointSize(u8 width, u8 fmt)
+{
+    GX_CMD(OP_POINT_SIZE, width, fmt);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void GX_ClearVtxDesc(void)
+{
+    memset(hw.vcd, 0, sizeof (hw.vcd));
+    gx_cmd(OP_CLEAR_VTX_DESC, 0, NULL);
+}
+
+void GX_SetVtxDesc(u8 attr, u8 type)
+{
+    if (attr < GX_VA_MAXATTR)
+        hw.vcd[attr] = type;
+
+    GX_CMD(OP_VTX_DESC, attr, type);
+}
+
+void GX_SetVtxAttrFmt(u8 fmt, u32 attr, u32 cnt, u32 type, u8 frac)
+{
+    if (fmt < GX_MAXVTXFMT && attr < GX_VA_MAXATTR)
+    {
+        hw.cnt [fmt][attr] = cnt;
+        hw.type[fmt][attr] = type;
+        hw.frac[fmt][attr] = frac;
+    }
+    GX_CMD(OP_VTX_ATTR_FMT, fmt, attr, cnt, type, frac);
+}
+
+void GX_SetArray(u32 attr, void *ptr, u8 stride)
+{
+    if (attr < GX_VA_MAXATTR)
+    {
+        hw.array [attr] = ptr;
+        hw.stride[attr] = stride;
+    }
+    GX_CMD(OP_ARRAY, attr, tag(ptr), stride);
+}
+
+void GX_InvVtxCache(void)
+{
+    gx_cmd(OP_INV_VTX_CACHE, 0, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void GX_SetNumChans(u8 n)
+{
+    GX_CMD(OP_NUM_CHANS, n);
+}
+
+void GX_SetNumTexGens(u32 n)
+{
+    GX_CMD(OP_NUM_TEX_GENS, n);
+}
+
+void GX_SetNumTevStages(u8 n)
+{
+    GX_CMD(OP_NUM_TEV_STAGES, n);
+}
+
+void GX_SetChanCtrl(s32 chan, u8 enable, u8 amb, u8 mat, u8 lights,
+                    u8 diff, u8 attn)
+{
+    GX_CMD(OP_CHAN_CTRL, (u32) chan, enable, amb, mat, lights, diff, attn);
+}
+
+void GX_SetChanAmbColor(s32 chan, GXColor c)
+{
+    GX_CMD(OP_CHAN_AMB, (u32) chan, cbits(c));
+}
+
+void GX_SetChanMatColor(s32 chan, GXColor c)
+{
+    GX_CMD(OP_CHAN_MAT, (u32) chan, cbits(c));
+}
+
+void GX_SetTexCoordGen(u16 coord, u32 type, u32 src, u32 mtx)
+{
+    if (coord == GX_TEXCOORD0)
+    {
+        hw.texgen_src = src;
+        hw.texgen_mtx = mtx;
+    }
+    GX_CMD(OP_TEX_COORD_GEN, coord, type, src, mtx);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void GX_SetTevOrder(u8 stage, u8 coord, u32 map, u8 color)
+{
+    GX_CMD(OP_TEV_ORDER, stage, coord, map, color);
+}
+
+void GX_SetTevColorIn(u8 stage, u8 a, u8 b, u8 c, u8 d)
+{
+    GX_CMD(OP_TEV_COLOR_IN, stage, a, b, c, d);
+}
+
+void GX_SetTevAlphaIn(u8 stage, u8 a, u8 b, u8 c, u8 d)
+{
+    GX_CMD(OP_TEV_ALPHA_IN, stage, a, b, c, d);
+}
+
+void GX_SetTevColorOp(u8 stage, u8 op, u8 bias, u8 scale, u8 clamp, u8 reg)
+{
+    GX_CMD(OP_TEV_COLOR_OP, stage, op, bias, scale, clamp, reg);
+}
+
+void GX_SetTevAlphaOp(u8 stage, u8 op, u8 bias, u8 scale, u8 clamp, u8 reg)
+{
+    GX_CMD(OP_TEV_ALPHA_OP, stage, op, bias, scale, clamp, reg);
+}
+
+void GX_SetTevColor(u8 reg, GXColor c)
+{
+    GX_CMD(OP_TEV_COLOR, reg, cbits(c));
+}
+
+/*---------------------------------------------------------------------------*/
+
+void GX_LoadPosMtxImm(Mtx m, u32 id)
+{
+    u32 v[13];
+    int i;
+
+    v[0] = id;
+
+    for (i = 0; i < 12; i++)
+        v[1 + i] = fbits(m[i / 4][i % 4]);
+
+    if (id == GX_PNMTX0)
+        memcpy(hw.pos, m, sizeof (Mtx));
+
+    gx_cmd(OP_POS_MTX, 13, v);
+}
+
+void GX_LoadNrmMtxImm(Mtx m, u32 id)
+{
+    u32 v[10];
+    int i;
+
+    v[0] = id;
+
+    for (i = 0; i < 9; i++)
+        v[1 + i] = fbits(m[i / 3][i % 3]);
+
+    gx_cmd(OP_NRM_MTX, 10, v);
+}
+
+void GX_LoadTexMtxImm(Mtx m, u32 id, u8 type)
+{
+    u32 v[14];
+    int i, n = (type == GX_MTX2x4) ? 8 : 12;
+
+    v[0] = id;
+    v[1] = type;
+
+    for (i = 0; i < n; i++)
+        v[2 + i] = fbits(m[i / 4][i % 4]);
+
+    if (id == GX_TEXMTX0)
+        memcpy(hw.tex, m, sizeof (f32) * n);
+
+    gx_cmd(OP_TEX_MTX, n + 2, v);
+}
+
+void GX_LoadProjectionMtx(Mtx44 m, u8 type)
+{
+    /* GX takes six values of either kind of projection. */
+
+    memset(hw.proj, 0, sizeof (Mtx44));
+
+    hw.proj[0][0] = m[0][0];
+    hw.proj[1][1] = m[1][1];
+    hw.proj[2][2] = m[2][2];
+    hw.proj[2][3] = m[2][3];
+
+    if (type == GX_PERSPECTIVE)
+    {
+        hw.proj[0][2] = m[0][2];
+        hw.proj[1][2] = m[1][2];
+        hw.proj[3][2] = -1.0f;
+    }
+    else
+    {
+        hw.proj[0][3] = m[0][3];
+        hw.proj[1][3] = m[1][3];
+        hw.proj[3][3] = 1.0f;
+    }
+
+    if (type == GX_PERSPECTIVE)
+        GX_CMD(OP_PROJ_MTX, type,
+               fbits(m[0][0]), fbits(m[0][2]),
+               fbits(m[1][1]), fbits(m[1][2]),
+               fbits(m[2][2]), fbits(m[2][3]));
+    else
+        GX_CMD(OP_PROJ_MTX, type,
+               fbits(m[0][0]), fbits(m[0][3]),
+               fbits(m[1][1]), fbits(m[1][3]),
+               fbits(m[2][2]), fbits(m[2][3]));
+}
+
+/*---------------------------------------------------------------------------*/
+
+void GX_InitTexObj(GXTexObj *obj, void *img, u16 w, u16 h, u8 fmt,
+                   u8 wrap_s, u8 wrap_t, u8 mipmap)
+{
+    memset(obj, 0, sizeof (*obj));
+
+    obj->img      = img;
+    obj->width    = w;
+    obj->height   = h;
+    obj->format   = fmt;
+    obj->wrap_s   = wrap_s;
+    obj->wrap_t   = wrap_t;
+    obj->mipmap   = mipmap;
+    obj->min_filt = mipmap ? GX_LIN_MIP_LIN : GX_LINEAR;
+    obj->mag_filt = GX_LINEAR;
+
+    /* All levels down to 1x1. */
+
+    if (mipmap)
+        for (; w > 1 || h > 1; w >>= 1, h >>= 1)
+            obj->max_lod += 1.0f;
+}
+
+void GX_InitTexObjFilterMode(GXTexObj *obj, u8 min_filt, u8 mag_filt)
+{
+    obj->min_filt = min_filt;
+    obj->mag_filt = mag_filt;
+}
+
+void GX_InitTexObjLOD(GXTexObj *obj, u8 min_filt, u8 mag_filt,
+                      f32 min_lod, f32 max_lod, f32 lod_bias,
+                      u8 bias_clamp, u8 edge_lod, u8 max_aniso)
+{
+    obj->min_filt = min_filt;
+    obj->mag_filt = mag_filt;
+    obj->min_lod  = min_lod;
+    obj->max_lod  = max_lod;
+    obj->lod_bias = lod_bias;
+}
+
+void GX_InitTexObjWrapMode(GXTexObj *obj, u8 wrap_s, u8 wrap_t)
+{
+    obj->wrap_s = wrap_s;
+    obj->wrap_t = wrap_t;
+}
+
+void GX_GetTexObjAll(GXTexObj *obj, void **img, u16 *w, u16 *h, u8 *fmt,
+                     u8 *wrap_s, u8 *wrap_t, u8 *mipmap)
+{
+    *img    = obj->img;
+    *w      = obj->width;
+    *h      = obj->height;
+    *fmt    = obj->format;
+    *wrap_s = obj->wrap_s;
+    *wrap_t = obj->wrap_t;
+    *mipmap = obj->mipmap;
+}
+
+void GX_LoadTexObj(GXTexObj *obj, u8 map)
+{
+    if (map == GX_TEXMAP0)
+    {
+        hw.obj    = *obj;
+        hw.obj_on = 1;
+    }
+    GX_CMD(OP_TEX_OBJ, map, tag(obj->img), obj->width, obj->height,
+           obj->format, obj->wrap_s, obj->wrap_t, obj->mipmap,
+           obj->min_filt, obj->mag_filt);
+}
+
+void GX_InvalidateTexAll(void)
+{
+    gx_cmd(OP_INV_TEX_ALL, 0, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void GX_InitLightPos(GXLightObj *obj, f32 x, f32 y, f32 z)
+{
+    obj->pos[0] = x;
+    obj->pos[1] = y;
+    obj->pos[2] = z;
+}
+
+void GX_InitLightColor(GXLightObj *obj, GXColor c)
+{
+    obj->color = c;
+}
+
+void GX_LoadLightObj(GXLightObj *obj, u8 light)
+{
+    GX_CMD(OP_LIGHT_OBJ, light, cbits(obj->color),
+           fbits(obj->pos[0]), fbits(obj->pos[1]), fbits(obj->pos[2]));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Texel footprint model, see gxhost.h. */
+
+#define FOOT_LEVELS 11                  /* 1024x1024 down to 1x1             */
+#define FOOT_SPLITS 6                   /* Subdivisions of one triangle      */
+
+struct fv
+{
+    f32 c[4];                           /* Clip space position               */
+    f32 t[2];                           /* Level 0 texel coordinates         */
+};
+
+static f32 foot[FOOT_LEVELS];           /* Tiles touched by the draw         */
+
+/* Size of a texture tile and its count of 32-byte lines, by format. */
+
+static int foot_tile(int fmt, int *tw, int *th)
+{
+    switch (fmt)
+    {
+    case GX_TF_I4:
+    case GX_TF_CMPR:   *tw = 8; *th = 8; return 1;
+    case GX_TF_I8:
+    case GX_TF_IA4:    *tw = 8; *th = 4; return 1;
+    case GX_TF_RGBA8:  *tw = 4; *th = 4; return 2;
+    default:           *tw = 4; *th = 4; return 1;
+    }
+}
+
+static u32 foot_level_tiles(const GXTexObj *obj, int l)
+{
+    int tw, th, n = foot_tile(obj->format, &tw, &th);
+    int w = obj->width  >> l;
+    int h = obj->height >> l;
+
+    if (w < 1) w = 1;
+    if (h < 1) h = 1;
+
+    return (u32) (((w + tw - 1) / tw) * ((h + th - 1) / th) * n);
+}
+
+/* Count the tiles of one level under a piece covering p pixels. */
+
+static void foot_level(int l, f32 texels, f32 pixels)
+{
+    int tw, th, n = foot_tile(hw.obj.format, &tw, &th);
+    f32 k = texels / (f32) (1 << (2 * l)) / (tw * th) * n;
+
+    if (l < FOOT_LEVELS)
+        foot[l] += (k < pixels) ? k : pixels;
+}
+
+/* Pick the levels that a piece of texels over pixels samples. */
+
+static void foot_piece(f32 texels, f32 pixels)
+{
+    const GXTexObj *obj = &hw.obj;
+
+    f32 lod;
+    int l;
+
+    if (pixels <= 0.0f || texels <= 0.0f)
+        return;
+
+    if (!obj->mipmap || obj->min_filt < GX_NEAR_MIP_NEAR || texels <= pixels)
+    {
+        foot_level(0, texels, pixels);
+        return;
+    }
+
+    lod = 0.5f * log2f(texels / pixels) + obj->lod_bias;
+
+    if (lod < obj->min_lod) lod = obj->min_lod;
+    if (lod > obj->max_lod) lod = obj->max_lod;
+
+    if (obj->min_filt == GX_NEAR_MIP_NEAR || obj->min_filt == GX_LIN_MIP_NEAR)
+        foot_level((int) (lod + 0.5f), texels, pixels);
+    else
+    {
+        l = (int) lod;
+
+        foot_level(l, texels, pixels);
+
+        if (lod > l)
+            foot_level(l + 1, texels, pixels);
+    }
+}
+
+static void fv_lerp(struct fv *d, const struct fv *a, const struct fv *b,
+                    f32 k)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        d->c[i] = a->c[i] + (b->c[i] - a->c[i]) * k;
+
+    d->t[0] = a->t[0] + (b->t[0] - a->t[0]) * k;
+    d->t[1] = a->t[1] + (b->t[1] - a->t[1]) * k;
+}
+
+/*
+ * Clip a polygon to the side of a plane where x[i] * s + w > e.  Return
+ * the new vertex count.
+ */
+static int fv_clip(struct fv *d, const struct fv *v, int n, int i, f32 s,
+                   f32 e)
+{
+    int j, m = 0;
+
+    for (j = 0; j < n; j++)
+    {
+        const struct fv *a = v + j;
+        const struct fv *b = v + (j + 1) % n;
+
+        const f32 da = a->c[i] * s + a->c[3] - e;
+        const f32 db = b->c[i] * s + b->c[3] - e;
+
+        if (da >= 0.0f)
+            d[m++] = *a;
+
+        if ((da >= 0.0f) != (db >= 0.0f))
+            fv_lerp(d + m++, a, b, da / (da - db));
+    }
+    return m;
+}
+
+/* Twice the signed area of a polygon, in window and texel space. */
+
+static void fv_area(const struct fv *v, int n, f32 *pixels, f32 *texels)
+{
+    f32 x[8], y[8];
+    f32 p = 0.0f, t = 0.0f;
+    int i, j;
+
+    for (i = 0; i < n; i++)
+    {
+        x[i] = (v[i].c[0] / v[i].c[3] + 1.0f) * 0.5f * hw.view[2];
+        y[i] = (v[i].c[1] / v[i].c[3] + 1.0f) * 0.5f * hw.view[3];
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        j = (i + 1) % n;
+
+        p += x[i] * y[j] - x[j] * y[i];
+        t += v[i].t[0] * v[j].t[1] - v[j].t[0] * v[i].t[1];
+    }
+
+    *pixels = p;
+    *texels = t;
+}
+
+/*
+ * Measure a triangle in front of the eye, splitting it where the depth
+ * across it varies by more than half.
+ */
+static void foot_tri(const struct fv *a, const struct fv *b,
+                     const struct fv *c, int splits)
+{
+    f32 lo = a->c[3], hi = a->c[3];
+
+    if (lo > b->c[3]) lo = b->c[3];
+    if (hi < b->c[3]) hi = b->c[3];
+    if (lo > c->c[3]) lo = c->c[3];
+    if (hi < c->c[3]) hi = c->c[3];
+
+    if (splits > 0 && hi > 2.0f * lo)
+    {
+        struct fv ab, bc, ca;
+
+        fv_lerp(&ab, a, b, 0.5f);
+        fv_lerp(&bc, b, c, 0.5f);
+        fv_lerp(&ca, c, a, 0.5f);
+
+        foot_tri(a,   &ab, &ca, splits - 1);
+        foot_tri(&ab, b,   &bc, splits - 1);
+        foot_tri(&ca, &bc, c,   splits - 1);
+        foot_tri(&ab, &bc, &ca, splits - 1);
+    }
+    else
+    {
+        struct fv v[8], u[8];
+        f32 pixels, texels;
+        int n = 3;
+
+        v[0] = *a;
+        v[1] = *b;
+        v[2] = *c;
+
+        /* Clip to the sides of the view volume. */
+
+        n = fv_clip(u, v, n, 0, -1.0f, 0.0f);
+        n = fv_clip(v, u, n, 0, +1.0f, 0.0f);
+        n = fv_clip(u, v, n, 1, -1.0f, 0.0f);
+        n = fv_clip(v, u, n, 1, +1.0f, 0.0f);
+
+        if (n >= 3)
+        {
+            fv_area(v, n, &pixels, &texels);
+            foot_piece(0.5f * fabsf(texels), 0.5f * fabsf(pixels));
+        }
+    }
+}
+
+/*
+ * Clip a triangle to the eye, cull it as GX would and measure what
+ * remains.  GX culls by window winding, which for a GL projection is
+ * the reverse of the GL winding that wiigl's cull modes are set for.
+ */
+static void foot_face(const struct fv *a, const struct fv *b,
+                      const struct fv *c)
+{
+    struct fv v[4], u[4];
+    f32 pixels, texels;
+    int i, n;
+
+    v[0] = *a;
+    v[1] = *b;
+    v[2] = *c;
+
+    if ((n = fv_clip(u, v, 3, 3, 0.0f, 1e-4f)) < 3)
+        return;
+
+    fv_area(u, n, &pixels, &texels);
+
+    if ((hw.cull == GX_CULL_ALL) ||
+        (hw.cull == GX_CULL_FRONT && pixels < 0.0f) ||
+        (hw.cull == GX_CULL_BACK  && pixels > 0.0f))
+        return;
+
+    for (i = 2; i < n; i++)
+        foot_tri(u, u + i - 1, u + i, FOOT_SPLITS);
+}
+
+/* Read attribute component i of type t, big-endian or in host order. */
+
+static f32 foot_comp(const u8 *p, int t, int frac, int i, int be)
+{
+    const int k = (t == GX_U8 || t == GX_S8) ? 1 : (t == GX_F32) ? 4 : 2;
+
+    union { u32 u; f32 f; } v;
+    u8  b8;
+    u16 b16;
+    int j;
+
+    p += i * k;
+
+    if (be)
+        for (v.u = 0, j = 0; j < k; j++)
+            v.u = (v.u << 8) | p[j];
+    else if (k == 1)
+        v.u = (memcpy(&b8,  p, 1), b8);
+    else if (k == 2)
+        v.u = (memcpy(&b16, p, 2), b16);
+    else
+        memcpy(&v.u, p, 4);
+
+    switch (t)
+    {
+    case GX_U8:  return ldexpf((f32) (u8)  v.u, -frac);
+    case GX_S8:  return ldexpf((f32) (s8)  v.u, -frac);
+    case GX_U16: return ldexpf((f32) (u16) v.u, -frac);
+    case GX_S16: return ldexpf((f32) (s16) v.u, -frac);
+    case GX_F32: return v.f;
+    }
+    return 0.0f;
+}
+
+static int foot_size(int fmt, int attr)
+{
+    const int c = hw.cnt [fmt][attr];
+    const int t = hw.type[fmt][attr];
+    const int k = (t == GX_U8 || t == GX_S8) ? 1 : (t == GX_F32) ? 4 : 2;
+
+    if (attr < GX_VA_POS)
+        return 1;
+
+    switch (attr)
+    {
+    case GX_VA_POS:  return (c == GX_POS_XYZ ? 3 : 2) * k;
+    case GX_VA_NRM:  return 3 * k;
+
+    case GX_VA_CLR0:
+    case GX_VA_CLR1:
+        switch (t)
+        {
+        case GX_RGB565:
+        case GX_RGBA4:  return 2;
+        case GX_RGB8:
+        case GX_RGBA6:  return 3;
+        default:        return 4;
+        }
+    }
+    return (c == GX_TEX_ST ? 2 : 1) * k;
+}
+
+/*
+ * Decode the vertices of one draw from its FIFO bytes and measure its
+ * triangles.  Points and lines are not counted.
+ */
+static void foot_draw(int prim, int fmt, int count, const u8 *p, int len)
+{
+    const u8 *end = p + len;
+
+    struct fv *v;
+    int i, a;
+
+    if (!hw.obj_on || fmt >= GX_MAXVTXFMT || hw.vcd[GX_VA_TEX0] == GX_NONE ||
+        (hw.texgen_src != GX_TG_TEX0 && hw.texgen_src != GX_TG_TEXCOORD0))
+        return;
+
+    if (prim != GX_TRIANGLES && prim != GX_TRIANGLESTRIP &&
+        prim != GX_TRIANGLEFAN && prim != GX_QUADS)
+        return;
+
+    if (!(v = calloc(count, sizeof (*v))))
+        return;
+
+    for (i = 0; i < count; i++)
+    {
+        f32 x[3] = { 0.0f, 0.0f, 0.0f };
+        f32 t[2] = { 0.0f, 0.0f };
+        f32 e[3];
+        int j;
+
+        for (a = 0; a < GX_VA_MAXATTR; a++)
+        {
+            const int n = foot_size(fmt, a);
+            const u8 *q;
+            int be = 0;
+
+            switch (hw.vcd[a])
+            {
+            case GX_NONE:
+                continue;
+
+            case GX_DIRECT:
+                q  = p;
+                p += n;
+                be = 1;
+                break;
+
+            case GX_INDEX8:
+                q  = hw.array[a] + p[0] * hw.stride[a];
+                p += 1;
+                break;
+
+            default:
+                q  = hw.array[a] + ((p[0] << 8) | p[1]) * hw.stride[a];
+                p += 2;
+                break;
+            }
+
+            if (p > end || (!be && !hw.array[a]))
+                goto done;
+
+            if (a == GX_VA_POS)
+                for (j = 0; j < (hw.cnt[fmt][a] == GX_POS_XYZ ? 3 : 2); j++)
+                    x[j] = foot_comp(q, hw.type[fmt][a], hw.frac[fmt][a], j,
+                                     be);
+
+            if (a == GX_VA_TEX0)
+                for (j = 0; j < (hw.cnt[fmt][a] == GX_TEX_ST ? 2 : 1); j++)
+                    t[j] = foot_comp(q, hw.type[fmt][a], hw.frac[fmt][a], j,
+                                     be);
+        }
+
+        /* Eye, then clip space. */
+
+        for (j = 0; j < 3; j++)
+            e[j] = hw.pos[j][0] * x[0] + hw.pos[j][1] * x[1] +
+                   hw.pos[j][2] * x[2] + hw.pos[j][3];
+
+        for (j = 0; j < 4; j++)
+            v[i].c[j] = hw.proj[j][0] * e[0] + hw.proj[j][1] * e[1] +
+                        hw.proj[j][2] * e[2] + hw.proj[j][3];
+
+        if (hw.texgen_mtx == GX_TEXMTX0)
+        {
+            f32 s = t[0];
+
+            t[0] = hw.tex[0][0] * s + hw.tex[0][1] * t[1] +
+                   hw.tex[0][2] + hw.tex[0][3];
+            t[1] = hw.tex[1][0] * s + hw.tex[1][1] * t[1] +
+                   hw.tex[1][2] + hw.tex[1][3];
+        }
+
+        v[i].t[0] = t[0] * hw.obj.width;
+        v[i].t[1] = t[1] * hw.obj.height;
+    }
+
+    switch (prim)
+    {
+    case GX_TRIANGLES:
+        for (i = 2; i < count; i += 3)
+            foot_face(v + i - 2, v + i - 1, v + i);
+        break;
+
+    case GX_TRIANGLESTRIP:
+        for (i = 2; i < count; i++)
+            if (i & 1)
+                foot_face(v + i - 1, v + i - 2, v + i);
+            else
+                foot_face(v + i - 2, v + i - 1, v + i);
+        break;
+
+    case GX_TRIANGLEFAN:
+        for (i = 2; i < count; i++)
+            foot_face(v, v + i - 1, v + i);
+        break;
+
+    case GX_QUADS:
+        for (i = 3; i < count; i += 4)
+        {
+            foot_face(v + i - 3, v + i - 2, v + i - 1);
+            foot_face(v + i - 3, v + i - 1, v + i);
+        }
+        break;
+    }
+
+done:
+    free(v);
+}
+
+/* Log the tiles counted since the last call. */
+
+static void foot_flush(void)
+{
+    int l;
+
+    for (l = 0; l < FOOT_LEVELS; l++)
+        if (foot[l] > 0.0f)
+        {
+            GX_CMD(OP_TEXELS, tag(hw.obj.img), l, (u32) ceilf(foot[l]),
+                   foot_level_tiles(&hw.obj, l));
+            foot[l] = 0.0f;
+        }
+}
+
+/*
+ * Draws built into a display list, kept so that they can be measured
+ * each time the list is called.  Each is a header of primitive, format,
+ * vertex count and byte count, then the bytes.
+ */
+
+static u8 *dlist_draw_v;
+static u32 dlist_draw_n;
+static u32 dlist_draw_m;
+
+static void dlist_draw_put(const void *b, u32 n)
+{
+    if (dlist_draw_n + n > dlist_draw_m)
+    {
+        u32 m = dlist_draw_m ? dlist_draw_m : 4096;
+        u8 *w;
+
+        while (m < dlist_draw_n + n)
+            m *= 2;
+
+        if (!(w = realloc(dlist_draw_v, m)))
+            return;
+
+        dlist_draw_v = w;
+        dlist_draw_m = m;
+    }
+    memcpy(dlist_draw_v + dlist_draw_n, b, n);
+    dlist_draw_n += n;
+}
+
+static void foot_list(const u8 *p, u32 n)
+{
+    const u8 *end = p + n;
+    u32 h[4];
+
+    while (p + sizeof (h) <= end)
+    {
+        memcpy(h, p, sizeof (h));
+        p += sizeof (h);
+
+        if (p + h[3] > end)
+            break;
+
+        foot_draw(h[0], h[1], h[2], p, h[3]);
+        p += h[3];
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static u32 begin_prim;
+static u32 begin_fmt;
+static u32 begin_count;
+
+void GX_Begin(u8 prim, u8 fmt, u16 count)
+{
+    vtx_n = 0;
+
+    begin_prim  = prim;
+    begin_fmt   = fmt;
+    begin_count = count;
+
+    GX_CMD(OP_BEGIN, prim, fmt, count);
+}
+
+void GX_End(void)
+{
+    if (dl.on)
+    {
+        const u32 h[4] = { begin_prim, begin_fmt, begin_count, vtx_n };
+
+        dlist_draw_put(h, sizeof (h));
+        dlist_draw_put(vtx_v, vtx_n);
+    }
+    else
+    {
+        foot_draw(begin_prim, begin_fmt, begin_count, vtx_v, vtx_n);
+        foot_flush();
+    }
+
+    vtx_end();
+    gx_cmd(OP_END, 0, NULL);
+}
+
+/*
+ * Built display lists, by tag, so that a call can be costed as the list
+ * it replays.
+ */
+
+struct dlist
+{
+    u32 tag;
+    u32 size;
+    u32 draws;
+    u32 verts;
+
+    u8 *draw;                           /* Draws, as kept by GX_End          */
+    u32 draw_n;
+};
+
+static struct dlist *dlist_v;
+static u32           dlist_n;
+static u32           dlist_m;
+
+static struct dlist *dlist_find(u32 t)
+{
+    u32 i;
+
+    if (dlist_m == 0)
+        return NULL;
+
+    for (i = (t >> 5) & (dlist_m - 1); dlist_v[i].tag;
+         i = (i + 1) & (dlist_m - 1))
+        if (dlist_v[i].tag == t)
+            return dlist_v + i;
+
+    return dlist_v + i;
+}
+
+static void dlist_note(u32 t, u32 size, u32 draws, u32 verts,
+                       const u8 *draw, u32 draw_n)
+{
+    struct dlist *p;
+
+    /* Keep the table at most half full. */
+
+    if (2 * (dlist_n + 1) > dlist_m)
+    {
+        struct dlist *v = dlist_v;
+        u32 m = dlist_m, i;
+
+        dlist_m = m ? m * 2 : 256;
+
+        if (!(dlist_v = calloc(dlist_m, sizeof (*dlist_v))))
+        {
+            dlist_v = v;
+            dlist_m = m;
+            return;
+        }
+
+        for (i = 0; i < m; i++)
+            if (v[i].tag)
+                *dlist_find(v[i].tag) = v[i];
+
+        free(v);
+    }
+
+    p = dlist_find(t);
+
+    if (p->tag == 0)
+        dlist_n++;
+
+    free(p->draw);
+
+    p->tag   = t;
+    p->size  = size;
+    p->draws = draws;
+    p->verts = verts;
+
+    if ((p->draw = malloc(draw_n ? draw_n : 1)))
+    {
+        memcpy(p->draw, draw, draw_n);
+        p->draw_n = draw_n;
+    }
+    else
+        p->draw_n = 0;
+}
+
+static void *dlist_ptr;
+
+void GX_BeginDispList(void *list, u32 size)
+{
+    dlist_ptr    = list;
+    dlist_draw_n = 0;
+    GX_CMD(OP_BEGIN_DL, tag(list), size);
+}
+
+u32 GX_EndDispList(void)
+{
+    gx_cmd(OP_END_DL, 0, NULL);
+
+    if (dl.size)
+        dlist_note(tag(dlist_ptr), dl.size, dl.draws, dl.verts,
+                   dlist_draw_v, dlist_draw_n);
+
+    return dl.size;
+}
+
+void GX_CallDispList(void *list, u32 size)
+{
+    struct dlist *p = dlist_find(tag(list));
+
+    if (p && p->tag)
+    {
+        GX_CMD(OP_CALL_DL, tag(list), size, p->draws, p->verts);
+
+        foot_list(p->draw, p->draw_n);
+        foot_flush();
+    }
+    else
+        GX_CMD(OP_CALL_DL, tag(list), size, 0, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void GX_Position1x16(u16 i)  { vtx_u16(i); }
+void GX_Position1x8(u8 i)    { vtx_u8(i);  }
+void GX_Normal1x16(u16 i)    { vtx_u16(i); }
+void GX_Normal1x8(u8 i)      { vtx_u8(i);  }
+void GX_Color1x16(u16 i)     { vtx_u16(i); }
+void GX_Color1x8(u8 i)       { vtx_u8(i);  }
+void GX_Color1u32(u32 c)     { vtx_u32(c); }
+void GX_TexCoord1x16(u16 i)  { vtx_u16(i); }
+void GX_TexCoord1x8(u8 i)    { vtx_u8(i);  }
+
+void GX_Position3f32(f32 x, f32 y, f32 z)
+{
+    vtx_f32(x);
+    vtx_f32(y);
+    vtx_f32(z);
+}
+
+void GX_Normal3f32(f32 x, f32 y, f32 z)
+{
+    vtx_f32(x);
+    vtx_f32(y);
+    vtx_f32(z);
+}
+
+void GX_Color4u8(u8 r, u8 g, u8 b, u8 a)
+{
+    u8 c[4] = { r, g, b, a };
+    vtx_put(c, 4);
+}
+
+void GX_TexCoord2f32(f32 s, f32 t)
+{
+    vtx_f32(s);
+    vtx_f32(t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* GU matrix routines, after libogc's C versions. */
+
+void guMtxIdentity(Mtx m)
+{
+    int i, j;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 4; j++)
+            m[i][j] = (i == j) ? 1.0f : 0.0f;
+}
+
+void guMtxCopy(Mtx src, Mtx dst)
+{
+    if (src != dst)
+        memcpy(dst, src, sizeof (Mtx));
+}
+
+void guMtxConcat(Mtx a, Mtx b, Mtx ab)
+{
+    Mtx t;
+    int i, j;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 4; j++)
+            t[i][j] = a[i][0] * b[0][j] +
+                      a[i][1] * b[1][j] +
+                      a[i][2] * b[2][j] + (j == 3 ? a[i][3] : 0.0f);
+
+    memcpy(ab, t, sizeof (Mtx));
+}
+
+u32 guMtxInverse(Mtx src, Mtx inv)
+{
+    Mtx t;
+    f32 d;
+
+    d = src[0][0] * src[1][1] * src[2][2] +
+        src[0][1] * src[1][2] * src[2][0] +
+        src[0][2] * src[1][0] * src[2][1] -
+        src[2][0] * src[1][1] * src[0][2] -
+        src[1][0] * src[0][1] * src[2][2] -
+        src[0][0] * src[2][1] * src[1][2];
+
+    if (d == 0.0f)
+        return 0;
+
+    d = 1.0f / d;
+
+    t[0][0] =  (src[1][1] * src[2][2] - src[2][1] * src[1][2]) * d;
+    t[0][1] = -(src[0][1] * src[2][2] - src[2][1] * src[0][2]) * d;
+    t[0][2] =  (src[0][1] * src[1][2] - src[1][1] * src[0][2]) * d;
+
+    t[1][0] = -(src[1][0] * src[2][2] - src[2][0] * src[1][2]) * d;
+    t[1][1] =  (src[0][0] * src[2][2] - src[2][0] * src[0][2]) * d;
+    t[1][2] = -(src[0][0] * src[1][2] - src[1][0] * src[0][2]) * d;
+
+    t[2][0] =  (src[1][0] * src[2][1] - src[2][0] * src[1][1]) * d;
+    t[2][1] = -(src[0][0] * src[2][1] - src[2][0] * src[0][1]) * d;
+    t[2][2] =  (src[0][0] * src[1][1] - src[1][0] * src[0][1]) * d;
+
+    t[0][3] = -t[0][0] * src[0][3] - t[0][1] * src[1][3] - t[0][2] * src[2][3];
+    t[1][3] = -t[1][0] * src[0][3] - t[1][1] * src[1][3] - t[1][2] * src[2][3];
+    t[2][3] = -t[2][0] * src[0][3] - t[2][1] * src[1][3] - t[2][2] * src[2][3];
+
+    memcpy(inv, t, sizeof (Mtx));
+
+    return 1;
+}
+
+u32 guMtxInvXpose(Mtx src, Mtx xpose)
+{
+    Mtx t;
+    int i, j;
+
+    if (!guMtxInverse(src, t))
+        return 0;
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+            xpose[i][j] = t[j][i];
+
+        xpose[i][3] = 0.0f;
+    }
+    return 1;
+}
+
+void guMtxApplyTrans(Mtx src, Mtx dst, f32 x, f32 y, f32 z)
+{
+    if (src != dst)
+        memcpy(dst, src, sizeof (Mtx));
+
+    dst[0][3] = src[0][3] + x;
+    dst[1][3] = src[1][3] + y;
+    dst[2][3] = src[2][3] + z;
+}
+
+void guMtxApplyScale(Mtx src, Mtx dst, f32 x, f32 y, f32 z)
+{
+    int j;
+
+    for (j = 0; j < 4; j++)
+    {
+        dst[0][j] = src[0][j] * x;
+        dst[1][j] = src[1][j] * y;
+        dst[2][j] = src[2][j] * z;
+    }
+}
+
+void guVecNormalize(guVector *v)
+{
+    f32 k = sqrtf(v->x * v->x + v->y * v->y + v->z * v->z);
+
+    if (k > 0.0f)
+    {
+        v->x /= k;
+        v->y /= k;
+        v->z /= k;
+    }
+}
+
+void guVecMultiply(Mtx m, guVector *src, guVector *dst)
+{
+    guVector t;
+
+    t.x = m[0][0] * src->x + m[0][1] * src->y + m[0][2] * src->z + m[0][3];
+    t.y = m[1][0] * src->x + m[1][1] * src->y + m[1][2] * src->z + m[1][3];
+    t.z = m[2][0] * src->x + m[2][1] * src->y + m[2][2] * src->z + m[2][3];
+
+    *dst = t;
+}
+
+void guFrustum(Mtx44 m, f32 t, f32 b, f32 l, f32 r, f32 n, f32 f)
+{
+    memset(m, 0, sizeof (Mtx44));
+
+    m[0][0] = (2.0f * n) / (r - l);
+    m[0][2] = (r + l) / (r - l);
+    m[1][1] = (2.0f * n) / (t - b);
+    m[1][2] = (t + b) / (t - b);
+    m[2][2] = -n / (f - n);
+    m[2][3] = -(f * n) / (f - n);
+    m[3][2] = -1.0f;
+}
+
+void guOrtho(Mtx44 m, f32 t, f32 b, f32 l, f32 r, f32 n, f32 f)
+{
+    memset(m, 0, sizeof (Mtx44));
+
+    m[0][0] =  2.0f / (r - l);
+    m[0][3] = -(r + l) / (r - l);
+    m[1][1] =  2.0f / (t - b);
+    m[1][3] = -(t + b) / (t - b);
+    m[2][2] = -1.0f / (f - n);
+    m[2][3] = -f / (f - n);
+    m[3][3] =  1.0f;
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+#ifndef GXHOST_H
+#define GXHOST_H
+
+#include <stdio.h>
+
+/*
+ * Host GX recorder.
+ *
+ * Every GX call that would reach the GPU FIFO is costed against a model
+ * of what libogc writes for it: 5 bytes per BP register write, 6 per CP
+ * register write, 5 + 4n per XF block of n words, 3 per GX_Begin and the
+ * vertex data itself.  As in libogc, most vertex, channel, texgen and
+ * TEV order state is only marked dirty when set and written out by the
+ * next GX_Begin.  A frame ends with GX_CopyDisp.
+ *
+ * Commands issued between GX_BeginDispList and GX_EndDispList go into
+ * the display list instead.  GX_CallDispList costs 9 FIFO bytes, and the
+ * list's own bytes, draws and vertices are counted when it is called.
+ *
+ * Texture sampling on map 0 is modelled too, for live draws and for the
+ * draws of called display lists, with the state at the call.  Each
+ * triangle is transformed and clipped as GX would, split where its depth
+ * varies much, and given one LOD from the ratio of the texels to the
+ * pixels it covers.  At each level it samples, it touches one 32-byte
+ * texture tile per pixel, but no more than the tiles it covers.  A
+ * frame's footprint is the sum over texture levels of the tiles touched,
+ * each capped at the level's size: the bytes the frame needs from the
+ * texture cache.  Draws log what they touch, so replay counts the same.
+ *
+ * Calls may also be recorded into a command log, which can be saved,
+ * loaded, dumped as text and replayed through the same cost model.
+ * Pointers are recorded as 32-bit tags and never followed on replay.
+ */
+
+/*---------------------------------------------------------------------------*/
+
+struct gxhost_stats
+{
+    unsigned long fifo;                 /* Bytes pushed into the FIFO        */
+    unsigned long vtx;                  /* ...of which vertex data           */
+
+    unsigned long bp;                   /* BP register writes                */
+    unsigned long cp;                   /* CP register writes                */
+    unsigned long xf;                   /* XF register blocks                */
+
+    unsigned long state;                /* State-setting GX calls            */
+    unsigned long draws;                /* Primitives drawn                  */
+    unsigned long verts;                /* Vertices drawn                    */
+    unsigned long dl;                   /* Display list calls                */
+    unsigned long dl_bytes;             /* Bytes fetched from display lists  */
+    unsigned long mtx;                  /* Matrix loads                      */
+    unsigned long tex;                  /* Texture object loads              */
+    unsigned long tex_bytes;            /* Texel cache footprint, see above  */
+    unsigned long tex_peak;             /* ...largest in one frame           */
+    unsigned long frames;               /* GX_CopyDisp calls                 */
+};
+
+void gxhost_get_stats(struct gxhost_stats *);
+void gxhost_reset_stats(void);
+
+/*---------------------------------------------------------------------------*/
+
+void gxhost_log_begin(void);
+void gxhost_log_end(void);
+void gxhost_log_free(void);
+
+int  gxhost_log_save(const char *);
+int  gxhost_log_load(const char *);
+int  gxhost_log_replay(int *);
+void gxhost_log_dump(FILE *);
+
+/*---------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef GXHOST_LWP_WATCHDOG_H
+#define GXHOST_LWP_WATCHDOG_H
+
+/* Host stand-in for libogc's tick timer header.  Nothing here is used. */
+
+#include "gccore.h"
+
+#endif
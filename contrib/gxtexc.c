@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+/*
+ * gxtexc: texture compiler.
+ *
+ * Tiles each given image for GX and writes it next to the image, as in
+ * "textures/foo.png.gxt", where make_image_from_file finds it and
+ * uploads it without converting it.  Gray images become I8, gray with
+ * alpha IA8, color with alpha RGB5A3, and opaque color CMPR, or RGB565
+ * with --no-cmpr.  With --mipmap, images with sides that are powers of
+ * two get box-filtered levels down to 1x1.  Image paths are relative to
+ * the data directory.
+ *
+ *     gxtexc [--no-cmpr] [--mipmap] <data-dir> <image>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "base_image.h"
+#include "common.h"
+#include "gxtex.h"
+#include "fs.h"
+
+/*---------------------------------------------------------------------------*/
+
+static const char *fmt_name(int fmt)
+{
+    switch (fmt)
+    {
+    case GXTEX_I8:     return "I8";
+    case GXTEX_IA8:    return "IA8";
+    case GXTEX_RGB565: return "RGB565";
+    case GXTEX_RGB5A3: return "RGB5A3";
+    case GXTEX_CMPR:   return "CMPR";
+    }
+    return "?";
+}
+
+static int compile(const char *name, int cmpr, int mips, long *in, long *out)
+{
+    void *p, *q;
+    int w, h, b, f, l, n;
+    int rc = 0;
+
+    if (!(p = image_load(name, &w, &h, &b)))
+    {
+        fprintf(stderr, "%s: failed to load image\n", name);
+        return 0;
+    }
+
+    f = gxtex_pick(p, w, h, b, cmpr);
+    l = mips ? gxtex_lods(w, h) : 1;
+    n = gxtex_mip_size(f, w, h, l);
+
+    if ((q = malloc(n)))
+    {
+        char *path = concat_string(name, GXTEX_EXT, NULL);
+
+        if (gxtex_tile_mips(q, f, p, w, h, b, l) && path &&
+            gxtex_save(path, f, w, h, l, q))
+        {
+            printf("%s %dx%d %s %d %d\n", path, w, h, fmt_name(f), l, n);
+
+            *in  += (long) w * h * b;
+            *out += n;
+            rc = 1;
+        }
+        else
+            fprintf(stderr, "%s: failed to write image\n", name);
+
+        free(path);
+        free(q);
+    }
+    free(p);
+
+    return rc;
+}
+
+int main(int argc, char *argv[])
+{
+    long in  = 0;
+    long out = 0;
+
+    int cmpr = 1;
+    int mips = 0;
+    int argi;
+    int rc = 0;
+
+    for (argi = 1; argi < argc && argv[argi][0] == '-'; argi++)
+    {
+        if      (strcmp(argv[argi], "--no-cmpr") == 0)
+            cmpr = 0;
+        else if (strcmp(argv[argi], "--mipmap") == 0)
+            mips = 1;
+        else
+            break;
+    }
+
+    if (argc - argi < 2)
+    {
+        fprintf(stderr, "Usage: %s [--no-cmpr] [--mipmap] <data> <image>...\n",
+                argv[0]);
+        return 1;
+    }
+
+    if (!fs_init(argv[0]))
+    {
+        fprintf(stderr, "Failure to initialize virtual file system: %s\n",
+                fs_error());
+        return 1;
+    }
+
+    fs_add_path(argv[argi]);
+    fs_set_write_dir(argv[argi]);
+
+    for (argi++; argi < argc; argi++)
+        if (!compile(argv[argi], cmpr, mips, &in, &out))
+            rc = 1;
+
+    if (out)
+        printf("%ld bytes of pixels, %ld bytes tiled\n", in, out);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
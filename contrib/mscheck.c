@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+/*
+ * mscheck: regression test for the millisecond accumulator.
+ *
+ * Replays depend on ms_step rounding exactly as the loop it replaced,
+ * which subtracted one 0.001f tick at a time.  This runs both over a
+ * sweep of step lengths from an empty accumulator, over the floats at
+ * the edges of each binade the accumulator passes through, and over
+ * long runs of steps that carry the accumulator from one to the next.
+ * It stops at the first step where the millisecond counts or the bits
+ * of the accumulators differ, and exits non-zero.
+ *
+ *     mscheck [--seed N]
+ *
+ * ms_step is static, so share/solid_sim_sol.c is included here rather
+ * than linked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solid_sim_sol.c"
+
+/*---------------------------------------------------------------------------*/
+
+/* The loop ms_step replaced. */
+
+static int ref_step(float *accum, float dt)
+{
+    int ms = 0;
+
+    *accum += dt;
+
+    while (*accum >= 0.001f)
+    {
+        *accum -= 0.001f;
+        ms += 1;
+    }
+
+    return ms;
+}
+
+static unsigned int float_bits(float f)
+{
+    union { float f; unsigned int i; } u;
+
+    u.f = f;
+    return u.i;
+}
+
+static float bits_float(unsigned int i)
+{
+    union { float f; unsigned int i; } u;
+
+    u.i = i;
+    return u.f;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static unsigned long checks;
+
+/*
+ * Step from ACCUM by DT both ways.  Return 1 and advance ACCUM if they
+ * agree, else print both results and return 0.
+ */
+static int check(const char *what, float *accum, float dt)
+{
+    float a = *accum;
+    float b = *accum;
+
+    int m = ms_step (&a, dt);
+    int n = ref_step(&b, dt);
+
+    checks++;
+
+    if (m != n || float_bits(a) != float_bits(b))
+    {
+        printf("%s: accum %.9g (0x%08x) dt %.9g (0x%08x)\n"
+               "    ms_step  %d ms, accum 0x%08x\n"
+               "    ref_step %d ms, accum 0x%08x\n", what,
+               *accum, float_bits(*accum), dt, float_bits(dt),
+               m, float_bits(a), n, float_bits(b));
+        return 0;
+    }
+
+    *accum = a;
+    return 1;
+}
+
+/* Step lengths from 10 us to 4 s, from an empty accumulator. */
+
+static int check_sweep(void)
+{
+    int i;
+
+    for (i = 1; i <= 400000; i++)
+    {
+        float a = 0.0f;
+
+        if (!check("sweep", &a, i * 1.0e-5f))
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * The first and last floats of each binade from one tick to 4 s, as
+ * step lengths and as accumulators stepped by nothing.
+ */
+static int check_edges(void)
+{
+    const unsigned int e0 = float_bits(MS_TICK) >> 23;
+    const unsigned int e1 = float_bits(4.0f)    >> 23;
+
+    unsigned int e, i;
+
+    for (e = e0; e < e1; e++)
+        for (i = 0; i < 4096; i++)
+        {
+            const float lo = bits_float((e << 23) + i);
+            const float hi = bits_float((e << 23) + (1u << 23) - 1 - i);
+
+            float a;
+
+            if (!check("edge", (a = 0.0f, &a), lo)) return 0;
+            if (!check("edge", (a = 0.0f, &a), hi)) return 0;
+            if (!check("edge", (a = lo,   &a), 0.0f)) return 0;
+            if (!check("edge", (a = hi,   &a), 0.0f)) return 0;
+        }
+    return 1;
+}
+
+/*
+ * Long runs of fixed frame rates, and of jittered and random steps,
+ * each carrying its accumulator from step to step.
+ */
+static int check_runs(void)
+{
+    static const float rates[] = { 30.0f, 50.0f, 60.0f, 75.0f, 90.0f,
+                                   120.0f, 144.0f, 1000.0f };
+    int i, j;
+
+    for (i = 0; i < (int) ARRAYSIZE(rates); i++)
+    {
+        const float dt = 1.0f / rates[i];
+        float a = 0.0f;
+
+        for (j = 0; j < 200000; j++)
+            if (!check("rate", &a, dt))
+                return 0;
+    }
+
+    for (i = 0; i < 64; i++)
+    {
+        float a = 0.0f;
+
+        for (j = 0; j < 100000; j++)
+        {
+            float dt;
+
+            /* Frame times around 60 Hz, with the odd long stall. */
+
+            if (rand() % 1000)
+                dt = (1.0f + (rand() % 2001 - 1000) * 1.0e-4f) / 60.0f;
+            else
+                dt = (rand() % 2000) * 1.0e-3f;
+
+            if (!check("jitter", &a, dt))
+                return 0;
+        }
+    }
+
+    for (i = 0; i < 64; i++)
+    {
+        float a = 0.0f;
+
+        for (j = 0; j < 100000; j++)
+        {
+            /* Any bits up to 2 s, biased toward short steps. */
+
+            float dt = bits_float(((unsigned int) rand() << 8 ^
+                                   (unsigned int) rand()) % 0x40000000u);
+
+            if (!(dt >= 0.0f && dt < 2.0f))
+                dt = 0.0f;
+
+            if (!check("random", &a, dt))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    unsigned int seed = 1;
+
+    if (argc == 3 && strcmp(argv[1], "--seed") == 0)
+        seed = (unsigned int) strtoul(argv[2], NULL, 0);
+    else if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--seed N]\n", argv[0]);
+        return 1;
+    }
+
+    srand(seed);
+
+    if (check_sweep() && check_edges() && check_runs())
+    {
+        printf("%lu steps match\n", checks);
+        return 0;
+    }
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+/*
+ * sidecheck: regression test for the batched side tests.
+ *
+ * sol_test_sides tests the side planes of a lump four at a time, with
+ * SSE where the compiler has it, or two at a time with paired singles on
+ * the Wii.  Build with -DSIDE_PAIRED=1 -ffp-contract=off to run the
+ * paired-single kernel here.  It must give the same collision times
+ * and contact points, to the bit, as testing each side with
+ * sol_test_side.  For every solid lump of each level, this sends balls
+ * of random sizes past and into the lump, on moving and resting bodies,
+ * and runs both.  It also runs all of sol_test_lump both ways.  It stops
+ * at the first difference and exits non-zero.
+ *
+ *     sidecheck [--samples N] <data-dir> <level.sol>...
+ *
+ * The tests are static, so share/solid_sim_sol.c is included here rather
+ * than linked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solid_sim_sol.c"
+
+#include "fs.h"
+
+#define CHECK_SAMPLES 64
+
+/*---------------------------------------------------------------------------*/
+
+static unsigned int seed = 1;
+
+/* Uniform in [-1, +1). */
+
+static float rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return (seed & 0xffffff) / 8388608.0f - 1.0f;
+}
+
+/* The side loop of sol_test_lump when there are no batched sides. */
+
+static float ref_sides(float dt,
+                       float T[3],
+                       const struct v_ball *up,
+                       const struct s_base *base,
+                       const struct b_lump *lp,
+                       const float o[3],
+                       const float w[3])
+{
+    float U[3] = { 0.0f, 0.0f, 0.0f };
+    float u, t = dt;
+    int i;
+
+    for (i = 0; i < lp->sc; i++)
+    {
+        const struct b_side *sp = base->sv + base->iv[lp->s0 + i];
+
+        if ((u = sol_test_side(t, U, up, base, lp, sp, o, w)) < t)
+        {
+            v_cpy(T, U);
+            t = u;
+        }
+    }
+    return t;
+}
+
+/*---------------------------------------------------------------------------*/
+
+struct tally
+{
+    unsigned long tests;
+    unsigned long hits;
+};
+
+static int same(float dt, float t, float u, const float T[3],
+                const float U[3])
+{
+    if (memcmp(&t, &u, sizeof (float)))
+        return 0;
+
+    return t >= dt || memcmp(T, U, sizeof (float) * 3) == 0;
+}
+
+static void report(const char *name, const char *what, int li,
+                   float t, float u, const float T[3], const float U[3])
+{
+    printf("%s: lump %d: %s differs\n"
+           "    batched %a (%a %a %a)\n"
+           "    scalar  %a (%a %a %a)\n", name, li, what,
+           t, T[0], T[1], T[2],
+           u, U[0], U[1], U[2]);
+}
+
+/*
+ * Test one lump against SAMPLES balls.  Half of them are aimed at a
+ * point near its center and half move at random.  Every other one is
+ * tested against a moving body.
+ */
+static int check_lump(const char *name, struct s_vary *vary, int li,
+                      int samples, struct tally *tally)
+{
+    const struct s_base *base = vary->base;
+    const struct b_lump *lp   = base->lv + li;
+
+    struct s_vary scalar = *vary;
+
+    float c[3] = { 0.0f, 0.0f, 0.0f };
+    float s = 0.0f;
+    int i, j, k;
+
+    scalar.sv = NULL;
+
+    /* Find the lump's center and its size. */
+
+    for (i = 0; i < lp->vc; i++)
+        v_add(c, c, base->vv[base->iv[lp->v0 + i]].p);
+
+    if (lp->vc)
+        v_scl(c, c, 1.0f / lp->vc);
+
+    for (i = 0; i < lp->vc; i++)
+    {
+        float d[3];
+
+        v_sub(d, base->vv[base->iv[lp->v0 + i]].p, c);
+        s = MAX(s, v_len(d));
+    }
+
+    for (k = 0; k < samples; k++)
+    {
+        struct v_ball ball;
+
+        float o[3] = { 0.0f, 0.0f, 0.0f };
+        float w[3] = { 0.0f, 0.0f, 0.0f };
+        float T[3] = { 0.0f, 0.0f, 0.0f };
+        float U[3] = { 0.0f, 0.0f, 0.0f };
+        float dt, t, u;
+
+        memset(&ball, 0, sizeof (ball));
+
+        ball.r = 0.3f + 0.25f * rnd();
+        dt     = 0.025f + 0.025f * rnd();
+
+        for (j = 0; j < 3; j++)
+            ball.p[j] = c[j] + (s + 2.0f) * rnd();
+
+        if (k & 2)
+            for (j = 0; j < 3; j++)
+                ball.v[j] = 10.0f * rnd();
+        else
+            for (j = 0; j < 3; j++)
+                ball.v[j] = (c[j] + 0.5f * s * rnd() - ball.p[j]) / dt;
+
+        if (k & 1)
+            for (j = 0; j < 3; j++)
+            {
+                o[j] = 0.5f * rnd();
+                w[j] = 2.0f * rnd();
+            }
+
+        /* The sides alone. */
+
+        t = sol_test_sides(dt, T, &ball, vary, lp, o, w);
+        u = ref_sides     (dt, U, &ball, base, lp, o, w);
+
+        tally->tests++;
+
+        if (t < dt)
+            tally->hits++;
+
+        if (!same(dt, t, u, T, U))
+        {
+            report(name, "side time", li, t, u, T, U);
+            return 0;
+        }
+
+        /* The whole lump, with its edges and verts. */
+
+        t = sol_test_lump(dt, T, &ball, vary,    lp, o, w);
+        u = sol_test_lump(dt, U, &ball, &scalar, lp, o, w);
+
+        if (!same(dt, t, u, T, U))
+        {
+            report(name, "lump time", li, t, u, T, U);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int check_level(const char *name, int samples, struct tally *tally)
+{
+    struct s_base base;
+    struct s_vary vary;
+    int li, rc = 1;
+
+    if (!sol_load_base(&base, name))
+    {
+        printf("%s: failed to load\n", name);
+        return 0;
+    }
+
+    if (!sol_load_vary(&vary, &base))
+    {
+        printf("%s: failed to load\n", name);
+        sol_free_base(&base);
+        return 0;
+    }
+
+    for (li = 0; li < base.lc && rc; li++)
+        if (!(base.lv[li].fl & L_DETAIL) && base.lv[li].sc)
+        {
+            if (vary.sv)
+                rc = check_lump(name, &vary, li, samples, tally);
+            else
+            {
+                printf("%s: no batched sides\n", name);
+                rc = 0;
+            }
+        }
+
+    sol_free_vary(&vary);
+    sol_free_base(&base);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    struct tally tally = { 0, 0 };
+
+    int samples = CHECK_SAMPLES;
+    int argi;
+
+    for (argi = 1; argi < argc && argv[argi][0] == '-'; argi++)
+    {
+        if (strcmp(argv[argi], "--samples") == 0 && argi + 1 < argc)
+            samples = atoi(argv[++argi]);
+        else
+            break;
+    }
+
+    if (argc - argi < 2 || samples < 1)
+    {
+        fprintf(stderr, "Usage: %s [--samples N] <data> <level.sol>...\n",
+                argv[0]);
+        return 1;
+    }
+
+    if (!fs_init(argv[0]))
+    {
+        fprintf(stderr, "Failure to initialize virtual file system: %s\n",
+                fs_error());
+        return 1;
+    }
+
+    fs_add_path(argv[argi]);
+
+    for (argi++; argi < argc; argi++)
+        if (!check_level(argv[argi], samples, &tally))
+            return 1;
+
+    printf("%lu side tests, %lu hits, all match\n", tally.tests, tally.hits);
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+/*
+ * solbench: headless physics benchmark.
+ *
+ * Replays the tilt input stream of one or more recorded .nbr files
+ * against their levels, running only the server-side simulation, and
+ * reports the step rate, the time split between the main simulation
+ * routines and a hash of the final ball and mover state.  The hash is
+ * meant for comparing physics changes: two builds that simulate a
+ * replay identically print the same value.
+ *
+ * Only the input is taken from the replay.  Replays recorded with an
+ * older simulation drift away from the recorded ball path; the result is
+ * still deterministic for a given build.
+ *
+ *     solbench [--csv] [--repeat N] <data-dir> <replay.nbr>...
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "solid_base.h"
+#include "solid_vary.h"
+#include "solid_sim.h"
+#include "solid_all.h"
+#include "game_common.h"
+#include "binary.h"
+#include "common.h"
+#include "cmd.h"
+#include "vec3.h"
+#include "fs.h"
+
+#define DEMO_MAGIC (0xAF | 'N' << 8 | 'B' << 16 | 'R' << 24)
+#define DEMO_VERSION 9
+
+/*---------------------------------------------------------------------------*/
+
+struct bench
+{
+    char file[PATHMAX];
+
+    int    steps;
+    double time;
+    struct sim_profile prof;
+
+    unsigned int hash;
+};
+
+static double bench_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* FNV-1a over the bit patterns of the given floats. */
+
+static unsigned int hash_floats(unsigned int h, const float *f, int n)
+{
+    const unsigned char *c = (const unsigned char *) f;
+    int i;
+
+    for (i = 0; i < n * (int) sizeof (float); i++)
+    {
+        h ^= c[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static unsigned int hash_vary(const struct s_vary *vary)
+{
+    unsigned int h = 2166136261u;
+    int i;
+
+    for (i = 0; i < vary->uc; i++)
+    {
+        const struct v_ball *up = vary->uv + i;
+
+        h = hash_floats(h, up->p,    3);
+        h = hash_floats(h, up->v,    3);
+        h = hash_floats(h, up->w,    3);
+        h = hash_floats(h, up->e[0], 9);
+        h = hash_floats(h, up->E[0], 9);
+        h = hash_floats(h, up->W,    3);
+        h = hash_floats(h, &up->r,   1);
+    }
+
+    for (i = 0; i < vary->mc; i++)
+    {
+        h = hash_floats(h, &vary->mv[i].t, 1);
+        h ^= (unsigned int) vary->mv[i].pi;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int header_read(fs_file fp, char *file)
+{
+    char str[MAXSTR];
+    int head[6];
+    int tail[6];
+
+    get_index_array(fp, head, ARRAYSIZE(head));
+
+    if (head[0] != DEMO_MAGIC || head[1] != DEMO_VERSION)
+        return 0;
+
+    get_string(fp, str, sizeof (str));  /* Player                            */
+    get_string(fp, str, sizeof (str));  /* Date                              */
+    get_string(fp, str, sizeof (str));  /* Shot                              */
+    get_string(fp, file, PATHMAX);
+
+    get_index_array(fp, tail, ARRAYSIZE(tail));
+
+    return 1;
+}
+
+/*
+ * Replay one file.  The stream is the server's own output: each update
+ * carries the tilt that was used for that step, followed by the state
+ * changes the step caused.  Tilt, ball radius and status are taken from
+ * the stream; everything else is recomputed by the simulation.
+ */
+
+static int bench_replay(const char *path, struct bench *b)
+{
+    struct s_base base;
+    struct s_vary vary;
+    struct game_tilt tilt;
+
+    union cmd cmd;
+    fs_file fp;
+
+    int status = GAME_NONE;
+    int next   = GAME_NONE;
+    int got_tilt = 0;
+
+    int   jump_e = 1;
+    int   jump_b = 0;
+    float jump_dt = 0.0f;
+    float jump_p[3];
+
+    float dt = DT;
+
+    memset(b, 0, sizeof (*b));
+
+    if (!(fp = fs_open(path, "r")))
+    {
+        fprintf(stderr, "%s: %s\n", path, fs_error());
+        return 0;
+    }
+
+    if (!header_read(fp, b->file))
+    {
+        fprintf(stderr, "%s: not a replay\n", path);
+        fs_close(fp);
+        return 0;
+    }
+
+    /* Older replays carry no CMD_MAP, so go by the header. */
+
+    if (!sol_load_base(&base, b->file))
+    {
+        fprintf(stderr, "%s: failed to load %s\n", path, b->file);
+        fs_close(fp);
+        return 0;
+    }
+
+    if (!sol_load_vary(&vary, &base))
+    {
+        fprintf(stderr, "%s: failed to load %s\n", path, b->file);
+        sol_free_base(&base);
+        fs_close(fp);
+        return 0;
+    }
+
+    sol_init_sim(&vary);
+    game_tilt_init(&tilt);
+
+    while (cmd_get(fp, &cmd))
+    {
+        switch (cmd.type)
+        {
+        case CMD_MAP:
+            free(cmd.map.name);
+            break;
+
+        case CMD_SOUND:
+            free(cmd.sound.n);
+            break;
+
+        case CMD_UPDATES_PER_SECOND:
+            dt = 1.0f / cmd.ups.n;
+            break;
+
+        case CMD_TILT_AXES:
+            v_cpy(tilt.x, cmd.tiltaxes.x);
+            v_cpy(tilt.z, cmd.tiltaxes.z);
+            got_tilt = 1;
+            break;
+
+        case CMD_TILT_ANGLES:
+            tilt.rx = cmd.tiltangles.x;
+            tilt.rz = cmd.tiltangles.z;
+            got_tilt = 1;
+            break;
+
+        case CMD_BALL_RADIUS:
+            if (vary.uc)
+                vary.uv[0].r = cmd.ballradius.r;
+            break;
+
+        case CMD_STATUS:
+            next = cmd.status.t;
+            break;
+
+        case CMD_END_OF_UPDATE:
+            if (got_tilt && vary.uc)
+            {
+                float h[3];
+
+                game_tilt_grav(h, status == GAME_GOAL ?
+                               GRAVITY_UP : GRAVITY_DN, &tilt);
+
+                if (jump_b > 0)
+                {
+                    jump_dt += dt;
+
+                    if (jump_dt >= 0.5f)
+                        v_cpy(vary.uv->p, jump_p);
+
+                    if (jump_dt >= 1.0f)
+                        jump_b = 0;
+                }
+                else
+                {
+                    double t0 = bench_time();
+
+                    sol_step(&vary, NULL, h, dt, 0, NULL);
+
+                    b->time += bench_time() - t0;
+                    b->steps++;
+                }
+
+                sol_swch_test(&vary, NULL, 0);
+
+                if (jump_e == 1 && jump_b == 0 &&
+                    sol_jump_test(&vary, jump_p, 0) == JUMP_INSIDE)
+                {
+                    jump_b  = 1;
+                    jump_e  = 0;
+                    jump_dt = 0.0f;
+                }
+                if (jump_e == 0 && jump_b == 0 &&
+                    sol_jump_test(&vary, jump_p, 0) == JUMP_OUTSIDE)
+                    jump_e = 1;
+            }
+
+            status   = next;
+            got_tilt = 0;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    fs_close(fp);
+
+    b->hash = hash_vary(&vary);
+
+    sol_quit_sim();
+    sol_free_vary(&vary);
+    sol_free_base(&base);
+
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void bench_print(const char *path, const struct bench *b, int csv)
+{
+    double rate = b->time > 0.0 ? b->steps / b->time : 0.0;
+
+    if (csv)
+        printf("%s,%s,%d,%f,%.0f,%f,%f,%f,%08x\n",
+               path, b->file, b->steps, b->time, rate,
+               b->prof.test_file, b->prof.move_once, b->prof.path_time,
+               b->hash);
+    else
+        printf("%s (%s)\n"
+               "    steps          %d\n"
+               "    time           %.3f s\n"
+               "    steps/sec      %.0f\n"
+               "    sol_test_file  %.3f s\n"
+               "    sol_move_once  %.3f s\n"
+               "    sol_path_time  %.3f s\n"
+               "    hash           %08x\n",
+               path, b->file, b->steps, b->time, rate,
+               b->prof.test_file, b->prof.move_once, b->prof.path_time,
+               b->hash);
+}
+
+int main(int argc, char *argv[])
+{
+    int csv    = 0;
+    int repeat = 1;
+    int argi;
+    int rc = 0;
+
+    for (argi = 1; argi < argc && argv[argi][0] == '-'; argi++)
+    {
+        if      (strcmp(argv[argi], "--csv") == 0)
+            csv = 1;
+        else if (strcmp(argv[argi], "--repeat") == 0 && argi + 1 < argc)
+            repeat = atoi(argv[++argi]);
+        else
+            break;
+    }
+
+    if (argc - argi < 2 || repeat < 1)
+    {
+        fprintf(stderr,
+                "Usage: %s [--csv] [--repeat N] <data> <replay.nbr>...\n",
+                argv[0]);
+        return 1;
+    }
+
+    if (!fs_init(argv[0]))
+    {
+        fprintf(stderr, "Failure to initialize virtual file system: %s\n",
+                fs_error());
+        return 1;
+    }
+
+    /* Replays are looked up in the data directory, then the current one. */
+
+    fs_add_path(argv[argi++]);
+    fs_add_path(".");
+
+    if (csv)
+        printf("replay,level,steps,time,steps_per_sec,"
+               "sol_test_file,sol_move_once,sol_path_time,hash\n");
+
+    for (; argi < argc; argi++)
+    {
+        struct bench b, best;
+        int i;
+
+        /* Keep the fastest run; the hash must not change between runs. */
+
+        for (i = 0; i < repeat; i++)
+        {
+            memset(&sim_profile, 0, sizeof (sim_profile));
+
+            if (!bench_replay(argv[argi], &b))
+                break;
+
+            b.prof = sim_profile;
+
+            if (i && b.hash != best.hash)
+                fprintf(stderr, "%s: hash mismatch between runs\n",
+                        argv[argi]);
+
+            if (i == 0 || b.time < best.time)
+                best = b;
+        }
+
+        if (i < repeat)
+        {
+            rc = 1;
+            continue;
+        }
+
+        bench_print(argv[argi], &best, csv);
+    }
+
+    fs_quit();
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+/*
+ * solfuzz: fuzz target for the SOL loader.
+ *
+ * Each input is written to a file and loaded with sol_load_meta and
+ * sol_load_base.  If it loads, the level is set up for simulation and
+ * stepped a few times with the ball, switches, jumps, goals and items,
+ * so that the indices the loader accepted are followed as the game
+ * would follow them.
+ *
+ * Built with -fsanitize=fuzzer and -DSOLFUZZ_LIBFUZZER, this is a
+ * libFuzzer target.  Otherwise each file named on the command line is
+ * run once, which suits AFL and replaying crashes:
+ *
+ *     solfuzz <file.sol>...
+ *     afl-fuzz -i <levels> -o <findings> -- ./solfuzz @@
+ *
+ * The input file is written to the directory named by TMPDIR, or to the
+ * current directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solid_base.h"
+#include "solid_vary.h"
+#include "solid_sim.h"
+#include "solid_all.h"
+#include "game_common.h"
+#include "common.h"
+#include "fs.h"
+
+#define FUZZ_FILE  "solfuzz.sol"
+#define FUZZ_STEPS 8
+
+/*---------------------------------------------------------------------------*/
+
+static int fuzz_init(const char *argv0)
+{
+    static int init;
+
+    const char *dir;
+
+    if (!init)
+    {
+        if (!(dir = getenv("TMPDIR")))
+            dir = ".";
+
+        if (!fs_init(argv0) || !fs_add_path(dir) || !fs_set_write_dir(dir))
+        {
+            fprintf(stderr, "Failure to initialize virtual file system: %s\n",
+                    fs_error());
+            return 0;
+        }
+        init = 1;
+    }
+    return 1;
+}
+
+static void fuzz_vary(struct s_base *base)
+{
+    static const float g[3] = { 0.0f, -9.8f, 0.0f };
+
+    struct s_vary vary;
+    float p[3];
+    int i;
+
+    if (!sol_load_vary(&vary, base))
+        return;
+
+    sol_init_sim(&vary);
+
+    for (i = 0; i < FUZZ_STEPS; i++)
+    {
+        sol_step(&vary, NULL, g, DT, 0, NULL);
+
+        sol_swch_test(&vary, NULL, 0);
+        sol_jump_test(&vary, p, 0);
+        sol_goal_test(&vary, p, 0);
+        sol_item_test(&vary, p, 0.15f);
+    }
+
+    sol_quit_sim();
+    sol_free_vary(&vary);
+}
+
+static int fuzz_one(const void *data, size_t size)
+{
+    struct s_base base;
+    fs_file fp;
+
+    if (!(fp = fs_open(FUZZ_FILE, "w")))
+        return 0;
+
+    fs_write(data, 1, (int) size, fp);
+    fs_close(fp);
+
+    if (sol_load_meta(&base, FUZZ_FILE))
+        sol_free_base(&base);
+
+    if (sol_load_base(&base, FUZZ_FILE))
+    {
+        fuzz_vary(&base);
+        sol_free_base(&base);
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if SOLFUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size)
+{
+    if (fuzz_init("solfuzz"))
+        fuzz_one(data, size);
+
+    return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    int argi;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <file.sol>...\n", argv[0]);
+        return 1;
+    }
+
+    if (!fuzz_init(argv[0]))
+        return 1;
+
+    for (argi = 1; argi < argc; argi++)
+    {
+        FILE *fin;
+        void *data;
+        long  size;
+
+        if (!(fin = fopen(argv[argi], "rb")))
+        {
+            perror(argv[argi]);
+            continue;
+        }
+
+        fseek(fin, 0, SEEK_END);
+        size = ftell(fin);
+        fseek(fin, 0, SEEK_SET);
+
+        if (size >= 0 && (data = malloc(size + 1)))
+        {
+            if (fread(data, 1, size, fin) == (size_t) size)
+                fuzz_one(data, size);
+
+            free(data);
+        }
+        fclose(fin);
+    }
+
+    fs_quit();
+
+    return 0;
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+/*
+ * solload: SOL load time benchmark.
+ *
+ * Loads each given SOL file with sol_load_base through a stand-in for
+ * slow storage: every fs_read is held up for as long as the given
+ * transfer rate and per-read latency would take.  Reports the bytes
+ * and reads done, the time spent waiting on storage, the remaining time
+ * spent parsing, inflating and swapping, and a hash of the loaded
+ * data.  A packed SOL hashes the same as the unpacked file it was made
+ * alongside, so running this over two builds of the same level compares
+ * their load times.
+ *
+ * Must be linked with -Wl,--wrap=fs_read, see Makefile_data.
+ *
+ *     solload [--csv] [--repeat N] [--rate KB/s] [--latency ms]
+ *             <data-dir> <level.sol>...
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "solid_base.h"
+#include "common.h"
+#include "fs.h"
+
+/*---------------------------------------------------------------------------*/
+
+static double throttle_rate    = 4096.0;        /* KB per second             */
+static double throttle_latency = 0.1;           /* milliseconds per read     */
+
+static long   read_bytes;
+static int    read_count;
+static double read_time;
+
+static double bench_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void bench_wait(double t)
+{
+    struct timespec ts;
+
+    if (t > 0.0)
+    {
+        ts.tv_sec  = (time_t) t;
+        ts.tv_nsec = (long) ((t - ts.tv_sec) * 1.0e9);
+
+        nanosleep(&ts, NULL);
+    }
+}
+
+int __real_fs_read(void *data, int size, int count, fs_file fh);
+
+/*
+ * Stand-in for reading from an SD card: the read itself comes from the
+ * page cache, then the caller waits out the rest of the time the card
+ * would have taken.
+ */
+int __wrap_fs_read(void *data, int size, int count, fs_file fh)
+{
+    double t0 = bench_time();
+    int n = __real_fs_read(data, size, count, fh);
+    long len = n > 0 ? (long) n * size : 0;
+
+    bench_wait(throttle_latency / 1000.0 + len / (throttle_rate * 1024.0) -
+               (bench_time() - t0));
+
+    read_bytes += len;
+    read_count += 1;
+    read_time  += bench_time() - t0;
+
+    return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+struct bench
+{
+    long   bytes;
+    int    reads;
+    double time;
+    double wait;
+
+    unsigned int hash;
+};
+
+/* FNV-1a over N bytes. */
+
+static unsigned int hash_bytes(unsigned int h, const void *p, size_t n)
+{
+    const unsigned char *c = (const unsigned char *) p;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        h ^= c[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+#define HASH(h, fp, c, v) \
+    hash_bytes(hash_bytes(h, &(fp)->c, sizeof ((fp)->c)), \
+               (fp)->v, (size_t) (fp)->c * sizeof (*(fp)->v))
+
+static unsigned int hash_base(const struct s_base *fp)
+{
+    unsigned int h = 2166136261u;
+
+    h = HASH(h, fp, ac, av);
+    h = HASH(h, fp, dc, dv);
+    h = HASH(h, fp, mc, mv);
+    h = HASH(h, fp, vc, vv);
+    h = HASH(h, fp, ec, ev);
+    h = HASH(h, fp, sc, sv);
+    h = HASH(h, fp, tc, tv);
+    h = HASH(h, fp, oc, ov);
+    h = HASH(h, fp, gc, gv);
+    h = HASH(h, fp, lc, lv);
+    h = HASH(h, fp, nc, nv);
+    h = HASH(h, fp, pc, pv);
+    h = HASH(h, fp, bc, bv);
+    h = HASH(h, fp, hc, hv);
+    h = HASH(h, fp, zc, zv);
+    h = HASH(h, fp, jc, jv);
+    h = HASH(h, fp, xc, xv);
+    h = HASH(h, fp, rc, rv);
+    h = HASH(h, fp, uc, uv);
+    h = HASH(h, fp, wc, wv);
+    h = HASH(h, fp, ic, iv);
+    h = HASH(h, fp, kc, kv);
+    h = HASH(h, fp, yc, yv);
+    h = HASH(h, fp, cc, cv);
+    h = HASH(h, fp, qc, qv);
+
+    return h;
+}
+
+#undef HASH
+
+static int bench_load(const char *path, struct bench *b)
+{
+    struct s_base base;
+    double t0;
+
+    memset(b, 0, sizeof (*b));
+
+    read_bytes = 0;
+    read_count = 0;
+    read_time  = 0.0;
+
+    t0 = bench_time();
+
+    if (!sol_load_base(&base, path))
+    {
+        fprintf(stderr, "%s: failed to load\n", path);
+        return 0;
+    }
+
+    b->time  = bench_time() - t0;
+    b->wait  = read_time;
+    b->bytes = read_bytes;
+    b->reads = read_count;
+    b->hash  = hash_base(&base);
+
+    sol_free_base(&base);
+
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void bench_print(const char *path, const struct bench *b, int csv)
+{
+    if (csv)
+        printf("%s,%ld,%d,%f,%f,%f,%08x\n",
+               path, b->bytes, b->reads, b->time, b->wait, b->time - b->wait,
+               b->hash);
+    else
+        printf("%s\n"
+               "    bytes read     %ld\n"
+               "    reads          %d\n"
+               "    time           %.3f s\n"
+               "    read wait      %.3f s\n"
+               "    decode         %.3f s\n"
+               "    hash           %08x\n",
+               path, b->bytes, b->reads, b->time, b->wait, b->time - b->wait,
+               b->hash);
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench total;
+
+    int csv    = 0;
+    int repeat = 1;
+    int argi;
+    int rc = 0;
+
+    for (argi = 1; argi < argc && argv[argi][0] == '-'; argi++)
+    {
+        if      (strcmp(argv[argi], "--csv") == 0)
+            csv = 1;
+        else if (strcmp(argv[argi], "--repeat") == 0 && argi + 1 < argc)
+            repeat = atoi(argv[++argi]);
+        else if (strcmp(argv[argi], "--rate") == 0 && argi + 1 < argc)
+            throttle_rate = atof(argv[++argi]);
+        else if (strcmp(argv[argi], "--latency") == 0 && argi + 1 < argc)
+            throttle_latency = atof(argv[++argi]);
+        else
+            break;
+    }
+
+    if (argc - argi < 2 || repeat < 1 || throttle_rate <= 0.0)
+    {
+        fprintf(stderr,
+                "Usage: %s [--csv] [--repeat N] [--rate KB/s] "
+                "[--latency ms] <data> <level.sol>...\n",
+                argv[0]);
+        return 1;
+    }
+
+    if (!fs_init(argv[0]))
+    {
+        fprintf(stderr, "Failure to initialize virtual file system: %s\n",
+                fs_error());
+        return 1;
+    }
+
+    fs_add_path(argv[argi++]);
+
+    memset(&total, 0, sizeof (total));
+
+    if (csv)
+        printf("level,bytes,reads,time,read_wait,decode,hash\n");
+
+    for (; argi < argc; argi++)
+    {
+        struct bench b, best;
+        int i;
+
+        /* Keep the fastest run. */
+
+        for (i = 0; i < repeat; i++)
+        {
+            if (!bench_load(argv[argi], &b))
+                break;
+
+            if (i == 0 || b.time < best.time)
+                best = b;
+        }
+
+        if (i < repeat)
+        {
+            rc = 1;
+            continue;
+        }
+
+        bench_print(argv[argi], &best, csv);
+
+        total.bytes += best.bytes;
+        total.reads += best.reads;
+        total.time  += best.time;
+        total.wait  += best.wait;
+        total.hash  ^= best.hash;
+    }
+
+    bench_print("total", &total, csv);
+
+    fs_quit();
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
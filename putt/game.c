@@ -543,7 +543,7 @@ int game_step(const float g[3], float dt)
 
         for (i = 0; i < n; i++)
         {
-            d = sol_step(fp, NULL, g, t, ball, &m);
+            d = sol_step_all(fp, NULL, g, t, &m);
 
             if (b < d)
                 b = d;
@@ -693,6 +693,10 @@ void game_ball(int i)
         file.vary.uv[ui].w[0] = 0.f;
         file.vary.uv[ui].w[1] = 0.f;
         file.vary.uv[ui].w[2] = 0.f;
+
+        /* Only the ball in play moves. */
+
+        file.vary.uv[ui].s = (ui != ball);
     }
 }
 
@@ -22,6 +22,69 @@
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Runs of 4-byte words are moved with a single read or write and, on
+ * big-endian hosts, byte-swapped in a separate pass.
+ */
+
+#define WORD_BUFF 256
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+static void swap_words(unsigned char *p, size_t n)
+{
+    unsigned char t;
+    size_t i;
+
+    for (i = 0; i < n; i++, p += 4)
+    {
+        t = p[0]; p[0] = p[3]; p[3] = t;
+        t = p[1]; p[1] = p[2]; p[2] = t;
+    }
+}
+#endif
+
+static void put_words(fs_file fout, const void *v, size_t n)
+{
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    const unsigned char *p = (const unsigned char *) v;
+    unsigned char buff[WORD_BUFF * 4];
+
+    while (n > 0)
+    {
+        size_t c = n < WORD_BUFF ? n : WORD_BUFF;
+
+        memcpy(buff, p, c * 4);
+        swap_words(buff, c);
+        fs_write(buff, 4, c, fout);
+
+        p += c * 4;
+        n -= c;
+    }
+#else
+    if (n > 0)
+        fs_write(v, 4, n, fout);
+#endif
+}
+
+static void get_words(fs_file fin, void *v, size_t n)
+{
+    int c;
+
+    if (n > 0)
+    {
+        /* Zero whatever a short read leaves behind. */
+
+        if ((c = fs_read(v, 4, n, fin)) < (int) n)
+            memset((unsigned char *) v + c * 4, 0, (n - c) * 4);
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        swap_words((unsigned char *) v, n);
+#endif
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
 void put_float(fs_file fout, float f)
 {
     unsigned char *p = (unsigned char *) &f;
@@ -71,10 +134,12 @@ void put_short(fs_file fout, short s)
 
 void put_array(fs_file fout, const float *v, size_t n)
 {
-    size_t i;
+    put_words(fout, v, n);
+}
 
-    for (i = 0; i < n; i++)
-        put_float(fout, v[i]);
+void put_index_array(fs_file fout, const int *v, size_t n)
+{
+    put_words(fout, v, n);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -137,10 +202,12 @@ short get_short(fs_file fin)
 
 void get_array(fs_file fin, float *v, size_t n)
 {
-    size_t i;
+    get_words(fin, v, n);
+}
 
-    for (i = 0; i < n; i++)
-        v[i] = get_float(fin);
+void get_index_array(fs_file fin, int *v, size_t n)
+{
+    get_words(fin, v, n);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -17,7 +17,10 @@
 #include <assert.h>
 #include <string.h>
 #include <errno.h>
+
+#ifdef GEKKO
 #include <fat.h>
+#endif
 
 #include "fs.h"
 #include "dir.h"
@@ -43,7 +46,9 @@ static List  fs_path;
 
 int fs_init(const char *argv0)
 {
+#ifdef GEKKO
     fatInitDefault();
+#endif
     fs_dir_base  = strdup(dir_name(argv0));
     fs_dir_write = NULL;
     fs_path      = NULL;
@@ -269,12 +274,11 @@ fs_file fs_open(const char *path, const char *mode)
 
 int fs_close(fs_file fh)
 {
-    if (fclose(fh->handle))
-    {
-        free(fh);
-        return 1;
-    }
-    return 0;
+    int rc = (fclose(fh->handle) == 0);
+
+    free(fh);
+
+    return rc;
 }
 
 /*----------------------------------------------------------------------------*/
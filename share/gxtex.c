@@ -0,0 +1,590 @@
+/*
+ * Copyright (C) 2003 Robert Kooima
+ *
+ * NEVERBALL is  free software; you can redistribute  it and/or modify
+ * it under the  terms of the GNU General  Public License as published
+ * by the Free  Software Foundation; either version 2  of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT  ANY  WARRANTY;  without   even  the  implied  warranty  of
+ * MERCHANTABILITY or  FITNESS FOR A PARTICULAR PURPOSE.   See the GNU
+ * General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gxtex.h"
+#include "fs.h"
+
+/*---------------------------------------------------------------------------*/
+
+int gxtex_size(int fmt, int w, int h)
+{
+    int tw, th;
+
+    switch (fmt)
+    {
+    case GXTEX_I8:     tw = 8; th = 4; break;
+    case GXTEX_IA8:
+    case GXTEX_RGB565:
+    case GXTEX_RGB5A3: tw = 4; th = 4; break;
+    case GXTEX_CMPR:   tw = 8; th = 8; break;
+
+    default: return 0;
+    }
+    return ((w + tw - 1) / tw) * ((h + th - 1) / th) * 32;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int src_bytes(int src)
+{
+    return src == GXTEX_SRC_A ? 1 : src;
+}
+
+static inline void get_rgba(unsigned char c[4], const unsigned char *p,
+                            int src)
+{
+    switch (src)
+    {
+    case GXTEX_SRC_L:
+        c[0] = c[1] = c[2] = p[0]; c[3] = 0xFF;
+        break;
+    case GXTEX_SRC_LA:
+        c[0] = c[1] = c[2] = p[0]; c[3] = p[1];
+        break;
+    case GXTEX_SRC_RGB:
+        c[0] = p[0]; c[1] = p[1]; c[2] = p[2]; c[3] = 0xFF;
+        break;
+    case GXTEX_SRC_RGBA:
+        c[0] = p[0]; c[1] = p[1]; c[2] = p[2]; c[3] = p[3];
+        break;
+    case GXTEX_SRC_A:
+        c[0] = c[1] = c[2] = 0; c[3] = p[0];
+        break;
+    }
+}
+
+static int get_i(const unsigned char c[4])
+{
+    return (77 * c[0] + 150 * c[1] + 29 * c[2] + 128) >> 8;
+}
+
+static int get_rgb565(const unsigned char c[4])
+{
+    return ((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3);
+}
+
+static int get_rgb5a3(const unsigned char c[4])
+{
+    if (c[3] == 0xFF)
+        return 0x8000 | ((c[0] >> 3) << 10) | ((c[1] >> 3) << 5) | (c[2] >> 3);
+    else
+        return ((c[3] >> 5) << 12) | ((c[0] >> 4) << 8) | ((c[1] >> 4) << 4) |
+                (c[2] >> 4);
+}
+
+/*
+ * Tile an image of 8- or 16-bit texels.  Source rows are read in order,
+ * a tile's worth at a time, and each texel is written out exactly once.
+ * This is inlined with constant formats so that the switches fold away.
+ */
+static inline void tile_loop(unsigned char *dst, const int fmt,
+                             const unsigned char *src, int w, int h,
+                             const int s)
+{
+    const int n  = src_bytes(s);
+    const int tw = (fmt == GXTEX_I8) ? 8 : 4;
+
+    int tx, ty, x, y;
+
+    for (ty = 0; ty < h; ty += 4)
+        for (tx = 0; tx < w; tx += tw)
+            for (y = ty; y < ty + 4; y++)
+            {
+                const unsigned char *p = NULL;
+
+                if (y < h)
+                    p = src + ((size_t) y * w + tx) * n;
+
+                for (x = tx; x < tx + tw; x++)
+                {
+                    unsigned char c[4] = { 0, 0, 0, 0 };
+                    int t;
+
+                    if (p && x < w)
+                    {
+                        get_rgba(c, p, s);
+                        p += n;
+                    }
+
+                    switch (fmt)
+                    {
+                    case GXTEX_I8:
+                        *dst++ = get_i(c);
+                        break;
+                    case GXTEX_IA8:
+                        *dst++ = c[3];
+                        *dst++ = get_i(c);
+                        break;
+                    case GXTEX_RGB565:
+                        t = get_rgb565(c);
+                        *dst++ = t >> 8;
+                        *dst++ = t & 0xFF;
+                        break;
+                    case GXTEX_RGB5A3:
+                        t = get_rgb5a3(c);
+                        *dst++ = t >> 8;
+                        *dst++ = t & 0xFF;
+                        break;
+                    }
+                }
+            }
+}
+
+#define TILE_SRC(f)                                                         \
+    switch (s)                                                              \
+    {                                                                       \
+    case GXTEX_SRC_L:    tile_loop(dst, f, src, w, h, GXTEX_SRC_L);    break; \
+    case GXTEX_SRC_LA:   tile_loop(dst, f, src, w, h, GXTEX_SRC_LA);   break; \
+    case GXTEX_SRC_RGB:  tile_loop(dst, f, src, w, h, GXTEX_SRC_RGB);  break; \
+    case GXTEX_SRC_RGBA: tile_loop(dst, f, src, w, h, GXTEX_SRC_RGBA); break; \
+    case GXTEX_SRC_A:    tile_loop(dst, f, src, w, h, GXTEX_SRC_A);    break; \
+    }
+
+static void tile_texels(unsigned char *dst, int fmt,
+                        const unsigned char *src, int w, int h, int s)
+{
+    switch (fmt)
+    {
+    case GXTEX_I8:     TILE_SRC(GXTEX_I8);     break;
+    case GXTEX_IA8:    TILE_SRC(GXTEX_IA8);    break;
+    case GXTEX_RGB565: TILE_SRC(GXTEX_RGB565); break;
+    case GXTEX_RGB5A3: TILE_SRC(GXTEX_RGB5A3); break;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void expand_rgb565(int k, int c[3])
+{
+    int r = (k >> 11) & 0x1F;
+    int g = (k >>  5) & 0x3F;
+    int b = (k      ) & 0x1F;
+
+    c[0] = (r << 3) | (r >> 2);
+    c[1] = (g << 2) | (g >> 4);
+    c[2] = (b << 3) | (b >> 2);
+}
+
+/*
+ * Encode one 4x4 block at (bx, by) as DXT1 in its four-color mode.  The
+ * end points span the block's bounding box, with the box's diagonal
+ * chosen to follow the sign of the red-green and blue-green covariance
+ * and pulled in by 1/16 on each side.
+ */
+static void cmpr_block(unsigned char *dst, const unsigned char *src,
+                       int w, int h, int bx, int by, int s)
+{
+    const int n = src_bytes(s);
+
+    unsigned char c[16][4];
+    int v[16];
+
+    int lo[3] = { 255, 255, 255 };
+    int hi[3] = {   0,   0,   0 };
+    long sum[3] = { 0, 0, 0 }, rg = 0, bg = 0;
+
+    int pal[4][3];
+    int i, k, m = 0, c0, c1;
+
+    for (i = 0; i < 16; i++)
+    {
+        const int x = bx + (i & 3);
+        const int y = by + (i >> 2);
+
+        if ((v[i] = (x < w && y < h)))
+        {
+            get_rgba(c[i], src + ((size_t) y * w + x) * n, s);
+
+            for (k = 0; k < 3; k++)
+            {
+                if (lo[k] > c[i][k]) lo[k] = c[i][k];
+                if (hi[k] < c[i][k]) hi[k] = c[i][k];
+                sum[k] += c[i][k];
+            }
+            rg += c[i][0] * c[i][1];
+            bg += c[i][2] * c[i][1];
+            m++;
+        }
+    }
+
+    memset(dst, 0, 8);
+
+    if (m == 0)
+        return;
+
+    /* Scaled covariances, m * sum(xy) - sum(x) * sum(y). */
+
+    if (m * rg - sum[0] * sum[1] < 0) { k = lo[0]; lo[0] = hi[0]; hi[0] = k; }
+    if (m * bg - sum[2] * sum[1] < 0) { k = lo[2]; lo[2] = hi[2]; hi[2] = k; }
+
+    for (k = 0; k < 3; k++)
+    {
+        const int d = (hi[k] - lo[k]) / 16;
+
+        hi[k] -= d;
+        lo[k] += d;
+    }
+
+    {
+        const unsigned char h4[4] = { hi[0], hi[1], hi[2], 0xFF };
+        const unsigned char l4[4] = { lo[0], lo[1], lo[2], 0xFF };
+
+        c0 = get_rgb565(h4);
+        c1 = get_rgb565(l4);
+    }
+
+    /* Four colors need c0 > c1.  Equal end points need no indices. */
+
+    if (c0 < c1)
+    {
+        k = c0; c0 = c1; c1 = k;
+    }
+
+    dst[0] = c0 >> 8; dst[1] = c0 & 0xFF;
+    dst[2] = c1 >> 8; dst[3] = c1 & 0xFF;
+
+    if (c0 == c1)
+        return;
+
+    expand_rgb565(c0, pal[0]);
+    expand_rgb565(c1, pal[1]);
+
+    for (k = 0; k < 3; k++)
+    {
+        pal[2][k] = (2 * pal[0][k] +     pal[1][k]) / 3;
+        pal[3][k] = (    pal[0][k] + 2 * pal[1][k]) / 3;
+    }
+
+    for (i = 0; i < 16; i++)
+        if (v[i])
+        {
+            int j, best = 0, dmin = 0x7FFFFFFF;
+
+            for (j = 0; j < 4; j++)
+            {
+                const int dr = c[i][0] - pal[j][0];
+                const int dg = c[i][1] - pal[j][1];
+                const int db = c[i][2] - pal[j][2];
+                const int d  = dr * dr + dg * dg + db * db;
+
+                if (d < dmin)
+                {
+                    dmin = d;
+                    best = j;
+                }
+            }
+            dst[4 + (i >> 2)] |= best << (6 - 2 * (i & 3));
+        }
+}
+
+static void tile_cmpr(unsigned char *dst, const unsigned char *src,
+                      int w, int h, int s)
+{
+    int tx, ty;
+
+    for (ty = 0; ty < h; ty += 8)
+        for (tx = 0; tx < w; tx += 8)
+        {
+            cmpr_block(dst,      src, w, h, tx,     ty,     s);
+            cmpr_block(dst +  8, src, w, h, tx + 4, ty,     s);
+            cmpr_block(dst + 16, src, w, h, tx,     ty + 4, s);
+            cmpr_block(dst + 24, src, w, h, tx + 4, ty + 4, s);
+            dst += 32;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Convert a w by h image of the given source layout to the GX format
+ * fmt.  The destination must hold gxtex_size(fmt, w, h) bytes.
+ */
+int gxtex_tile(void *dst, int fmt, const void *src, int w, int h, int s)
+{
+    if (s < GXTEX_SRC_L || s > GXTEX_SRC_A)
+        return 0;
+
+    switch (fmt)
+    {
+    case GXTEX_I8:
+    case GXTEX_IA8:
+    case GXTEX_RGB565:
+    case GXTEX_RGB5A3:
+        tile_texels(dst, fmt, src, w, h, s);
+        return 1;
+
+    case GXTEX_CMPR:
+        tile_cmpr(dst, src, w, h, s);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Pick a GX format for an image of b bytes per pixel, as loaded by
+ * image_load.  Opaque color images use CMPR if allowed.
+ */
+int gxtex_pick(const void *src, int w, int h, int b, int cmpr)
+{
+    const unsigned char *p = src;
+    int i;
+
+    switch (b)
+    {
+    case 1: return GXTEX_I8;
+    case 2: return GXTEX_IA8;
+    case 4:
+        for (i = 0; i < w * h; i++)
+            if (p[i * 4 + 3] != 0xFF)
+                return GXTEX_RGB5A3;
+        /* fall through */
+    case 3: return cmpr ? GXTEX_CMPR : GXTEX_RGB565;
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Mipmaps.  GX takes the levels of a texture one after another, from the
+ * base down to 1x1, each tiled and padded as an image of its own.  Only
+ * images with sides that are powers of two have them.
+ */
+
+int gxtex_lods(int w, int h)
+{
+    int n = 1;
+
+    if (w <= 0 || h <= 0 || (w & (w - 1)) || (h & (h - 1)))
+        return 1;
+
+    while (w > 1 || h > 1)
+    {
+        w = (w > 1) ? w >> 1 : 1;
+        h = (h > 1) ? h >> 1 : 1;
+        n++;
+    }
+    return n;
+}
+
+int gxtex_mip_size(int fmt, int w, int h, int lods)
+{
+    int i, n = 0;
+
+    for (i = 0; i < lods; i++)
+    {
+        n += gxtex_size(fmt, w, h);
+
+        w = (w > 1) ? w >> 1 : 1;
+        h = (h > 1) ? h >> 1 : 1;
+    }
+    return n;
+}
+
+/*
+ * Halve an image with a box filter.  Color is weighted by alpha, so that
+ * transparent texels do not darken the edges of opaque ones.
+ */
+static void *box_half(const unsigned char *p, int w, int h, int s,
+                      int *W, int *H)
+{
+    const int n  = src_bytes(s);
+    const int a  = (s == GXTEX_SRC_LA || s == GXTEX_SRC_RGBA) ? n - 1 : -1;
+    const int dx = (w > 1) ? n : 0;
+    const int dy = (h > 1) ? w * n : 0;
+
+    unsigned char *q, *d;
+    int x, y, k;
+
+    *W = (w > 1) ? w >> 1 : 1;
+    *H = (h > 1) ? h >> 1 : 1;
+
+    if (!(q = d = malloc((size_t) *W * *H * n)))
+        return NULL;
+
+    for (y = 0; y < *H; y++)
+        for (x = 0; x < *W; x++, d += n)
+        {
+            const unsigned char *t = p + (size_t) y * 2 * dy
+                                       + (size_t) x * 2 * dx;
+
+            const unsigned char *c0 = t;
+            const unsigned char *c1 = t + dx;
+            const unsigned char *c2 = t + dy;
+            const unsigned char *c3 = t + dx + dy;
+
+            const int m = (a < 0) ? 0 : c0[a] + c1[a] + c2[a] + c3[a];
+
+            for (k = 0; k < n; k++)
+            {
+                if (k == a || m == 0)
+                    d[k] = (c0[k] + c1[k] + c2[k] + c3[k] + 2) >> 2;
+                else
+                    d[k] = (c0[k] * c0[a] + c1[k] * c1[a] +
+                            c2[k] * c2[a] + c3[k] * c3[a] + m / 2) / m;
+            }
+        }
+
+    return q;
+}
+
+/*
+ * Tile an image and the given number of box-filtered levels below it,
+ * laid out for GX.  The destination must hold gxtex_mip_size bytes.
+ */
+int gxtex_tile_mips(void *dst, int fmt, const void *src, int w, int h, int s,
+                    int lods)
+{
+    unsigned char *d = dst;
+    void *p = NULL;
+    int i;
+
+    if (lods < 1 || lods > gxtex_lods(w, h))
+        return 0;
+
+    for (i = 0; i < lods; i++)
+    {
+        if (i > 0)
+        {
+            void *q = box_half(p ? p : src, w, h, s, &w, &h);
+
+            free(p);
+
+            if (!(p = q))
+                return 0;
+        }
+
+        if (!gxtex_tile(d, fmt, p ? p : src, w, h, s))
+        {
+            free(p);
+            return 0;
+        }
+        d += gxtex_size(fmt, w, h);
+    }
+    free(p);
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * A texture file is a header of big-endian fields, then the image:
+ *
+ *      0  "GXTX"
+ *      4  version, 16 bits
+ *      6  format, 16 bits
+ *      8  width, 16 bits
+ *     10  height, 16 bits
+ *     12  image size, 32 bits
+ *     16  mipmap levels, 16 bits
+ *     18  zero, up to 32 bytes
+ *
+ * The image holds every level, as gxtex_tile_mips lays them out.
+ */
+
+#define GXTEX_MAGIC   "GXTX"
+#define GXTEX_VERSION 2
+#define GXTEX_HEAD    32
+#define GXTEX_MAX     1024
+
+static int get_u16(const unsigned char *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static void put_u16(unsigned char *p, int i)
+{
+    p[0] = (i >> 8) & 0xFF;
+    p[1] = (i     ) & 0xFF;
+}
+
+void *gxtex_load(const char *path, int *fmt, int *w, int *h, int *lods,
+                 int *size)
+{
+    unsigned char head[GXTEX_HEAD];
+    void *p = NULL;
+    fs_file fin;
+
+    if ((fin = fs_open(path, "r")))
+    {
+        if (fs_read(head, 1, GXTEX_HEAD, fin) == GXTEX_HEAD &&
+            memcmp(head, GXTEX_MAGIC, 4) == 0 &&
+            get_u16(head + 4) == GXTEX_VERSION)
+        {
+            const int f = get_u16(head + 6);
+            const int x = get_u16(head + 8);
+            const int y = get_u16(head + 10);
+            const int n = (get_u16(head + 12) << 16) | get_u16(head + 14);
+            const int l = get_u16(head + 16);
+
+            if (x > 0 && x <= GXTEX_MAX && y > 0 && y <= GXTEX_MAX &&
+                l > 0 && l <= gxtex_lods(x, y) &&
+                n > 0 && n == gxtex_mip_size(f, x, y, l) && (p = malloc(n)))
+            {
+                if (fs_read(p, 1, n, fin) == n)
+                {
+                    *fmt  = f;
+                    *w    = x;
+                    *h    = y;
+                    *lods = l;
+                    *size = n;
+                }
+                else
+                {
+                    free(p);
+                    p = NULL;
+                }
+            }
+        }
+        fs_close(fin);
+    }
+    return p;
+}
+
+int gxtex_save(const char *path, int fmt, int w, int h, int lods,
+               const void *data)
+{
+    unsigned char head[GXTEX_HEAD];
+    const int n = gxtex_mip_size(fmt, w, h, lods);
+    int rc = 0;
+    fs_file fout;
+
+    if (n == 0 || w > GXTEX_MAX || h > GXTEX_MAX ||
+        lods < 1 || lods > gxtex_lods(w, h))
+        return 0;
+
+    memset(head, 0, sizeof (head));
+    memcpy(head, GXTEX_MAGIC, 4);
+
+    put_u16(head +  4, GXTEX_VERSION);
+    put_u16(head +  6, fmt);
+    put_u16(head +  8, w);
+    put_u16(head + 10, h);
+    put_u16(head + 12, n >> 16);
+    put_u16(head + 14, n);
+    put_u16(head + 16, lods);
+
+    if ((fout = fs_open(path, "w")))
+    {
+        rc = (fs_write(head, 1, GXTEX_HEAD, fout) == GXTEX_HEAD &&
+              fs_write(data, 1, n, fout) == n);
+        fs_close(fout);
+    }
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
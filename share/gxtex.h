@@ -0,0 +1,54 @@
+#ifndef GXTEX_H
+#define GXTEX_H
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * GX texture images.
+ *
+ * GX samples textures from tiles of 32 bytes: 8x4 texels of I8, 4x4 of
+ * IA8, RGB565 and RGB5A3, and 8x8 of CMPR, which is S3TC/DXT1 with the
+ * four 4x4 blocks of a tile stored in row order.  An image is padded
+ * out to whole tiles.  16-bit texels and block colors are big-endian.
+ */
+
+#define GXTEX_I8      0x1
+#define GXTEX_IA8     0x3
+#define GXTEX_RGB565  0x4
+#define GXTEX_RGB5A3  0x5
+#define GXTEX_CMPR    0xE
+
+/* Source pixel layouts.  The first four match image_load's byte counts. */
+
+#define GXTEX_SRC_L     1
+#define GXTEX_SRC_LA    2
+#define GXTEX_SRC_RGB   3
+#define GXTEX_SRC_RGBA  4
+#define GXTEX_SRC_A     5
+
+int  gxtex_size(int fmt, int w, int h);
+int  gxtex_tile(void *dst, int fmt, const void *src, int w, int h, int s);
+int  gxtex_pick(const void *src, int w, int h, int b, int cmpr);
+
+int  gxtex_lods(int w, int h);
+int  gxtex_mip_size(int fmt, int w, int h, int lods);
+int  gxtex_tile_mips(void *dst, int fmt, const void *src, int w, int h, int s,
+                     int lods);
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Pre-tiled texture files, made offline by contrib/gxtexc.c and named
+ * after the image they were made from, as in "textures/foo.png.gxt".
+ */
+
+#define GXTEX_EXT ".gxt"
+
+void *gxtex_load(const char *, int *fmt, int *w, int *h, int *lods,
+                 int *size);
+int   gxtex_save(const char *, int fmt, int w, int h, int lods,
+                 const void *data);
+
+/*---------------------------------------------------------------------------*/
+
+#endif
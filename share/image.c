@@ -24,6 +24,8 @@
 #include "base_image.h"
 #include "config.h"
 #include "video.h"
+#include "common.h"
+#include "gxtex.h"
 
 #include "fs.h"
 #include "fs_png.h"
@@ -166,6 +168,61 @@ GLuint make_texture(const void *p, int w, int h, int b, int fl)
     return o;
 }
 
+/*
+ * Load the image tiled for GX offline from the named file, if there is
+ * one and it needs no scaling.  Return an OpenGL texture object.
+ */
+static GLuint make_texture_from_gxtex(const char *filename, int fl)
+{
+    char  *path;
+    void  *p = NULL;
+    int    m = (fl & IF_MIPMAP) ? config_get_d(CONFIG_MIPMAP) : 0;
+    int    f;
+    int    w;
+    int    h;
+    int    l;
+    int    n;
+    GLuint o = 0;
+
+    if (config_get_d(CONFIG_TEXTURES) != 1)
+        return 0;
+
+    if ((path = concat_string(filename, GXTEX_EXT, NULL)))
+    {
+        p = gxtex_load(path, &f, &w, &h, &l, &n);
+        free(path);
+    }
+
+    if (p)
+    {
+        if (w <= gli.max_texture_size && h <= gli.max_texture_size)
+        {
+            glGenTextures(1, &o);
+            glBindTexture(GL_TEXTURE_2D, o);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+            /* Upload the mipmap levels only if they are wanted. */
+
+            if (m && l > 1)
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                                GL_LINEAR_MIPMAP_LINEAR);
+            else
+                n = gxtex_size(f, w, h);
+
+            glCompressedTexImage2D(GL_TEXTURE_2D, 0,
+                                   GL_GX_TEXTURE_WII | f, w, h, 0, n, p);
+        }
+        free(p);
+    }
+
+    return o;
+}
+
 /*
  * Load an image from the named file.  Return an OpenGL texture object.
  */
@@ -177,7 +234,10 @@ GLuint make_image_from_file(const char *filename, int fl)
     int    b;
     GLuint o = 0;
 
-    /* Load the image. */
+    /* Use the pre-tiled image, or load the image. */
+
+    if ((o = make_texture_from_gxtex(filename, fl)))
+        return o;
 
     if ((p = image_load(filename, &w, &h, &b)))
     {
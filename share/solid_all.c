@@ -154,6 +154,48 @@ int sol_body_w(const struct s_vary *vary,
     return 0;
 }
 
+/*
+ * Bring the transform cached on body BP up to date with its movers.
+ * If DT is positive, also cache the body velocity over DT.
+ */
+void sol_body_cache(struct s_vary *vary, struct v_body *bp, float dt)
+{
+    const int m[2] = { bp->mi, bp->mj };
+    int i;
+
+    for (i = 0; i < 2; i++)
+        if (m[i] >= 0)
+        {
+            const struct v_move *mp = vary->mv + m[i];
+
+            if (bp->kt[i] != mp->t  ||
+                bp->kp[i] != mp->pi ||
+                bp->kf[i] != vary->pv[mp->pi].f)
+            {
+                bp->kt[i] = mp->t;
+                bp->kp[i] = mp->pi;
+                bp->kf[i] = vary->pv[mp->pi].f;
+                bp->kv    = 0;
+            }
+        }
+
+    if (!bp->kv)
+    {
+        sol_body_p(bp->p, vary, bp, 0.0f);
+        sol_body_e(bp->e, vary, bp, 0.0f);
+
+        bp->r  = (bp->e[0] != 1.0f || sol_body_w(vary, bp));
+        bp->dv = 0.0f;
+        bp->kv = 1;
+    }
+
+    if (dt > 0.0f && bp->dv != dt)
+    {
+        sol_body_v(bp->v, vary, bp, dt);
+        bp->dv = dt;
+    }
+}
+
 /*---------------------------------------------------------------------------*/
 
 /*
@@ -243,16 +285,127 @@ void sol_pendulum(struct v_ball *up,
 
 /*---------------------------------------------------------------------------*/
 
-static void sol_path_flag(struct s_vary *vary, cmd_fn cmd_func, int pi, int f)
+/*
+ * Movers on active paths are kept in a binary min-heap keyed by the
+ * time in milliseconds of their next path change.  Active movers all
+ * advance with the clock, so a key only changes when its mover starts
+ * a new path or its path is switched on or off.
+ */
+
+static void move_swap(struct s_vary *vary, int i, int j)
 {
-    if (pi < 0 || pi >= vary->pc)
+    int mi = vary->qv[i];
+    int mj = vary->qv[j];
+
+    vary->qv[i] = mj;
+    vary->qv[j] = mi;
+
+    vary->mv[mi].qi = j;
+    vary->mv[mj].qi = i;
+}
+
+static int move_less(const struct s_vary *vary, int i, int j)
+{
+    return vary->mv[vary->qv[i]].qt < vary->mv[vary->qv[j]].qt;
+}
+
+static void move_sift(struct s_vary *vary, int i)
+{
+    int j;
+
+    while (i > 0 && move_less(vary, i, (j = (i - 1) / 2)))
+    {
+        move_swap(vary, i, j);
+        i = j;
+    }
+
+    while ((j = 2 * i + 1) < vary->qc)
+    {
+        if (j + 1 < vary->qc && move_less(vary, j + 1, j))
+            j++;
+
+        if (!move_less(vary, j, i))
+            break;
+
+        move_swap(vary, i, j);
+        i = j;
+    }
+}
+
+/*
+ * Queue, requeue or dequeue mover MI according to its current path.
+ */
+static void move_queue(struct s_vary *vary, int mi)
+{
+    struct v_move *mp = vary->mv + mi;
+    int i;
+
+    if (!vary->qv)
         return;
 
+    if (vary->pv[mp->pi].f)
+    {
+        mp->qt = vary->tm + vary->pv[mp->pi].base->tm - mp->tm;
+
+        if (mp->qi < 0)
+        {
+            mp->qi = vary->qc++;
+            vary->qv[mp->qi] = mi;
+        }
+        move_sift(vary, mp->qi);
+    }
+    else if ((i = mp->qi) >= 0)
+    {
+        move_swap(vary, i, --vary->qc);
+        mp->qi = -1;
+
+        if (i < vary->qc)
+            move_sift(vary, i);
+    }
+}
+
+/*
+ * Queue all movers from scratch and restart the clock.
+ */
+void sol_move_init(struct s_vary *vary)
+{
+    int mi;
+
+    vary->tm = 0;
+    vary->qc = 0;
+
+    for (mi = 0; mi < vary->mc; mi++)
+    {
+        vary->mv[mi].qi = -1;
+        move_queue(vary, mi);
+    }
+}
+
+/*
+ * Find the milliseconds till the next path change, or -1 if none.
+ */
+int sol_move_next(const struct s_vary *vary)
+{
+    return vary->qc ? vary->mv[vary->qv[0]].qt - vary->tm : -1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void sol_path_flag(struct s_vary *vary, cmd_fn cmd_func, int pi, int f)
+{
+    int mi;
+
     if (vary->pv[pi].f == f)
         return;
 
     vary->pv[pi].f = f;
 
+    /* Start or stop the movers on this path. */
+
+    for (mi = 0; mi < vary->mc; mi++)
+        if (vary->mv[mi].pi == pi)
+            move_queue(vary, mi);
+
     if (cmd_func)
     {
         union cmd cmd = { CMD_PATH_FLAG };
@@ -268,7 +421,9 @@ static void sol_path_loop(struct s_vary *vary, cmd_fn cmd_func, int p0, int f)
     int pj = p0;
     int pk;
 
-    if (p0 < 0 || p0 >= vary->pc)
+    /* Path links are checked on load, but a level may have no paths. */
+
+    if (vary->pc == 0)
         return;
 
     do  /* Tortoise and hare cycle traverser. */
@@ -344,6 +499,8 @@ void sol_move_step(struct s_vary *vary, cmd_fn cmd_func, float dt, int ms)
 {
     int i;
 
+    vary->tm += ms;
+
     for (i = 0; i < vary->mc; i++)
     {
         struct v_move *mp = vary->mv + i;
@@ -361,6 +518,8 @@ void sol_move_step(struct s_vary *vary, cmd_fn cmd_func, float dt, int ms)
                 mp->tm = 0;
                 mp->pi = pp->base->pi;
 
+                move_queue(vary, i);
+
                 if (cmd_func)
                 {
                     union cmd cmd;
@@ -391,6 +550,9 @@ void sol_ball_step(struct s_vary *vary, cmd_fn cmd_func, float dt)
     {
         struct v_ball *up = vary->uv + i;
 
+        if (up->s)
+            continue;
+
         v_mad(up->p, up->p, up->v, dt);
 
         sol_rotate(up->e, up->w, dt);
@@ -403,11 +565,13 @@ int sol_item_test(struct s_vary *vary, float *p, float item_r)
 {
     const float *ball_p = vary->uv->p;
     const float  ball_r = vary->uv->r;
-    int hi;
+    int i, n, hi;
+
+    n = sol_grid_near(&vary->hg, ball_p, ball_r + item_r);
 
-    for (hi = 0; hi < vary->hc; hi++)
+    for (i = 0; i < n; i++)
     {
-        struct v_item *hp = vary->hv + hi;
+        struct v_item *hp = vary->hv + (hi = vary->hg.qv[i]);
         float r[3];
 
         v_sub(r, ball_p, hp->p);
@@ -428,11 +592,13 @@ struct b_goal *sol_goal_test(struct s_vary *vary, float *p, int ui)
 {
     const float *ball_p = vary->uv[ui].p;
     const float  ball_r = vary->uv[ui].r;
-    int zi;
+    int i, n;
 
-    for (zi = 0; zi < vary->base->zc; zi++)
+    n = sol_grid_near(&vary->zg, ball_p, 0.0f);
+
+    for (i = 0; i < n; i++)
     {
-        struct b_goal *zp = vary->base->zv + zi;
+        struct b_goal *zp = vary->base->zv + vary->zg.qv[i];
         float r[3];
 
         r[0] = ball_p[0] - zp->p[0];
@@ -460,11 +626,13 @@ int sol_jump_test(struct s_vary *vary, float *p, int ui)
 {
     const float *ball_p = vary->uv[ui].p;
     const float  ball_r = vary->uv[ui].r;
-    int ji, touch = 0;
+    int i, n, touch = 0;
+
+    n = sol_grid_near(&vary->jg, ball_p, 0.0f);
 
-    for (ji = 0; ji < vary->base->jc; ji++)
+    for (i = 0; i < n; i++)
     {
-        struct b_jump *jp = vary->base->jv + ji;
+        struct b_jump *jp = vary->base->jv + vary->jg.qv[i];
         float d, r[3];
 
         r[0] = ball_p[0] - jp->p[0];
@@ -508,12 +676,24 @@ int sol_swch_test(struct s_vary *vary, cmd_fn cmd_func, int ui)
     const float *ball_p = vary->uv[ui].p;
     const float  ball_r = vary->uv[ui].r;
 
-    int xi, rc = SWCH_OUTSIDE;
+    int i, n, xi, rc = SWCH_OUTSIDE;
 
-    for (xi = 0; xi < vary->xc; xi++)
+    n = sol_grid_near(&vary->xg, ball_p, ball_r);
+
+    /*
+     * Only nearby switches can be entered, but any switch the ball
+     * is still in must see it leave.
+     */
+
+    for (i = 0, xi = 0; xi < vary->xc; xi++)
     {
         struct v_swch *xp = vary->xv + xi;
 
+        if (i < n && vary->xg.qv[i] == xi)
+            i++;
+        else if (!xp->e)
+            continue;
+
         /* FIXME enter/exit events don't work for timed switches */
 
         if (xp->base->t == 0 || xp->f == xp->base->f)
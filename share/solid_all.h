@@ -20,12 +20,17 @@ void sol_body_e(float e[3],
 int  sol_body_w(const struct s_vary *,
                 const struct v_body *);
 
+void sol_body_cache(struct s_vary *, struct v_body *, float);
+
 void sol_rotate(float e[3][3], const float w[3], float dt);
 
 void sol_pendulum(struct v_ball *up,
                   const float a[3],
                   const float g[3], float dt);
 
+void sol_move_init(struct s_vary *);
+int  sol_move_next(const struct s_vary *);
+
 void sol_swch_step(struct s_vary *, cmd_fn, float dt, int ms);
 void sol_move_step(struct s_vary *, cmd_fn, float dt, int ms);
 void sol_ball_step(struct s_vary *, cmd_fn, float dt);
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <math.h>
 
@@ -53,20 +54,20 @@ static const struct
 
 /*---------------------------------------------------------------------------*/
 
-static void sol_transform(const struct s_vary *vary,
-                          const struct v_body *bp, int ui)
+static void sol_transform(struct s_vary *vary,
+                          struct v_body *bp, int ui)
 {
+    const float *p;
     float a;
-    float e[4];
-    float p[3];
     float v[3];
 
     /* Apply the body position and rotation to the model-view matrix. */
 
-    sol_body_p(p, vary, bp, 0.0f);
-    sol_body_e(e, vary, bp, 0.0f);
+    sol_body_cache(vary, bp, 0.0f);
 
-    q_as_axisangle(e, v, &a);
+    p = bp->p;
+
+    q_as_axisangle(bp->e, v, &a);
 
     if (!(p[0] == 0 && p[1] == 0 && p[2] == 0))
         glTranslatef(p[0], p[1], p[2]);
@@ -318,6 +319,33 @@ static void sol_mesh_geom(struct d_vert *vv,   int *vn,
     }
 }
 
+static void sol_buff_mesh(struct d_mesh *mp,
+                          const void          *vv, int vn, size_t vs,
+                          const struct d_geom *gv, int gn,
+                          const struct s_draw *draw, int mi)
+{
+    const size_t gs = sizeof (struct d_geom);
+
+    /* Initialize buffer objects for all data. */
+
+    glGenBuffers_(1, &mp->vbo);
+    glBindBuffer_(GL_ARRAY_BUFFER,         mp->vbo);
+    glBufferData_(GL_ARRAY_BUFFER,         vn * vs, vv, GL_STATIC_DRAW);
+    glBindBuffer_(GL_ARRAY_BUFFER,         0);
+
+    glGenBuffers_(1, &mp->ebo);
+    glBindBuffer_(GL_ELEMENT_ARRAY_BUFFER, mp->ebo);
+    glBufferData_(GL_ELEMENT_ARRAY_BUFFER, gn * gs, gv, GL_STATIC_DRAW);
+    glBindBuffer_(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    /* Note cached material index. */
+
+    mp->mtrl = draw->base->mtrls[mi];
+
+    mp->ebc = gn * 3;
+    mp->vbc = vn;
+}
+
 static void sol_load_mesh(struct d_mesh *mp,
                           const struct b_body *bp,
                           const struct s_draw *draw, int mi)
@@ -358,27 +386,77 @@ static void sol_load_mesh(struct d_mesh *mp,
 
         sol_mesh_geom(vv, &vn, gv, &gn, draw->base, iv, bp->g0, bp->gc, mi);
 
-        /* Initialize buffer objects for all data. */
+        sol_buff_mesh(mp, vv, vn, vs, gv, gn, draw, mi);
+    }
+
+    free(iv);
+    free(gv);
+    free(vv);
+}
+
+/* Stored draw vertices upload as they are, so must be laid out as d_vert. */
 
-        glGenBuffers_(1, &mp->vbo);
-        glBindBuffer_(GL_ARRAY_BUFFER,         mp->vbo);
-        glBufferData_(GL_ARRAY_BUFFER,         vn * vs, vv, GL_STATIC_DRAW);
-        glBindBuffer_(GL_ARRAY_BUFFER,         0);
+#define SAME_MEMBER(m) \
+    (offsetof (struct b_cvrt, m) == offsetof (struct d_vert, m))
 
-        glGenBuffers_(1, &mp->ebo);
-        glBindBuffer_(GL_ELEMENT_ARRAY_BUFFER, mp->ebo);
-        glBufferData_(GL_ELEMENT_ARRAY_BUFFER, gn * gs, gv, GL_STATIC_DRAW);
-        glBindBuffer_(GL_ELEMENT_ARRAY_BUFFER, 0);
+typedef char sol_cvrt_layout[(sizeof (struct b_cvrt) == sizeof (struct d_vert) &&
+                              SAME_MEMBER(p) &&
+                              SAME_MEMBER(n) &&
+                              SAME_MEMBER(t)) ? 1 : -1];
 
-        /* Note cached material index. */
+#undef SAME_MEMBER
 
-        mp->mtrl = draw->base->mtrls[mi];
+static void sol_load_batch(struct d_mesh *mp,
+                           const struct b_mesh *kp,
+                           const struct s_draw *draw)
+{
+    const struct s_base *base = draw->base;
+
+    struct d_vert *vv = 0;
+    struct d_geom *gv = 0;
+
+    /* Expand a batch precomputed by mapc, in the order given. */
+
+    if ((gv = (struct d_geom *) calloc(kp->gc, sizeof (struct d_geom))))
+    {
+        const int *yv = base->yv + kp->g0;
+        int i;
 
-        mp->ebc = gn * 3;
-        mp->vbc = vn;
+        for (i = 0; i < kp->gc; i++)
+        {
+            gv[i].i = yv[i * 3 + 0];
+            gv[i].j = yv[i * 3 + 1];
+            gv[i].k = yv[i * 3 + 2];
+        }
+
+        /*
+         * Upload stored vertices as they are, packed ones first, as GX
+         * reads them without conversion.  Else assemble them.
+         */
+
+        if (base->qc)
+        {
+            sol_buff_mesh(mp, base->qv + kp->q0, kp->oc, sizeof (*base->qv),
+                          gv, kp->gc, draw, kp->mi);
+
+            mp->qp     = kp->qp;
+            mp->qt     = kp->qt;
+            mp->packed = 1;
+        }
+        else if (base->cc)
+            sol_buff_mesh(mp, base->cv + kp->c0, kp->oc, sizeof (*base->cv),
+                          gv, kp->gc, draw, kp->mi);
+
+        else if ((vv = (struct d_vert *) calloc(kp->oc, sizeof (*vv))))
+        {
+            for (i = 0; i < kp->oc; i++)
+                sol_mesh_vert(vv + i, base, base->yv[kp->o0 + i]);
+
+            sol_buff_mesh(mp, vv, kp->oc, sizeof (*vv),
+                          gv, kp->gc, draw, kp->mi);
+        }
     }
 
-    free(iv);
     free(gv);
     free(vv);
 }
@@ -395,8 +473,18 @@ void sol_draw_mesh(const struct d_mesh *mp, struct s_rend *rend, int p)
 
     if (sol_test_mtrl(mp->mtrl, p))
     {
-        const size_t s = sizeof (struct d_vert);
-        const GLenum T = GL_FLOAT;
+        /* Packed vertices are in GX fixed point, floats have no fraction. */
+
+        const size_t s = (mp->packed ? sizeof (struct b_qvrt) :
+                                       sizeof (struct d_vert));
+        const GLenum T = (mp->packed ? GL_SHORT : GL_FLOAT);
+
+        const GLvoid *P = (GLvoid *) (mp->packed ? offsetof (struct b_qvrt, p) :
+                                                   offsetof (struct d_vert, p));
+        const GLvoid *N = (GLvoid *) (mp->packed ? offsetof (struct b_qvrt, n) :
+                                                   offsetof (struct d_vert, n));
+        const GLvoid *U = (GLvoid *) (mp->packed ? offsetof (struct b_qvrt, t) :
+                                                   offsetof (struct d_vert, t));
 
         /* Apply the material state. */
 
@@ -407,19 +495,19 @@ void sol_draw_mesh(const struct d_mesh *mp, struct s_rend *rend, int p)
         glBindBuffer_(GL_ARRAY_BUFFER,         mp->vbo);
         glBindBuffer_(GL_ELEMENT_ARRAY_BUFFER, mp->ebo);
 
-        glVertexPointer  (3, T, s, (GLvoid *) offsetof (struct d_vert, p));
-        glNormalPointer  (   T, s, (GLvoid *) offsetof (struct d_vert, n));
+        wiigl_vertex_pointer   (3, T, s, P, mp->qp);
+        glNormalPointer        (   T, s, N);
 
         if (tex_env_stage(TEX_STAGE_SHADOW))
         {
-            glTexCoordPointer(3, T, s, (GLvoid *) offsetof (struct d_vert, p));
+            wiigl_tex_coord_pointer(3, T, s, P, mp->qp);
 
             if (tex_env_stage(TEX_STAGE_CLIP))
-                glTexCoordPointer(3, T, s, (GLvoid *) offsetof (struct d_vert, p));
+                wiigl_tex_coord_pointer(3, T, s, P, mp->qp);
 
             tex_env_stage(TEX_STAGE_TEXTURE);
         }
-        glTexCoordPointer(2, T, s, (GLvoid *) offsetof (struct d_vert, t));
+        wiigl_tex_coord_pointer(2, T, s, U, mp->qt);
 
         /* Draw the mesh. */
 
@@ -436,26 +524,46 @@ static void sol_load_body(struct d_body *bp,
                           const struct b_body *bq,
                           const struct s_draw *draw)
 {
-    int mi;
+    const int bi = bq - draw->base->bv;
+    int mi, ki;
 
     bp->base = bq;
     bp->mc   =  0;
 
-    /* Determine how many materials this body uses. */
+    /* Determine how many meshes this body has: one for each batch mapc     */
+    /* made for it or, lacking those, one for each material it uses.        */
 
-    for (mi = 0; mi < draw->base->mc; ++mi)
-        if (sol_count_body(bq, draw->base, mi))
-            bp->mc++;
+    if (draw->base->kc)
+    {
+        for (ki = 0; ki < draw->base->kc; ++ki)
+            if (draw->base->kv[ki].bi == bi)
+                bp->mc++;
+    }
+    else
+    {
+        for (mi = 0; mi < draw->base->mc; ++mi)
+            if (sol_count_body(bq, draw->base, mi))
+                bp->mc++;
+    }
 
-    /* Allocate and initialize a mesh for each material. */
+    /* Allocate and initialize each mesh. */
 
     if ((bp->mv = (struct d_mesh *) calloc(bp->mc, sizeof (struct d_mesh))))
     {
         int mj = 0;
 
-        for (mi = 0; mi < draw->base->mc; ++mi)
-            if (sol_count_body(bq, draw->base, mi))
-                sol_load_mesh(bp->mv + mj++, bq, draw, mi);
+        if (draw->base->kc)
+        {
+            for (ki = 0; ki < draw->base->kc; ++ki)
+                if (draw->base->kv[ki].bi == bi)
+                    sol_load_batch(bp->mv + mj++, draw->base->kv + ki, draw);
+        }
+        else
+        {
+            for (mi = 0; mi < draw->base->mc; ++mi)
+                if (sol_count_body(bq, draw->base, mi))
+                    sol_load_mesh(bp->mv + mj++, bq, draw, mi);
+        }
     }
 
     /* Cache a mesh count for each pass. */
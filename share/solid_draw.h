@@ -40,6 +40,8 @@ enum
 
 /*---------------------------------------------------------------------------*/
 
+/* Laid out as struct b_cvrt, so that stored draw vertices upload as is. */
+
 struct d_vert
 {
     float p[3];
@@ -64,6 +66,11 @@ struct d_mesh
     GLuint vbc;                                /* Vertex  buffer count       */
     GLuint ebo;                                /* Element buffer object      */
     GLuint ebc;                                /* Element buffer count       */
+
+    int qp;                                    /* Position fraction bits     */
+    int qt;                                    /* Texcoord fraction bits     */
+
+    unsigned int packed:1;                     /* Vertices are b_qvrt        */
 };
 
 struct d_body
@@ -25,6 +25,26 @@ void sol_quit_sim(void);
 
 void  sol_move(struct s_vary *, cmd_fn, float);
 float sol_step(struct s_vary *, cmd_fn, const float *, float, int, int *);
+float sol_step_all(struct s_vary *, cmd_fn, const float *, float, int *);
+
+/*---------------------------------------------------------------------------*/
+
+#if ENABLE_SIM_PROFILE
+
+/*
+ * Wall clock time spent in the simulation, in seconds.
+ */
+
+struct sim_profile
+{
+    double test_file;
+    double move_once;
+    double path_time;
+};
+
+extern struct sim_profile sim_profile;
+
+#endif
 
 /*---------------------------------------------------------------------------*/
 
@@ -12,8 +12,17 @@
  * General Public License for more details.
  */
 
+#if ENABLE_SIM_PROFILE
+#define _POSIX_C_SOURCE 200112L
+#include <time.h>
+#endif
+
 #include <math.h>
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 #include "vec3.h"
 #include "common.h"
 
@@ -24,6 +33,35 @@
 #define LARGE 1.0e+5f
 #define SMALL 1.0e-3f
 
+/*---------------------------------------------------------------------------*/
+
+#if ENABLE_SIM_PROFILE
+
+struct sim_profile sim_profile;
+
+static double prof_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/* Evaluate statement X and charge its run time to profile counter F. */
+
+#define PROF(f, x) do {                           \
+    double prof_t0 = prof_time();                 \
+    x;                                            \
+    sim_profile.f += prof_time() - prof_t0;       \
+} while (0)
+
+#else
+
+#define PROF(f, x) do { x; } while (0)
+
+#endif
+
 /*---------------------------------------------------------------------------*/
 /* Solves (p + v * t) . (p + v * t) == r * r for smallest t.                 */
 
@@ -241,6 +279,377 @@ static float v_side(float Q[3],
     return t;
 }
 
+/*
+ * Test four side planes of a lump at once.  SIDE_TIME finds the times
+ * at which the sphere reaches each plane, as v_side does.  SIDE_OUT
+ * finds which planes point Q at time T lies in front of.  Both keep the
+ * order of the scalar operations, so the results match to the bit.
+ */
+
+#if defined(GEKKO) && !defined(SIDE_PAIRED)
+#define SIDE_PAIRED 1
+#endif
+
+#if SIDE_PAIRED
+
+/*
+ * The Wii's paired singles take two sides at a time.  Each kernel is a
+ * list of paired-single instructions D = A op B, made into inline
+ * assembly on the Wii.  Elsewhere, with SIDE_PAIRED defined, the same
+ * list runs in C one lane at a time, so that contrib/sidecheck can test
+ * it.  The Wii builds this file with -ffp-contract=off, so that neither
+ * these nor the scalar tests they must match are fused.
+ */
+
+#define SIDE_DOT(PS, D, A0, A1, A2)             \
+    PS(muls0,   D,  x,  A0)                     \
+    PS(muls0,   s,  y,  A1)                     \
+    PS(add,     D,  D,  s)                      \
+    PS(muls0,   s,  z,  A2)                     \
+    PS(add,     D,  D,  s)
+
+/* From normals X Y Z and distances D, leave K in VN, U in S and A in D. */
+
+#define SIDE_TIME_OPS(PS)                       \
+    SIDE_DOT(PS, vn, v0, v1, v2)                \
+    SIDE_DOT(PS, wn, w0, w1, w2)                \
+    SIDE_DOT(PS, on, o0, o1, o2)                \
+    SIDE_DOT(PS, pn, p0, p1, p2)                \
+    PS(sub,     vn, vn, wn)                     \
+    PS(merge00, s,  r,  r)                      \
+    PS(add,     s,  s,  d)                      \
+    PS(add,     s,  s,  on)                     \
+    PS(sub,     s,  s,  pn)                     \
+    PS(div,     s,  s,  vn)                     \
+    PS(add,     d,  d,  on)                     \
+    PS(sub,     d,  d,  pn)                     \
+    PS(div,     d,  d,  vn)
+
+/* From normals X Y Z, leave the distance of Q in front of each in QN. */
+
+#define SIDE_OUT_OPS(PS)                        \
+    SIDE_DOT(PS, qn, q0, q1, q2)                \
+    SIDE_DOT(PS, on, o0, o1, o2)                \
+    SIDE_DOT(PS, wn, w0, w1, w2)                \
+    PS(sub,     qn, qn, on)                     \
+    PS(muls0,   wn, wn, t)                      \
+    PS(sub,     qn, qn, wn)
+
+#ifdef GEKKO
+
+#define SIDE_PS(op, D, A, B) "ps_" #op " %[" #D "], %[" #A "], %[" #B "]\n\t"
+
+static void side_time_pair(float k[2], float u[2], float a[2],
+                           const struct v_side *sp, int i,
+                           const float O[3],
+                           const float W[3],
+                           const float P[3],
+                           const float V[3], float R)
+{
+    double x, y, z, d, vn, wn, on, pn, s;
+
+    __asm__ __volatile__ ("psq_l  %[x],  0(%[nx]), 0, 0\n\t"
+                          "psq_l  %[y],  0(%[ny]), 0, 0\n\t"
+                          "psq_l  %[z],  0(%[nz]), 0, 0\n\t"
+                          "psq_l  %[d],  0(%[nd]), 0, 0\n\t"
+                          SIDE_TIME_OPS(SIDE_PS)
+                          "psq_st %[vn], 0(%[k]),  0, 0\n\t"
+                          "psq_st %[s],  0(%[u]),  0, 0\n\t"
+                          "psq_st %[d],  0(%[a]),  0, 0\n\t"
+                          : [x]  "=&f" (x),  [y]  "=&f" (y),  [z]  "=&f" (z),
+                            [d]  "=&f" (d),  [vn] "=&f" (vn), [wn] "=&f" (wn),
+                            [on] "=&f" (on), [pn] "=&f" (pn), [s]  "=&f" (s)
+                          : [nx] "b" (sp->n[0] + i), [ny] "b" (sp->n[1] + i),
+                            [nz] "b" (sp->n[2] + i), [nd] "b" (sp->d    + i),
+                            [k]  "b" (k), [u] "b" (u), [a] "b" (a),
+                            [v0] "f" (V[0]), [v1] "f" (V[1]), [v2] "f" (V[2]),
+                            [w0] "f" (W[0]), [w1] "f" (W[1]), [w2] "f" (W[2]),
+                            [o0] "f" (O[0]), [o1] "f" (O[1]), [o2] "f" (O[2]),
+                            [p0] "f" (P[0]), [p1] "f" (P[1]), [p2] "f" (P[2]),
+                            [r]  "f" (R)
+                          : "memory");
+}
+
+static void side_out_pair(float out[2],
+                          const struct v_side *sp, int i,
+                          const float Q[3],
+                          const float O[3],
+                          const float W[3], float T)
+{
+    double x, y, z, qn, on, wn, s;
+
+    __asm__ __volatile__ ("psq_l  %[x],  0(%[nx]), 0, 0\n\t"
+                          "psq_l  %[y],  0(%[ny]), 0, 0\n\t"
+                          "psq_l  %[z],  0(%[nz]), 0, 0\n\t"
+                          SIDE_OUT_OPS(SIDE_PS)
+                          "psq_st %[qn], 0(%[out]), 0, 0\n\t"
+                          : [x]  "=&f" (x),  [y]  "=&f" (y),  [z]  "=&f" (z),
+                            [qn] "=&f" (qn), [on] "=&f" (on), [wn] "=&f" (wn),
+                            [s]  "=&f" (s)
+                          : [nx] "b" (sp->n[0] + i), [ny] "b" (sp->n[1] + i),
+                            [nz] "b" (sp->n[2] + i), [out] "b" (out),
+                            [q0] "f" (Q[0]), [q1] "f" (Q[1]), [q2] "f" (Q[2]),
+                            [o0] "f" (O[0]), [o1] "f" (O[1]), [o2] "f" (O[2]),
+                            [w0] "f" (W[0]), [w1] "f" (W[1]), [w2] "f" (W[2]),
+                            [t]  "f" (T)
+                          : "memory");
+}
+
+#else
+
+/* A scalar operand holds the same value in both halves, as after lfs. */
+
+#define SIDE_PS(op, D, A, B) side_##op(D, A, B);
+
+static void side_add(float d[2], const float a[2], const float b[2])
+{
+    d[0] = a[0] + b[0];
+    d[1] = a[1] + b[1];
+}
+
+static void side_sub(float d[2], const float a[2], const float b[2])
+{
+    d[0] = a[0] - b[0];
+    d[1] = a[1] - b[1];
+}
+
+static void side_div(float d[2], const float a[2], const float b[2])
+{
+    d[0] = a[0] / b[0];
+    d[1] = a[1] / b[1];
+}
+
+static void side_muls0(float d[2], const float a[2], const float b[2])
+{
+    d[0] = a[0] * b[0];
+    d[1] = a[1] * b[0];
+}
+
+static void side_merge00(float d[2], const float a[2], const float b[2])
+{
+    d[0] = a[0];
+    d[1] = b[0];
+}
+
+static void side_time_pair(float k[2], float u[2], float a[2],
+                           const struct v_side *sp, int i,
+                           const float O[3],
+                           const float W[3],
+                           const float P[3],
+                           const float V[3], float R)
+{
+    const float v0[2] = { V[0], V[0] }, v1[2] = { V[1], V[1] };
+    const float v2[2] = { V[2], V[2] };
+    const float w0[2] = { W[0], W[0] }, w1[2] = { W[1], W[1] };
+    const float w2[2] = { W[2], W[2] };
+    const float o0[2] = { O[0], O[0] }, o1[2] = { O[1], O[1] };
+    const float o2[2] = { O[2], O[2] };
+    const float p0[2] = { P[0], P[0] }, p1[2] = { P[1], P[1] };
+    const float p2[2] = { P[2], P[2] };
+    const float r [2] = { R,    R    };
+
+    float x[2] = { sp->n[0][i], sp->n[0][i + 1] };
+    float y[2] = { sp->n[1][i], sp->n[1][i + 1] };
+    float z[2] = { sp->n[2][i], sp->n[2][i + 1] };
+    float d[2] = { sp->d   [i], sp->d   [i + 1] };
+
+    float vn[2], wn[2], on[2], pn[2], s[2];
+
+    SIDE_TIME_OPS(SIDE_PS)
+
+    k[0] = vn[0]; k[1] = vn[1];
+    u[0] = s [0]; u[1] = s [1];
+    a[0] = d [0]; a[1] = d [1];
+}
+
+static void side_out_pair(float out[2],
+                          const struct v_side *sp, int i,
+                          const float Q[3],
+                          const float O[3],
+                          const float W[3], float T)
+{
+    const float q0[2] = { Q[0], Q[0] }, q1[2] = { Q[1], Q[1] };
+    const float q2[2] = { Q[2], Q[2] };
+    const float o0[2] = { O[0], O[0] }, o1[2] = { O[1], O[1] };
+    const float o2[2] = { O[2], O[2] };
+    const float w0[2] = { W[0], W[0] }, w1[2] = { W[1], W[1] };
+    const float w2[2] = { W[2], W[2] };
+    const float t [2] = { T,    T    };
+
+    float x[2] = { sp->n[0][i], sp->n[0][i + 1] };
+    float y[2] = { sp->n[1][i], sp->n[1][i + 1] };
+    float z[2] = { sp->n[2][i], sp->n[2][i + 1] };
+
+    float qn[2], on[2], wn[2], s[2];
+
+    SIDE_OUT_OPS(SIDE_PS)
+
+    out[0] = qn[0]; out[1] = qn[1];
+}
+
+#endif
+
+static void side_time(float t[4],
+                      const struct v_side *sp,
+                      const float o[3],
+                      const float w[3],
+                      const float p[3],
+                      const float v[3], float r)
+{
+    float k[4], u[4], a[4];
+    int i;
+
+    side_time_pair(k + 0, u + 0, a + 0, sp, 0, o, w, p, v, r);
+    side_time_pair(k + 2, u + 2, a + 2, sp, 2, o, w, p, v, r);
+
+    for (i = 0; i < 4; i++)
+    {
+        t[i] = LARGE;
+
+        if (k[i] < 0.0f)
+        {
+            if (0.0f <= u[i])
+                t[i] = u[i];
+            else if (0.0f <= a[i])
+                t[i] = 0;
+        }
+    }
+}
+
+static int side_out(const struct v_side *sp,
+                    const float q[3],
+                    const float o[3],
+                    const float w[3], float t)
+{
+    float s[4];
+    int i, m = 0;
+
+    side_out_pair(s + 0, sp, 0, q, o, w, t);
+    side_out_pair(s + 2, sp, 2, q, o, w, t);
+
+    for (i = 0; i < 4; i++)
+        if (s[i] > sp->d[i])
+            m |= 1 << i;
+
+    return m;
+}
+
+#elif defined(__SSE__)
+
+static __m128 side_dot(const float v[3], __m128 x, __m128 y, __m128 z)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), x),
+                                 _mm_mul_ps(_mm_set1_ps(v[1]), y)),
+                      _mm_mul_ps(_mm_set1_ps(v[2]), z));
+}
+
+static void side_time(float t[4],
+                      const struct v_side *sp,
+                      const float o[3],
+                      const float w[3],
+                      const float p[3],
+                      const float v[3], float r)
+{
+    const __m128 x = _mm_loadu_ps(sp->n[0]);
+    const __m128 y = _mm_loadu_ps(sp->n[1]);
+    const __m128 z = _mm_loadu_ps(sp->n[2]);
+    const __m128 d = _mm_loadu_ps(sp->d);
+
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 large = _mm_set1_ps(LARGE);
+
+    __m128 k  = _mm_sub_ps(side_dot(v, x, y, z), side_dot(w, x, y, z));
+    __m128 on = side_dot(o, x, y, z);
+    __m128 pn = side_dot(p, x, y, z);
+
+    __m128 u = _mm_div_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_set1_ps(r), d),
+                                                on), pn), k);
+    __m128 a = _mm_div_ps(_mm_sub_ps(_mm_add_ps(d, on), pn), k);
+    __m128 m, s;
+
+    m = _mm_cmple_ps(zero, a);
+    s = _mm_andnot_ps(m, large);
+    m = _mm_cmple_ps(zero, u);
+    s = _mm_or_ps(_mm_and_ps(m, u), _mm_andnot_ps(m, s));
+    m = _mm_cmplt_ps(k, zero);
+    s = _mm_or_ps(_mm_and_ps(m, s), _mm_andnot_ps(m, large));
+
+    _mm_storeu_ps(t, s);
+}
+
+static int side_out(const struct v_side *sp,
+                    const float q[3],
+                    const float o[3],
+                    const float w[3], float t)
+{
+    const __m128 x = _mm_loadu_ps(sp->n[0]);
+    const __m128 y = _mm_loadu_ps(sp->n[1]);
+    const __m128 z = _mm_loadu_ps(sp->n[2]);
+    const __m128 d = _mm_loadu_ps(sp->d);
+
+    __m128 s = _mm_sub_ps(_mm_sub_ps(side_dot(q, x, y, z),
+                                     side_dot(o, x, y, z)),
+                          _mm_mul_ps(side_dot(w, x, y, z), _mm_set1_ps(t)));
+
+    return _mm_movemask_ps(_mm_cmpgt_ps(s, d));
+}
+
+#else
+
+static void side_time(float t[4],
+                      const struct v_side *sp,
+                      const float o[3],
+                      const float w[3],
+                      const float p[3],
+                      const float v[3], float r)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        const float n[3] = { sp->n[0][i], sp->n[1][i], sp->n[2][i] };
+        const float d    =   sp->d[i];
+
+        float vn = v_dot(v, n);
+        float wn = v_dot(w, n);
+
+        t[i] = LARGE;
+
+        if (vn - wn < 0.0f)
+        {
+            float on = v_dot(o, n);
+            float pn = v_dot(p, n);
+
+            float u = (r + d + on - pn) / (vn - wn);
+            float a = (    d + on - pn) / (vn - wn);
+
+            if (0.0f <= u)
+                t[i] = u;
+            else if (0.0f <= a)
+                t[i] = 0;
+        }
+    }
+}
+
+static int side_out(const struct v_side *sp,
+                    const float q[3],
+                    const float o[3],
+                    const float w[3], float t)
+{
+    int i, m = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        const float n[3] = { sp->n[0][i], sp->n[1][i], sp->n[2][i] };
+
+        if (v_dot(q, n) - v_dot(o, n) - v_dot(w, n) * t > sp->d[i])
+            m |= 1 << i;
+    }
+    return m;
+}
+
+#endif
+
 /*---------------------------------------------------------------------------*/
 
 /*
@@ -336,6 +745,55 @@ static float sol_test_side(float dt,
     return t;
 }
 
+/*
+ * Test the sides of a lump in batches.  Keep the nearest side that the
+ * ball reaches on the surface of the lump, as sol_test_side does.
+ */
+static float sol_test_sides(float dt,
+                            float T[3],
+                            const struct v_ball *up,
+                            const struct s_vary *vary,
+                            const struct b_lump *lp,
+                            const float o[3],
+                            const float w[3])
+{
+    const struct v_side *sv = vary->sv + vary->si[lp - vary->base->lv];
+
+    float U[3], t = dt;
+    int i, j, k;
+
+    for (i = 0; i < lp->sc; i += 4)
+    {
+        float u[4];
+
+        side_time(u, sv + i / 4, o, w, up->p, up->v, up->r);
+
+        for (j = i; j < i + 4 && j < lp->sc; j++)
+            if (u[j - i] < t)
+            {
+                const struct b_side *sp = vary->base->sv +
+                                          vary->base->iv[lp->s0 + j];
+
+                v_mad(U, up->p, up->v, +u[j - i]);
+                v_mad(U, U, sp->n, -up->r);
+
+                /* Reject the point if it is outside of any other side. */
+
+                for (k = 0; k < lp->sc; k += 4)
+                    if (side_out(sv + k / 4, U, o, w, u[j - i]) &
+                        ~(k == j - j % 4 ? 1 << (j % 4) : 0))
+                        break;
+
+                if (k >= lp->sc)
+                {
+                    v_cpy(T, U);
+                    t = u[j - i];
+                }
+            }
+    }
+    return t;
+}
+
 /*---------------------------------------------------------------------------*/
 
 static int sol_test_fore(float dt,
@@ -401,11 +859,13 @@ static int sol_test_back(float dt,
 static float sol_test_lump(float dt,
                            float T[3],
                            const struct v_ball *up,
-                           const struct s_base *base,
+                           const struct s_vary *vary,
                            const struct b_lump *lp,
                            const float o[3],
                            const float w[3])
 {
+    const struct s_base *base = vary->base;
+
     float U[3] = { 0.0f, 0.0f, 0.0f };
     float u, t = dt;
     int i;
@@ -444,7 +904,15 @@ static float sol_test_lump(float dt,
 
     /* Test all sides */
 
-    for (i = 0; i < lp->sc; i++)
+    if (vary->sv)
+    {
+        if ((u = sol_test_sides(t, U, up, vary, lp, o, w)) < t)
+        {
+            v_cpy(T, U);
+            t = u;
+        }
+    }
+    else for (i = 0; i < lp->sc; i++)
     {
         const struct b_side *sp = base->sv + base->iv[lp->s0 + i];
 
@@ -460,11 +928,13 @@ static float sol_test_lump(float dt,
 static float sol_test_node(float dt,
                            float T[3],
                            const struct v_ball *up,
-                           const struct s_base *base,
+                           const struct s_vary *vary,
                            const struct b_node *np,
                            const float o[3],
                            const float w[3])
 {
+    const struct s_base *base = vary->base;
+
     float U[3], u, t = dt;
     int i;
 
@@ -474,7 +944,7 @@ static float sol_test_node(float dt,
     {
         const struct b_lump *lp = base->lv + np->l0 + i;
 
-        if ((u = sol_test_lump(t, U, up, base, lp, o, w)) < t)
+        if ((u = sol_test_lump(t, U, up, vary, lp, o, w)) < t)
         {
             v_cpy(T, U);
             t = u;
@@ -487,7 +957,7 @@ static float sol_test_node(float dt,
     {
         const struct b_node *nq = base->nv + np->ni;
 
-        if ((u = sol_test_node(t, U, up, base, nq, o, w)) < t)
+        if ((u = sol_test_node(t, U, up, vary, nq, o, w)) < t)
         {
             v_cpy(T, U);
             t = u;
@@ -500,7 +970,7 @@ static float sol_test_node(float dt,
     {
         const struct b_node *nq = base->nv + np->nj;
 
-        if ((u = sol_test_node(t, U, up, base, nq, o, w)) < t)
+        if ((u = sol_test_node(t, U, up, vary, nq, o, w)) < t)
         {
             v_cpy(T, U);
             t = u;
@@ -510,19 +980,126 @@ static float sol_test_node(float dt,
     return t;
 }
 
+/*
+ * Test the lumps of a bounding volume hierarchy against a ball whose
+ * path through the time interval lies within the box A-B.  R is the BSP
+ * rank of the nearest lump so far, or -1.  A lump reached at the same
+ * time wins only if the BSP walk would have tested it first, so that the
+ * contact is the one sol_test_node finds.
+ */
+static float sol_test_tree(float dt,
+                           float T[3],
+                           int *R,
+                           const struct v_ball *up,
+                           const struct s_vary *vary,
+                           const struct v_node *np,
+                           const float a[3],
+                           const float b[3],
+                           const float o[3],
+                           const float w[3])
+{
+    float U[3], u, t = dt;
+    int i;
+
+    /* Cull nodes that the ball cannot reach. */
+
+    if (b[0] < np->a[0] || np->b[0] < a[0] ||
+        b[1] < np->a[1] || np->b[1] < a[1] ||
+        b[2] < np->a[2] || np->b[2] < a[2])
+        return t;
+
+    /* Test all lumps */
+
+    for (i = 0; i < np->lc; i++)
+    {
+        const int li = vary->iv[np->l0 + i];
+        const int r  = vary->lr[li];
+
+        const struct b_lump *lp = vary->base->lv + li;
+
+        if (*R >= 0 && r < *R)
+        {
+            if ((u = sol_test_lump(nextafterf(t, LARGE),
+                                   U, up, vary, lp, o, w)) <= t)
+            {
+                v_cpy(T, U);
+                t  = u;
+                *R = r;
+            }
+        }
+        else if ((u = sol_test_lump(t, U, up, vary, lp, o, w)) < t)
+        {
+            v_cpy(T, U);
+            t  = u;
+            *R = r;
+        }
+    }
+
+    /* Test both children */
+
+    if (np->ni >= 0)
+        t = sol_test_tree(t, T, R, up, vary, vary->nv + np->ni, a, b, o, w);
+
+    if (np->nj >= 0)
+        t = sol_test_tree(t, T, R, up, vary, vary->nv + np->nj, a, b, o, w);
+
+    return t;
+}
+
+/*
+ * Test the lumps of a body, culling them with the bounding volume
+ * hierarchy of the body if it has one, or else walking its BSP.
+ */
+static float sol_test_root(float dt,
+                           float T[3],
+                           const struct v_ball *up,
+                           const struct s_vary *vary,
+                           const struct v_body *bp,
+                           const float o[3],
+                           const float w[3])
+{
+    if (bp->ni >= 0)
+    {
+        float a[3], b[3], p[3], q[3], r = up->r + SMALL;
+        int i, R = -1;
+
+        /* Find the box swept by the ball relative to the body. */
+
+        v_sub(p, up->p, o);
+        v_sub(q, up->v, w);
+        v_mad(q, p, q, dt);
+
+        for (i = 0; i < 3; i++)
+        {
+            a[i] = MIN(p[i], q[i]) - r;
+            b[i] = MAX(p[i], q[i]) + r;
+        }
+
+        return sol_test_tree(dt, T, &R, up, vary, vary->nv + bp->ni,
+                             a, b, o, w);
+    }
+    else
+    {
+        const struct b_node *np = vary->base->nv + bp->base->ni;
+
+        return sol_test_node(dt, T, up, vary, np, o, w);
+    }
+}
+
 static float sol_test_body(float dt,
                            float T[3], float V[3],
                            const struct v_ball *up,
-                           const struct s_vary *vary,
-                           const struct v_body *bp)
+                           struct s_vary *vary,
+                           struct v_body *bp)
 {
-    float U[3], O[3], E[4], W[3], u;
+    const float *O, *E, *W;
+    float U[3], u;
 
-    const struct b_node *np = vary->base->nv + bp->base->ni;
+    sol_body_cache(vary, bp, dt);
 
-    sol_body_p(O, vary, bp, 0.0f);
-    sol_body_v(W, vary, bp, dt);
-    sol_body_e(E, vary, bp, 0.0f);
+    O = bp->p;
+    E = bp->e;
+    W = bp->v;
 
     /*
      * For rotating bodies, rather than rotate every normal and vertex
@@ -535,7 +1112,7 @@ static float sol_test_body(float dt,
      * v = w x p
      */
 
-    if (E[0] != 1.0f || sol_body_w(vary, bp))
+    if (bp->r)
     {
         /* The body has a non-identity orientation or it is rotating. */
 
@@ -567,7 +1144,7 @@ static float sol_test_body(float dt,
         v_sub(ball.v, p1, p0);
         v_scl(ball.v, ball.v, 1.0f / dt);
 
-        if ((u = sol_test_node(dt, U, &ball, vary->base, np, z, z)) < dt)
+        if ((u = sol_test_root(dt, U, &ball, vary, bp, z, z)) < dt)
         {
             /* Compute the final orientation. */
 
@@ -592,7 +1169,7 @@ static float sol_test_body(float dt,
     }
     else
     {
-        if ((u = sol_test_node(dt, U, up, vary->base, np, O, W)) < dt)
+        if ((u = sol_test_root(dt, U, up, vary, bp, O, W)) < dt)
         {
             v_cpy(T, U);
             v_cpy(V, W);
@@ -605,14 +1182,14 @@ static float sol_test_body(float dt,
 static float sol_test_file(float dt,
                            float T[3], float V[3],
                            const struct v_ball *up,
-                           const struct s_vary *vary)
+                           struct s_vary *vary)
 {
     float U[3], W[3], u, t = dt;
     int i;
 
     for (i = 0; i < vary->bc; i++)
     {
-        const struct v_body *bp = vary->bv + i;
+        struct v_body *bp = vary->bv + i;
 
         if ((u = sol_test_body(t, U, W, up, vary, bp)) < t)
         {
@@ -628,25 +1205,100 @@ static float sol_test_file(float dt,
 
 /*
  * Accumulate and convert simulation time to integer milliseconds.
+ *
+ * Replays depend on the exact rounding of draining the accumulator
+ * one 0.001f tick at a time.  Above MS_BULK, the same float results
+ * are computed a binade at a time: while both operand and result share
+ * an exponent, each subtraction removes the same whole number of ulps,
+ * so a run of ticks collapses into a single division.  Below it, the
+ * at most 32 remaining ticks are cheaper to subtract one by one.
  */
 
+#define MS_TICK 0.001f
+#define MS_BULK 0.032f
+
 static void ms_init(float *accum)
 {
     *accum = 0.0f;
 }
 
+/*
+ * Subtract from F all the ticks that keep it in its binade, plus the
+ * one that takes it out.  Count them in MS.
+ */
+static float ms_bulk(float f, int *ms)
+{
+    const unsigned int l = 1u << 23;
+
+    union { float f; unsigned int i; } a, b;
+    int s;
+
+    a.f = f;
+    b.f = MS_TICK;
+
+    /* Work with significands X and M in ulps of the binade of A. */
+
+    if ((s = (int) (a.i >> 23) - (int) (b.i >> 23)) > 0 && s < 24)
+    {
+        const unsigned int h = 1u << (s - 1);
+
+        unsigned int x = (a.i & (l - 1)) | l;
+        unsigned int m = (b.i & (l - 1)) | l;
+        unsigned int n = m >> s;
+        unsigned int r = m & (2 * h - 1);
+        unsigned int t, d;
+
+        /* A tick stays in the binade while X - M / 2^S >= L. */
+
+        t = l + n + (r ? 1 : 0);
+
+        if (x >= t)
+        {
+            if (r == h)
+            {
+                /* Ties round to even, after which the step is fixed. */
+
+                x = (x - n) & ~1u;
+                d = n + (n & 1);
+
+                *ms += 1;
+            }
+            else
+                d = n + (r > h ? 1 : 0);
+
+            if (x >= t)
+            {
+                unsigned int k = (x - t) / d + 1;
+
+                x   -= k * d;
+                *ms += (int) k;
+            }
+
+            a.i = (a.i & ~(l - 1)) | (x & (l - 1));
+        }
+    }
+
+    *ms += 1;
+
+    return a.f - MS_TICK;
+}
+
 static int ms_step(float *accum, float dt)
 {
-    int ms = 0;
+    float a = *accum + dt;
+    int  ms = 0;
 
-    *accum += dt;
+    while (a >= MS_BULK)
+        a = ms_bulk(a, &ms);
 
-    while (*accum >= 0.001f)
+    while (a >= MS_TICK)
     {
-        *accum -= 0.001f;
+        a  -= MS_TICK;
         ms += 1;
     }
 
+    *accum = a;
+
     return ms;
 }
 
@@ -664,19 +1316,10 @@ static int ms_peek(float *accum, float dt)
  */
 static float sol_path_time(struct s_vary *vary, float dt)
 {
-    int mi;
-
-    for (mi = 0; mi < vary->mc; mi++)
-    {
-        struct v_move *mp = vary->mv + mi;
-        struct v_path *pp = vary->pv + mp->pi;
+    int ms = sol_move_next(vary);
 
-        if (!pp->f)
-            continue;
-
-        if (mp->tm + ms_peek(&vary->ms_accum, dt) > pp->base->tm)
-            dt = MS_TO_TIME(pp->base->tm - mp->tm);
-    }
+    if (ms >= 0 && ms_peek(&vary->ms_accum, dt) > ms)
+        dt = MS_TO_TIME(ms);
 
     return dt;
 }
@@ -711,13 +1354,69 @@ void sol_move(struct s_vary *vary, cmd_fn cmd_func, float dt)
     {
         while (dt > 0.0f)
         {
-            float pt = sol_path_time(vary, dt);
-            sol_move_once(vary, cmd_func, pt);
+            float pt;
+
+            PROF(path_time, pt = sol_path_time(vary, dt));
+            PROF(move_once, sol_move_once(vary, cmd_func, pt));
+
             dt -= pt;
         }
     }
 }
 
+/*
+ * Accelerate ball UP under gravity G for DT seconds.  If the ball is in
+ * contact with a surface, apply friction instead, counting in M a ball
+ * brought to a stop.
+ */
+static void sol_step_ball(struct s_vary *vary, struct v_ball *up,
+                          const float *g, float dt, int *m)
+{
+    float P[3], V[3], v[3], r[3], d, t = LARGE;
+
+    v_cpy(v, up->v);
+    v_cpy(up->v, g);
+
+    if (m)
+        PROF(test_file, t = sol_test_file(dt, P, V, up, vary));
+
+    if (t < 0.0005f)
+    {
+        v_cpy(up->v, v);
+        v_sub(r, P, up->p);
+
+        if ((d = v_dot(r, g) / (v_len(r) * v_len(g))) > 0.999f)
+        {
+            if (v_len(up->v) > dt)
+            {
+                /* Scale the linear velocity. */
+
+                v_sub(v, V, up->v);
+                v_nrm(v, v);
+                v_mad(up->v, up->v, v, dt);
+
+                /* Scale the angular velocity. */
+
+                v_sub(v, V, up->v);
+                v_crs(up->w, v, r);
+                v_scl(up->w, up->w, -1.0f / (up->r * up->r));
+            }
+            else
+            {
+                /* Friction has brought the ball to a stop. */
+
+                up->v[0] = 0.0f;
+                up->v[1] = 0.0f;
+                up->v[2] = 0.0f;
+
+                (*m)++;
+            }
+        }
+        else v_mad(up->v, v, g, dt);
+    }
+    else v_mad(up->v, v, g, dt);
+}
+
 /*
  * Step the physics forward DT  seconds under the influence of gravity
  * vector G.  If the ball gets pinched between two moving solids, this
@@ -729,54 +1428,16 @@ void sol_move(struct s_vary *vary, cmd_fn cmd_func, float dt)
 float sol_step(struct s_vary *vary, cmd_fn cmd_func,
                const float *g, float dt, int ui, int *m)
 {
-    float P[3], V[3], v[3], r[3], a[3], d, nt, b = 0.0f, tt = dt;
+    float P[3], V[3], a[3], d, nt, b = 0.0f, tt = dt;
     int c;
 
     if (ui < vary->uc)
     {
         struct v_ball *up = vary->uv + ui;
 
-        /* If the ball is in contact with a surface, apply friction. */
-
         v_cpy(a, up->v);
-        v_cpy(v, up->v);
-        v_cpy(up->v, g);
-
-        if (m && sol_test_file(tt, P, V, up, vary) < 0.0005f)
-        {
-            v_cpy(up->v, v);
-            v_sub(r, P, up->p);
-
-            if ((d = v_dot(r, g) / (v_len(r) * v_len(g))) > 0.999f)
-            {
-                if (v_len(up->v) > dt)
-                {
-                    /* Scale the linear velocity. */
-
-                    v_sub(v, V, up->v);
-                    v_nrm(v, v);
-                    v_mad(up->v, up->v, v, dt);
-
-                    /* Scale the angular velocity. */
 
-                    v_sub(v, V, up->v);
-                    v_crs(up->w, v, r);
-                    v_scl(up->w, up->w, -1.0f / (up->r * up->r));
-                }
-                else
-                {
-                    /* Friction has brought the ball to a stop. */
-
-                    up->v[0] = 0.0f;
-                    up->v[1] = 0.0f;
-                    up->v[2] = 0.0f;
-
-                    (*m)++;
-                }
-            }
-            else v_mad(up->v, v, g, tt);
-        }
-        else v_mad(up->v, v, g, tt);
+        sol_step_ball(vary, up, g, dt, m);
 
         /* Test for collision. */
 
@@ -786,16 +1447,16 @@ float sol_step(struct s_vary *vary, cmd_fn cmd_func,
 
             /* Avoid stepping across path changes. */
 
-            pt = sol_path_time(vary, tt);
+            PROF(path_time, pt = sol_path_time(vary, tt));
 
             /* Miss collisions if we reach the iteration limit. */
 
             if (c > 1)
-                nt = sol_test_file(pt, P, V, up, vary);
+                PROF(test_file, nt = sol_test_file(pt, P, V, up, vary));
             else
                 nt = tt;
 
-            sol_move_once(vary, cmd_func, nt);
+            PROF(move_once, sol_move_once(vary, cmd_func, nt));
 
             if (nt < pt)
                 if (b < (d = sol_bounce(up, P, V, nt)))
@@ -812,11 +1473,96 @@ float sol_step(struct s_vary *vary, cmd_fn cmd_func,
     return b;
 }
 
+/*
+ * Step all balls that are awake, as sol_step does for one.  The world
+ * moves once for all of them: each pass advances to the earliest
+ * contact of any ball, and that ball bounces.  Path scheduling and body
+ * transforms are thus shared by all balls.  The iteration limit grows
+ * with the number of balls, each of which may need passes of its own.
+ */
+
+float sol_step_all(struct s_vary *vary, cmd_fn cmd_func,
+                   const float *g, float dt, int *m)
+{
+    float P[3], V[3], U[3], W[3], a[3], d, u, nt, b = 0.0f, tt = dt;
+    int c, n = 0, ui, uj;
+
+    for (ui = 0; ui < vary->uc; ui++)
+    {
+        struct v_ball *up = vary->uv + ui;
+
+        if (!up->s)
+        {
+            v_cpy(up->a, up->v);
+
+            sol_step_ball(vary, up, g, dt, m);
+
+            n++;
+        }
+    }
+
+    for (c = 16 * n; c > 0 && tt > 0; c--)
+    {
+        float pt;
+
+        /* Avoid stepping across path changes. */
+
+        PROF(path_time, pt = sol_path_time(vary, tt));
+
+        /* Find the earliest contact, missing all at the limit. */
+
+        nt = (c > 1) ? pt : tt;
+        uj = -1;
+
+        if (c > 1)
+            for (ui = 0; ui < vary->uc; ui++)
+            {
+                struct v_ball *up = vary->uv + ui;
+
+                if (up->s)
+                    continue;
+
+                PROF(test_file, u = sol_test_file(nt, U, W, up, vary));
+
+                if (u < nt)
+                {
+                    v_cpy(P, U);
+                    v_cpy(V, W);
+                    nt = u;
+                    uj = ui;
+                }
+            }
+
+        PROF(move_once, sol_move_once(vary, cmd_func, nt));
+
+        if (uj >= 0)
+            if (b < (d = sol_bounce(vary->uv + uj, P, V, nt)))
+                b = d;
+
+        tt -= nt;
+    }
+
+    for (ui = 0; ui < vary->uc; ui++)
+    {
+        struct v_ball *up = vary->uv + ui;
+
+        if (!up->s)
+        {
+            v_sub(a, up->v, up->a);
+
+            sol_pendulum(up, a, g, dt);
+        }
+    }
+
+    return b;
+}
+
 /*---------------------------------------------------------------------------*/
 
 void sol_init_sim(struct s_vary *vary)
 {
     ms_init(&vary->ms_accum);
+    sol_move_init(vary);
 }
 
 void sol_quit_sim(void)
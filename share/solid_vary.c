@@ -13,13 +13,467 @@
  */
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "solid_vary.h"
+#include "solid_all.h"
 #include "common.h"
 #include "vec3.h"
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Lumps per bounding volume leaf.  Below this, testing the lumps is
+ * cheaper than testing more boxes.
+ */
+#define TREE_LEAF 4
+
+static const float (*tree_box)[6];
+static int          tree_axis;
+
+static int tree_cmp(const void *p, const void *q)
+{
+    const float *a = tree_box[*(const int *) p];
+    const float *b = tree_box[*(const int *) q];
+
+    float c = a[tree_axis] + a[tree_axis + 3];
+    float d = b[tree_axis] + b[tree_axis + 3];
+
+    if (c < d) return -1;
+    if (c > d) return +1;
+
+    return *(const int *) p - *(const int *) q;
+}
+
+/*
+ * Compute the bounding box of a lump from its vertices.
+ */
+static int tree_lump_box(const struct s_base *base,
+                         const struct b_lump *lp, float box[6])
+{
+    int i, j;
+
+    if (lp->vc == 0)
+        return 0;
+
+    for (i = 0; i < lp->vc; i++)
+    {
+        const float *p = base->vv[base->iv[lp->v0 + i]].p;
+
+        for (j = 0; j < 3; j++)
+        {
+            if (i == 0 || p[j] < box[j])     box[j]     = p[j];
+            if (i == 0 || p[j] > box[j + 3]) box[j + 3] = p[j];
+        }
+    }
+    return 1;
+}
+
+/*
+ * Recursively sort the lump indices IV[L0] through IV[L0 + LC - 1]
+ * into a hierarchy of bounding boxes.  Return the index of the root.
+ */
+static int tree_node(struct s_vary *fp, const float (*box)[6], int l0, int lc)
+{
+    struct v_node *np = fp->nv + fp->nc;
+    int i, j, ni = fp->nc++;
+
+    for (i = 0; i < lc; i++)
+    {
+        const float *b = box[fp->iv[l0 + i]];
+
+        for (j = 0; j < 3; j++)
+        {
+            if (i == 0 || b[j]     < np->a[j]) np->a[j] = b[j];
+            if (i == 0 || b[j + 3] > np->b[j]) np->b[j] = b[j + 3];
+        }
+    }
+
+    np->ni = -1;
+    np->nj = -1;
+    np->l0 = l0;
+    np->lc = lc;
+
+    if (lc > TREE_LEAF)
+    {
+        float d[3];
+
+        /* Split at the median along the longest axis of the box. */
+
+        v_sub(d, np->b, np->a);
+
+        tree_axis = 0;
+
+        if (d[1] > d[tree_axis]) tree_axis = 1;
+        if (d[2] > d[tree_axis]) tree_axis = 2;
+
+        tree_box = box;
+
+        qsort(fp->iv + l0, lc, sizeof (*fp->iv), tree_cmp);
+
+        /* The node array is preallocated, so NP survives the recursion. */
+
+        np->ni = tree_node(fp, box, l0,          lc / 2);
+        np->nj = tree_node(fp, box, l0 + lc / 2, lc - lc / 2);
+        np->l0 = 0;
+        np->lc = 0;
+    }
+    return ni;
+}
+
+/*
+ * Number the lumps in the order the BSP walk of sol_test_node visits
+ * them, which decides between lumps that the ball reaches at once.
+ */
+static void tree_rank(struct s_vary *fp, int ni, int *k)
+{
+    const struct b_node *np = fp->base->nv + ni;
+    int i;
+
+    for (i = 0; i < np->lc; i++)
+        fp->lr[np->l0 + i] = (*k)++;
+
+    if (np->ni >= 0) tree_rank(fp, np->ni, k);
+    if (np->nj >= 0) tree_rank(fp, np->nj, k);
+}
+
+static void sol_load_tree(struct s_vary *fp)
+{
+    const struct s_base *base = fp->base;
+
+    float (*box)[6];
+    int i, j;
+
+    if (!base->lc || !(box = calloc(base->lc, sizeof (*box))))
+        return;
+
+    /* Each leaf holds at least one lump, so 2N nodes always suffice. */
+
+    fp->iv = calloc(base->lc,     sizeof (*fp->iv));
+    fp->nv = calloc(base->lc * 2, sizeof (*fp->nv));
+    fp->lr = calloc(base->lc,     sizeof (*fp->lr));
+
+    if (fp->iv && fp->nv && fp->lr)
+    {
+        for (i = 0; i < fp->bc; i++)
+        {
+            const struct b_body *bp = fp->bv[i].base;
+            int l0 = fp->ic;
+            int k  = 0;
+
+            if (bp->ni >= 0)
+                tree_rank(fp, bp->ni, &k);
+
+            /* Gather the solid lumps of this body. */
+
+            for (j = 0; j < bp->lc; j++)
+            {
+                const struct b_lump *lp = base->lv + bp->l0 + j;
+
+                if (lp->fl & L_DETAIL)
+                    continue;
+
+                /* Can't bound it, fall back to the BSP for this body. */
+
+                if (!tree_lump_box(base, lp, box[bp->l0 + j]))
+                    break;
+
+                fp->iv[fp->ic++] = bp->l0 + j;
+            }
+
+            if (j < bp->lc || fp->ic == l0)
+                fp->ic = l0;
+            else
+                fp->bv[i].ni = tree_node(fp, (const float (*)[6]) box,
+                                         l0, fp->ic - l0);
+        }
+    }
+    free(box);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void sol_load_side(struct s_vary *fp)
+{
+    const struct s_base *base = fp->base;
+    int i, j, k;
+
+    if (base->lc <= 0)
+        return;
+
+    for (i = 0; i < base->lc; i++)
+        fp->sc += (base->lv[i].sc + 3) / 4;
+
+    fp->si = calloc(base->lc, sizeof (*fp->si));
+    fp->sv = calloc(fp->sc,   sizeof (*fp->sv));
+
+    if (!fp->si || !fp->sv)
+    {
+        free(fp->si);
+        free(fp->sv);
+
+        fp->sc = 0;
+        fp->si = NULL;
+        fp->sv = NULL;
+        return;
+    }
+
+    for (k = 0, i = 0; i < base->lc; i++)
+    {
+        const struct b_lump *lp = base->lv + i;
+
+        fp->si[i] = k;
+
+        for (j = 0; j < lp->sc; j++)
+        {
+            const struct b_side *sp = base->sv + base->iv[lp->s0 + j];
+            struct v_side *sq = fp->sv + k + j / 4;
+
+            sq->n[0][j % 4] = sp->n[0];
+            sq->n[1][j % 4] = sp->n[1];
+            sq->n[2][j % 4] = sp->n[2];
+            sq->d   [j % 4] = sp->d;
+        }
+        k += (lp->sc + 3) / 4;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Grid cells are sized for about one entity each, but no smaller than
+ * GRID_CELL and no more than GRID_MAX to a side.  GRID_SLACK widens
+ * queries to cover rounding in the tests that use them.
+ */
+#define GRID_CELL  1.0f
+#define GRID_MAX   64
+#define GRID_SLACK 0.01f
+
+static int grid_cell(float x, float a, float k, int w)
+{
+    float c = (x - a) * k;
+
+    if (!(c >= 0.0f))
+        return 0;
+    if (c >= (float) w)
+        return w - 1;
+
+    return (int) c;
+}
+
+static int grid_index(const struct v_grid *gp, const float p[3])
+{
+    return (grid_cell(p[2], gp->a[1], gp->k, gp->h) * gp->w +
+            grid_cell(p[0], gp->a[0], gp->k, gp->w));
+}
+
+/*
+ * Count the cells needed to cover a span of D cells.  Positions are not
+ * checked on load, so a span may be anything, NaN included.
+ */
+static int grid_size(float d)
+{
+    return (d >= 0.0f && d < (float) GRID_MAX) ? (int) d + 1 : GRID_MAX;
+}
+
+/*
+ * Build a grid of the N entities of size SIZE at V, each positioned by
+ * the vector at offset OFF.
+ */
+static int grid_init(struct v_grid *gp, const void *v, size_t size, size_t off,
+                     int n, float r)
+{
+    float a[2] = { 0.0f, 0.0f };
+    float b[2] = { 0.0f, 0.0f };
+    float s;
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        const float *p = (const float *) ((const char *) v + size * i + off);
+
+        if (i == 0 || p[0] < a[0]) a[0] = p[0];
+        if (i == 0 || p[2] < a[1]) a[1] = p[2];
+        if (i == 0 || p[0] > b[0]) b[0] = p[0];
+        if (i == 0 || p[2] > b[1]) b[1] = p[2];
+    }
+
+    s = n ? fsqrtf((b[0] - a[0]) * (b[1] - a[1]) / n) : GRID_CELL;
+    s = MAX(s, GRID_CELL);
+
+    gp->a[0] = a[0];
+    gp->a[1] = a[1];
+    gp->k    = 1.0f / s;
+    gp->r    = r;
+    gp->w    = grid_size((b[0] - a[0]) / s);
+    gp->h    = grid_size((b[1] - a[1]) / s);
+    gp->n    = n;
+
+    if (!(gp->cv = malloc(gp->w * gp->h * sizeof (*gp->cv))))
+        return 0;
+
+    for (i = 0; i < gp->w * gp->h; i++)
+        gp->cv[i] = -1;
+
+    if (n && !(gp->iv = malloc(n * sizeof (*gp->iv))))
+        return 0;
+    if (n && !(gp->qv = malloc(n * sizeof (*gp->qv))))
+        return 0;
+
+    /* Walk backward so that pushing onto each list keeps index order. */
+
+    for (i = n - 1; i >= 0; i--)
+    {
+        const float *p = (const float *) ((const char *) v + size * i + off);
+        const int c = grid_index(gp, p);
+
+        gp->iv[i] = gp->cv[c];
+        gp->cv[c] = i;
+    }
+    return 1;
+}
+
+static void grid_free(struct v_grid *gp)
+{
+    free(gp->cv);
+    free(gp->iv);
+    free(gp->qv);
+}
+
+static void grid_clear(struct v_grid *gp)
+{
+    int i;
+
+    if (gp->cv)
+        for (i = 0; i < gp->w * gp->h; i++)
+            gp->cv[i] = -1;
+}
+
+/*
+ * File entity I at P, keeping its cell in index order.
+ */
+static void grid_add(struct v_grid *gp, int i, const float p[3])
+{
+    int *ip;
+
+    if (!gp->cv)
+        return;
+
+    if (i >= gp->n)
+    {
+        int n = MAX(i + 1, gp->n * 2);
+
+        if (!(ip = realloc(gp->qv, n * sizeof (*ip))))
+            return;
+
+        gp->qv = ip;
+
+        if (!(ip = realloc(gp->iv, n * sizeof (*ip))))
+            return;
+
+        gp->iv = ip;
+        gp->n  = n;
+    }
+
+    for (ip = gp->cv + grid_index(gp, p); *ip >= 0 && *ip < i; ip = gp->iv + *ip)
+        ;
+
+    gp->iv[i] = *ip;
+    *ip = i;
+}
+
+static void grid_del(struct v_grid *gp, int i, const float p[3])
+{
+    int *ip;
+
+    if (!gp->cv)
+        return;
+
+    for (ip = gp->cv + grid_index(gp, p); *ip >= 0; ip = gp->iv + *ip)
+        if (*ip == i)
+        {
+            *ip = gp->iv[i];
+            break;
+        }
+}
+
+/*
+ * Compute the range of cells C = { x0, z0, x1, z1 } that may hold an
+ * entity reaching within R of P.
+ */
+static void grid_rect(const struct v_grid *gp, const float p[3], float r,
+                      int c[4])
+{
+    if (gp->cv)
+    {
+        r += gp->r + GRID_SLACK;
+
+        c[0] = grid_cell(p[0] - r, gp->a[0], gp->k, gp->w);
+        c[1] = grid_cell(p[2] - r, gp->a[1], gp->k, gp->h);
+        c[2] = grid_cell(p[0] + r, gp->a[0], gp->k, gp->w);
+        c[3] = grid_cell(p[2] + r, gp->a[1], gp->k, gp->h);
+    }
+    else
+    {
+        c[0] = c[1] =  0;
+        c[2] = c[3] = -1;
+    }
+}
+
+/*
+ * Gather into QV, in index order, the entities that may reach within R
+ * of P.  Return their count.
+ */
+int sol_grid_near(struct v_grid *gp, const float p[3], float r)
+{
+    int c[4], x, z, i, j, k, n = 0;
+
+    grid_rect(gp, p, r, c);
+
+    for (z = c[1]; z <= c[3]; z++)
+        for (x = c[0]; x <= c[2]; x++)
+            for (i = gp->cv[z * gp->w + x]; i >= 0; i = gp->iv[i])
+            {
+                /* Lists are short and mostly in order already. */
+
+                for (j = n; j > 0 && gp->qv[j - 1] > i; j--)
+                    ;
+                for (k = n; k > j; k--)
+                    gp->qv[k] = gp->qv[k - 1];
+
+                gp->qv[j] = i;
+                n++;
+            }
+
+    return n;
+}
+
+static void sol_load_grid(struct s_vary *fp)
+{
+    const struct s_base *base = fp->base;
+
+    float zr = 0.0f;
+    float jr = 0.0f;
+    float xr = 0.0f;
+    int i;
+
+    for (i = 0; i < base->zc; i++) zr = MAX(zr, base->zv[i].r);
+    for (i = 0; i < base->jc; i++) jr = MAX(jr, base->jv[i].r);
+    for (i = 0; i < base->xc; i++) xr = MAX(xr, base->xv[i].r);
+
+    grid_init(&fp->hg, fp->hv, sizeof (*fp->hv),
+              offsetof(struct v_item, p), fp->hc, 0.0f);
+    grid_init(&fp->zg, base->zv, sizeof (*base->zv),
+              offsetof(struct b_goal, p), base->zc, zr);
+    grid_init(&fp->jg, base->jv, sizeof (*base->jv),
+              offsetof(struct b_jump, p), base->jc, jr);
+    grid_init(&fp->xg, base->xv, sizeof (*base->xv),
+              offsetof(struct b_swch, p), base->xc, xr);
+}
+
+/*---------------------------------------------------------------------------*/
+
 int sol_load_vary(struct s_vary *fp, struct s_base *base)
 {
     int i;
@@ -62,6 +516,7 @@ int sol_load_vary(struct s_vary *fp, struct s_base *base)
 
             vbody->mi = -1;
             vbody->mj = -1;
+            vbody->ni = -1;
 
             if (bbody->pi >= 0 && (vmove = alloc_add(&mv)))
             {
@@ -69,6 +524,7 @@ int sol_load_vary(struct s_vary *fp, struct s_base *base)
 
                 vbody->mi = fp->mc - 1;
                 vmove->pi = bbody->pi;
+                vmove->qi = -1;
             }
 
             if (bbody->pj == bbody->pi)
@@ -81,8 +537,14 @@ int sol_load_vary(struct s_vary *fp, struct s_base *base)
 
                 vbody->mj = fp->mc - 1;
                 vmove->pi = bbody->pj;
+                vmove->qi = -1;
             }
         }
+
+        /* Queue the movers now, for varies that never reach sol_init_sim. */
+
+        if (fp->mc && (fp->qv = calloc(fp->mc, sizeof (*fp->qv))))
+            sol_move_init(fp);
     }
 
     if (fp->base->hc)
@@ -147,6 +609,10 @@ int sol_load_vary(struct s_vary *fp, struct s_base *base)
         }
     }
 
+    sol_load_tree(fp);
+    sol_load_side(fp);
+    sol_load_grid(fp);
+
     return 1;
 }
 
@@ -155,9 +621,20 @@ void sol_free_vary(struct s_vary *fp)
     free(fp->pv);
     free(fp->bv);
     free(fp->mv);
+    free(fp->qv);
     free(fp->hv);
     free(fp->xv);
     free(fp->uv);
+    free(fp->nv);
+    free(fp->iv);
+    free(fp->lr);
+    free(fp->sv);
+    free(fp->si);
+
+    grid_free(&fp->hg);
+    grid_free(&fp->zg);
+    grid_free(&fp->jg);
+    grid_free(&fp->xg);
 
     memset(fp, 0, sizeof (*fp));
 }
@@ -167,14 +644,60 @@ void sol_free_vary(struct s_vary *fp)
 int sol_vary_cmd(struct s_vary *fp, struct cmd_state *cs, const union cmd *cmd)
 {
     struct v_ball *up;
+    struct v_item *hp;
+    int idx;
     int rc = 0;
 
     switch (cmd->type)
     {
+    case CMD_MAKE_ITEM:
+        if ((hp = realloc(fp->hv, sizeof (*hp) * (fp->hc + 1))))
+        {
+            fp->hv = hp;
+            hp = &fp->hv[fp->hc];
+
+            memset(hp, 0, sizeof (*hp));
+
+            v_cpy(hp->p, cmd->mkitem.p);
+
+            hp->t = cmd->mkitem.t;
+            hp->n = cmd->mkitem.n;
+
+            grid_add(&fp->hg, fp->hc, hp->p);
+
+            fp->hc++;
+            rc = 1;
+        }
+        break;
+
+    case CMD_PICK_ITEM:
+        if ((idx = cmd->pkitem.hi) >= 0 && idx < fp->hc)
+        {
+            hp = &fp->hv[idx];
+
+            if (hp->t != ITEM_NONE)
+                grid_del(&fp->hg, idx, hp->p);
+
+            hp->t = ITEM_NONE;
+            rc = 1;
+        }
+        break;
+
+    case CMD_CLEAR_ITEMS:
+        free(fp->hv);
+        fp->hv = NULL;
+        fp->hc = 0;
+
+        grid_clear(&fp->hg);
+        break;
+
     case CMD_MAKE_BALL:
         if ((up = realloc(fp->uv, sizeof (*up) * (fp->uc + 1))))
         {
             fp->uv = up;
+
+            memset(fp->uv + fp->uc, 0, sizeof (*up));
+
             cs->curr_ball = fp->uc;
             fp->uc++;
             rc = 1;
@@ -37,6 +37,62 @@ struct v_body
 
     int mi;
     int mj;
+
+    int ni;                                    /* bounding volume root       */
+
+    /* Transform cache, valid while the movers match the key. */
+
+    int   kv;                                  /* key is valid               */
+    float kt[2];                               /* key: mover times           */
+    int   kp[2];                               /* key: mover paths           */
+    int   kf[2];                               /* key: mover path flags      */
+
+    float p[3];                                /* position                   */
+    float e[4];                                /* orientation                */
+    int   r;                                   /* rotated or rotating?       */
+    float v[3];                                /* velocity over DV           */
+    float dv;
+};
+
+struct v_node
+{
+    float a[3];                                /* bounding box minimum       */
+    float b[3];                                /* bounding box maximum       */
+
+    int ni;                                    /* first child, or -1         */
+    int nj;                                    /* second child, or -1        */
+    int l0;                                    /* first lump index (leaf)    */
+    int lc;                                    /* lump index count (leaf)    */
+};
+
+/*
+ * Four side planes of a lump, component by component, for testing in
+ * a batch.  Unused planes are zero.
+ */
+struct v_side
+{
+    float n[3][4];                             /* normal vectors             */
+    float d[4];                                /* distances from origin      */
+};
+
+/*
+ * Uniform grid over the XZ plane.  Each entity is filed under the one
+ * cell holding its position; queries widen by the largest entity
+ * radius.  The entities of a cell form a list in index order.
+ */
+struct v_grid
+{
+    float a[2];                                /* origin (x, z)              */
+    float k;                                   /* cells per unit length      */
+    float r;                                   /* largest entity radius      */
+
+    int w;                                     /* cells along x              */
+    int h;                                     /* cells along z              */
+    int n;                                     /* entity capacity            */
+
+    int *cv;                                   /* first entity of each cell  */
+    int *iv;                                   /* next entity, or -1         */
+    int *qv;                                   /* query scratch              */
 };
 
 struct v_move
@@ -45,6 +101,9 @@ struct v_move
     int   tm;                                  /* milliseconds               */
 
     int pi;
+
+    int qt;                                    /* time of next path change   */
+    int qi;                                    /* queue position, or -1      */
 };
 
 struct v_item
@@ -73,6 +132,9 @@ struct v_ball
     float E[3][3];                             /* basis of pendulum          */
     float W[3];                                /* angular pendulum velocity  */
     float r;                                   /* radius                     */
+
+    float a[3];                                /* velocity before step       */
+    int   s;                                   /* asleep?                    */
 };
 
 struct s_vary
@@ -85,6 +147,8 @@ struct s_vary
     int hc;
     int xc;
     int uc;
+    int nc;
+    int ic;
 
     struct v_path *pv;
     struct v_body *bv;
@@ -92,6 +156,28 @@ struct s_vary
     struct v_item *hv;
     struct v_swch *xv;
     struct v_ball *uv;
+    struct v_node *nv;
+    int           *iv;
+    int           *lr;                         /* BSP visit rank of lumps    */
+
+    /* Side planes of each lump, starting at side group SI. */
+
+    int            sc;
+    struct v_side *sv;
+    int           *si;
+
+    /* Grids of items, goals, jumps and switches. */
+
+    struct v_grid hg;
+    struct v_grid zg;
+    struct v_grid jg;
+    struct v_grid xg;
+
+    /* Movers on active paths, queued by time of next path change. */
+
+    int  tm;
+    int  qc;
+    int *qv;
 
     /* Accumulator for tracking time in integer milliseconds. */
 
@@ -103,6 +189,8 @@ struct s_vary
 int  sol_load_vary(struct s_vary *, struct s_base *);
 void sol_free_vary(struct s_vary *);
 
+int  sol_grid_near(struct v_grid *, const float p[3], float r);
+
 /*---------------------------------------------------------------------------*/
 
 /*
@@ -146,6 +234,8 @@ void sol_lerp_copy(struct s_lerp *);
 void sol_lerp_apply(struct s_lerp *, float);
 int  sol_lerp_cmd(struct s_lerp *, struct cmd_state *, const union cmd *);
 
+int  sol_vary_cmd(struct s_vary *, struct cmd_state *, const union cmd *);
+
 /*---------------------------------------------------------------------------*/
 
 #endif
@@ -8,6 +8,7 @@
 #include <ogc/lwp_watchdog.h>
 
 #include "wiigl.h"
+#include "gxtex.h"
 #include "log.h"
 
 #define DEBUG
@@ -52,18 +53,44 @@ struct Buffer
 {
     void *data;
     u32 size;
+    u32 stamp;                  // changes whenever the contents do
+    struct DispList *dispLists; // compiled from this buffer's indices
 };
 
 struct Buffer *boundBuffers[2];
+static u32 bufferStamp;
+
+// A glDrawElements call compiled into a GX display list. The list holds only
+// the primitive and its indices, so the arrays and the rest of the state are
+// still set up for every call. It is only valid for the vertex buffer it was
+// compiled against, as long as that buffer's contents stay the same.
+struct DispList
+{
+    struct DispList *next;
+    struct Buffer *vbo;
+    u32 vboStamp;
+    uintptr_t offset;
+    GLsizei count;
+    u8 mode;
+    GLenum type;
+    u8 arrays;
+    void *list;  // NULL if the draw didn't fit into a display list
+    u32 size;
+};
 
 struct VtxDesc
 {
     int components;
     int format;
     int stride;
+    int frac;     // fraction bits of fixed point components
     const void *pointer;
+    bool client;  // pointer is in client memory, not a buffer object
 };
 
+// The vertex cache only needs flushing when array data may have changed
+static bool vtxCacheDirty = true;
+
 static struct VtxDesc posDesc;
 static struct VtxDesc colorDesc;
 static struct VtxDesc texCoordDesc;
@@ -74,6 +101,9 @@ struct Texture
     GXTexObj texObj;
     bool initialized;
     void *imgBuffer;
+    bool opaque;
+    bool genMipmap;
+    u8 lods;
     u8 magFilter;
     u8 minFilter;
 };
@@ -181,6 +211,260 @@ static void flush_mem_range(const void *mem, u32 length)
     DCStoreRange((void *)mem, length);
 }
 
+//------------------------------------------------------------------------------
+// GX State Cache
+//------------------------------------------------------------------------------
+
+// Shadow copies of the GX state set by this wrapper, so that GX is only written
+// when a value really changes. A set bit in gxDirty means the shadow copy can't
+// be trusted and the next write must go through.
+
+#define DIRTY_ZMODE       (1ull << 0)
+#define DIRTY_CULL        (1ull << 1)
+#define DIRTY_BLEND       (1ull << 2)
+#define DIRTY_TEV0        (1ull << 3)
+#define DIRTY_TEVREG(n)   (1ull << (4 + (n)))  // 4 registers
+#define DIRTY_NUMCHANS    (1ull << 8)
+#define DIRTY_CHANCTRL    (1ull << 9)
+#define DIRTY_AMBCOLOR    (1ull << 10)
+#define DIRTY_MATCOLOR    (1ull << 11)
+#define DIRTY_TEXOBJ      (1ull << 12)
+#define DIRTY_PROJ        (1ull << 13)
+#define DIRTY_VTXDESC(a)  (1ull << (16 + (a) - GX_VA_POS))  // POS to TEX0
+#define DIRTY_VTXFMT(a)   (1ull << (24 + (a) - GX_VA_POS))
+#define DIRTY_ARRAY(a)    (1ull << (32 + (a) - GX_VA_POS))
+#define DIRTY_LIGHT(n)    (1ull << (40 + (n)))
+#define DIRTY_ALL         (~0ull)
+
+#define VTX_SLOTS (GX_VA_TEX0 - GX_VA_POS + 1)
+
+static u64 gxDirty = DIRTY_ALL;
+
+static struct
+{
+    u8 zEnable;
+    u8 zFunc;
+    u8 zUpdate;
+    u8 cullMode;
+    u8 blendSrc;
+    u8 blendDst;
+    u8 tev0In[4];
+    GXColor tevReg[4];
+    u8 numChans;
+    u8 chanLights;
+    GXColor ambColor;
+    GXColor matColor;
+    GXTexObj *texObj;
+    bool projOffset;
+    float projOffsetUnits;
+    u8 projType;
+    u8 vtxDesc[VTX_SLOTS];
+    u8 vtxCnt[VTX_SLOTS];
+    u8 vtxFmt[VTX_SLOTS];
+    u8 vtxFrac[VTX_SLOTS];
+    const void *arrayPtr[VTX_SLOTS];
+    u8 arrayStride[VTX_SLOTS];
+    GXLightObj lights[8];
+} gxShadow;
+
+static struct wiigl_stats frameStats;
+static struct wiigl_stats lastFrameStats;
+
+// Returns whether a GX write must be made, and counts it either way
+static bool need_write(u64 dirtyBit, bool same, int kind)
+{
+    if (same && !(gxDirty & dirtyBit))
+    {
+        frameStats.avoided[kind]++;
+        return false;
+    }
+    gxDirty &= ~dirtyBit;
+    frameStats.written[kind]++;
+    return true;
+}
+
+static bool same_color(GXColor a, GXColor b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static void set_z_mode(u8 enable, u8 func, u8 update)
+{
+    bool same = gxShadow.zEnable == enable && gxShadow.zFunc == func && gxShadow.zUpdate == update;
+
+    if (need_write(DIRTY_ZMODE, same, WIIGL_STATE_PIXEL))
+    {
+        gxShadow.zEnable = enable;
+        gxShadow.zFunc = func;
+        gxShadow.zUpdate = update;
+        GX_SetZMode(enable, func, update);
+    }
+}
+
+static void set_cull_mode(u8 mode)
+{
+    if (need_write(DIRTY_CULL, gxShadow.cullMode == mode, WIIGL_STATE_PIXEL))
+    {
+        gxShadow.cullMode = mode;
+        GX_SetCullMode(mode);
+    }
+}
+
+static void set_blend_mode(u8 src, u8 dst)
+{
+    if (need_write(DIRTY_BLEND, gxShadow.blendSrc == src && gxShadow.blendDst == dst, WIIGL_STATE_PIXEL))
+    {
+        gxShadow.blendSrc = src;
+        gxShadow.blendDst = dst;
+        GX_SetBlendMode(GX_BM_BLEND, src, dst, 0);
+    }
+}
+
+// Sets the inputs of TEV stage 0. Its operations never change, and are set up
+// with the context.
+static void set_tev0_inputs(u8 vtxColor, u8 texColor, u8 vtxAlpha, u8 texAlpha)
+{
+    bool same = gxShadow.tev0In[0] == vtxColor && gxShadow.tev0In[1] == texColor
+             && gxShadow.tev0In[2] == vtxAlpha && gxShadow.tev0In[3] == texAlpha;
+
+    if (need_write(DIRTY_TEV0, same, WIIGL_STATE_TEV))
+    {
+        gxShadow.tev0In[0] = vtxColor;
+        gxShadow.tev0In[1] = texColor;
+        gxShadow.tev0In[2] = vtxAlpha;
+        gxShadow.tev0In[3] = texAlpha;
+        GX_SetTevColorIn(GX_TEVSTAGE0, GX_CC_ZERO, vtxColor, texColor, GX_CC_ZERO);
+        GX_SetTevAlphaIn(GX_TEVSTAGE0, GX_CA_ZERO, vtxAlpha, texAlpha, GX_CA_ZERO);
+    }
+}
+
+static void set_tev_color(u8 reg, GXColor color)
+{
+    if (need_write(DIRTY_TEVREG(reg), same_color(gxShadow.tevReg[reg], color), WIIGL_STATE_TEV))
+    {
+        gxShadow.tevReg[reg] = color;
+        GX_SetTevColor(reg, color);
+    }
+}
+
+// The lighting channel count and the TEV stage count go together
+static void set_num_chans(u8 num)
+{
+    if (need_write(DIRTY_NUMCHANS, gxShadow.numChans == num, WIIGL_STATE_LIGHTING))
+    {
+        gxShadow.numChans = num;
+        GX_SetNumChans(num);
+        GX_SetNumTevStages(num);
+    }
+}
+
+static void set_chan_lights(u8 lights)
+{
+    if (need_write(DIRTY_CHANCTRL, gxShadow.chanLights == lights, WIIGL_STATE_LIGHTING))
+    {
+        gxShadow.chanLights = lights;
+        GX_SetChanCtrl(GX_COLOR1A1, GX_ENABLE, GX_SRC_REG, GX_SRC_REG, lights, GX_DF_CLAMP, GX_AF_NONE);
+    }
+}
+
+static void set_chan_amb_color(GXColor color)
+{
+    if (need_write(DIRTY_AMBCOLOR, same_color(gxShadow.ambColor, color), WIIGL_STATE_LIGHTING))
+    {
+        gxShadow.ambColor = color;
+        GX_SetChanAmbColor(GX_COLOR1A1, color);
+    }
+}
+
+static void set_chan_mat_color(GXColor color)
+{
+    if (need_write(DIRTY_MATCOLOR, same_color(gxShadow.matColor, color), WIIGL_STATE_LIGHTING))
+    {
+        gxShadow.matColor = color;
+        GX_SetChanMatColor(GX_COLOR1A1, color);
+    }
+}
+
+static void load_light_obj(GXLightObj *light, int num)
+{
+    bool same = memcmp(&gxShadow.lights[num], light, sizeof(*light)) == 0;
+
+    if (need_write(DIRTY_LIGHT(num), same, WIIGL_STATE_LIGHTING))
+    {
+        gxShadow.lights[num] = *light;
+        GX_LoadLightObj(light, (1 << num));
+    }
+}
+
+// A texture object's contents can change under the same pointer, so changing
+// one must call this.
+static void texture_changed(void)
+{
+    gxDirty |= DIRTY_TEXOBJ;
+}
+
+static void load_tex_obj(GXTexObj *texObj)
+{
+    if (need_write(DIRTY_TEXOBJ, gxShadow.texObj == texObj, WIIGL_STATE_TEXTURE))
+    {
+        gxShadow.texObj = texObj;
+        GX_LoadTexObj(texObj, GX_TEXMAP0);
+    }
+}
+
+static void load_projection(Mtx44 m, u8 type)
+{
+    frameStats.written[WIIGL_STATE_MATRIX]++;
+    gxShadow.projOffset = false;
+    gxShadow.projType = type;
+    gxDirty &= ~DIRTY_PROJ;
+    GX_LoadProjectionMtx(m, type);
+}
+
+static void set_vtx_desc(u8 attr, u8 type)
+{
+    int slot = attr - GX_VA_POS;
+
+    if (need_write(DIRTY_VTXDESC(attr), gxShadow.vtxDesc[slot] == type, WIIGL_STATE_VERTEX))
+    {
+        gxShadow.vtxDesc[slot] = type;
+        GX_SetVtxDesc(attr, type);
+    }
+}
+
+static void set_vtx_attr_fmt(u8 attr, u8 cnt, u8 fmt, u8 frac)
+{
+    int slot = attr - GX_VA_POS;
+    bool same = gxShadow.vtxCnt[slot] == cnt && gxShadow.vtxFmt[slot] == fmt
+             && gxShadow.vtxFrac[slot] == frac;
+
+    if (need_write(DIRTY_VTXFMT(attr), same, WIIGL_STATE_VERTEX))
+    {
+        gxShadow.vtxCnt[slot] = cnt;
+        gxShadow.vtxFmt[slot] = fmt;
+        gxShadow.vtxFrac[slot] = frac;
+        GX_SetVtxAttrFmt(GX_VTXFMT0, attr, cnt, fmt, frac);
+    }
+}
+
+static void set_array(u8 attr, const void *pointer, u8 stride)
+{
+    int slot = attr - GX_VA_POS;
+    bool same = gxShadow.arrayPtr[slot] == pointer && gxShadow.arrayStride[slot] == stride;
+
+    if (need_write(DIRTY_ARRAY(attr), same, WIIGL_STATE_VERTEX))
+    {
+        gxShadow.arrayPtr[slot] = pointer;
+        gxShadow.arrayStride[slot] = stride;
+        GX_SetArray(attr, (void *)pointer, stride);
+    }
+}
+
+void wiigl_get_stats(struct wiigl_stats *stats)
+{
+    *stats = lastFrameStats;
+}
+
 static void initialize_video(void)
 {
     void *gpFifo;
@@ -234,6 +518,7 @@ void wiigl_create_context(void)
     if (!initialized)
         initialize_video();
 
+    gxDirty = DIRTY_ALL;
     memset(&clientEnabled, 0, sizeof(clientEnabled));
     memset(&serverEnabled, 0, sizeof(serverEnabled));
     
@@ -262,12 +547,11 @@ void wiigl_create_context(void)
     zEnable = GX_FALSE;
     zFunc = GX_LEQUAL;
     zUpdate = GX_TRUE;
-    GX_SetZMode(zEnable, zFunc, zUpdate);
+    set_z_mode(zEnable, zFunc, zUpdate);
     glMatrixMode(GL_MODELVIEW);
     
-    GX_SetNumTevStages(1);
+    set_num_chans(1);
     GX_SetNumTexGens(1);
-    GX_SetNumChans(1);
     
     /*
     static GXLightObj lobj;
@@ -285,15 +569,23 @@ void wiigl_create_context(void)
     GX_SetTevAlphaOp(GX_TEVSTAGE1, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
     GX_SetTevOrder(GX_TEVSTAGE1, GX_TEXCOORDNULL, GX_TEXMAP_NULL, GX_COLOR1A1);
     
-    GX_SetChanAmbColor(GX_COLOR1A1, (GXColor){128, 128, 128, 255});
-    GX_SetChanMatColor(GX_COLOR1A1, (GXColor){255, 255, 255, 255});
-    GX_SetChanCtrl(GX_COLOR1A1, GX_ENABLE, GX_SRC_REG,GX_SRC_REG,GX_LIGHT0,GX_DF_CLAMP,GX_AF_NONE);
+    // Texture TEV stage (its inputs are set up for each draw)
+    GX_SetTevColorOp(GX_TEVSTAGE0, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
+    GX_SetTevAlphaOp(GX_TEVSTAGE0, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
+    
+    set_chan_amb_color((GXColor){128, 128, 128, 255});
+    set_chan_mat_color((GXColor){255, 255, 255, 255});
+    set_chan_lights(GX_LIGHT0);
     
     GX_SetTexCoordGen(GX_TEXCOORD0, GX_TG_MTX2x4, GX_TG_TEXCOORD0, GX_TEXMTX0);
     
     //GX_SetPixelFmt(GX_PF_RGBA6_Z24, GX_ZC_LINEAR);
     
     GX_ClearVtxDesc();
+    for (int i = 0; i < VTX_SLOTS; i++)
+        gxShadow.vtxDesc[i] = GX_NONE;
+    gxDirty &= ~(DIRTY_VTXDESC(GX_VA_POS) | DIRTY_VTXDESC(GX_VA_NRM) | DIRTY_VTXDESC(GX_VA_CLR0)
+               | DIRTY_VTXDESC(GX_VA_CLR1) | DIRTY_VTXDESC(GX_VA_TEX0));
 }
 
 void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
@@ -323,6 +615,8 @@ void wiigl_swap_buffers(void)
     VIDEO_WaitVSync();
     GX_CopyDisp(frameBuffers[frameBufferNum], GX_TRUE);
     VIDEO_SetNextFramebuffer(frameBuffers[frameBufferNum]);
+    lastFrameStats = frameStats;
+    memset(&frameStats, 0, sizeof(frameStats));
     //VIDEO_Flush();
     //VIDEO_WaitVSync();
 }
@@ -350,12 +644,12 @@ void glEnable(GLenum cap)
             break;
         case GL_CULL_FACE:
             serverEnabled.cullFace = true;
-            GX_SetCullMode(cullMode);
+            set_cull_mode(cullMode);
             break;
         case GL_DEPTH_TEST:
             serverEnabled.depthTest = true;
             zEnable = GX_TRUE;
-            GX_SetZMode(zEnable, zFunc, zUpdate);
+            set_z_mode(zEnable, zFunc, zUpdate);
             break;
         case GL_LIGHT0:
         case GL_LIGHT1:
@@ -366,12 +660,11 @@ void glEnable(GLenum cap)
         case GL_LIGHT6:
         case GL_LIGHT7:
             serverEnabled.lights |= (1 << (cap - GL_LIGHT0));
-            GX_SetChanCtrl(GX_COLOR1A1, GX_ENABLE, GX_SRC_REG, GX_SRC_REG, serverEnabled.lights, GX_DF_CLAMP, GX_AF_NONE);
+            set_chan_lights(serverEnabled.lights);
             break;
         case GL_LIGHTING:
             serverEnabled.lighting = true;
-            GX_SetNumChans(2);
-            GX_SetNumTevStages(2);
+            set_num_chans(2);
             break;
         case GL_NORMALIZE:
             serverEnabled.normalize = true;
@@ -427,12 +720,12 @@ void glDisable(GLenum cap)
             break;
         case GL_CULL_FACE:
             serverEnabled.cullFace = false;
-            GX_SetCullMode(GX_CULL_NONE);
+            set_cull_mode(GX_CULL_NONE);
             break;
         case GL_DEPTH_TEST:
             serverEnabled.depthTest = false;
             zEnable = GX_FALSE;
-            GX_SetZMode(zEnable, zFunc, zUpdate);
+            set_z_mode(zEnable, zFunc, zUpdate);
             break;
         case GL_LIGHT0:
         case GL_LIGHT1:
@@ -443,12 +736,11 @@ void glDisable(GLenum cap)
         case GL_LIGHT6:
         case GL_LIGHT7:
             serverEnabled.lights &= ~(1 << (cap - GL_LIGHT0));
-            GX_SetChanCtrl(GX_COLOR1A1, GX_ENABLE, GX_SRC_REG, GX_SRC_REG, GX_LIGHT0, GX_DF_CLAMP, GX_AF_NONE);
+            set_chan_lights(GX_LIGHT0);
             break;
         case GL_LIGHTING:
             serverEnabled.lighting = false;
-            GX_SetNumChans(1);
-            GX_SetNumTevStages(1);
+            set_num_chans(1);
             break;
         case GL_NORMALIZE:
             serverEnabled.normalize = false;
@@ -487,22 +779,22 @@ void glEnableClientState(GLenum cap)
     {
         case GL_COLOR_ARRAY:
             clientEnabled.colorArray = true;
-            GX_SetVtxDesc(GX_VA_CLR0, GX_INDEX16);
+            set_vtx_desc(GX_VA_CLR0, GX_INDEX16);
             break;
         case GL_INDEX_ARRAY:
             clientEnabled.indexArray = true;
             break;
         case GL_NORMAL_ARRAY:
             clientEnabled.normalArray = true;
-            GX_SetVtxDesc(GX_VA_NRM, GX_INDEX16);
+            set_vtx_desc(GX_VA_NRM, GX_INDEX16);
             break;
         case GL_TEXTURE_COORD_ARRAY:
             clientEnabled.textureCoordArray = true;
-            GX_SetVtxDesc(GX_VA_TEX0, GX_INDEX16);
+            set_vtx_desc(GX_VA_TEX0, GX_INDEX16);
             break;
         case GL_VERTEX_ARRAY:
             clientEnabled.vertexArray = true;
-            GX_SetVtxDesc(GX_VA_POS, GX_INDEX16);
+            set_vtx_desc(GX_VA_POS, GX_INDEX16);
             break;
 #ifdef DEBUG
         default:
@@ -583,24 +875,24 @@ void glDisableClientState(GLenum cap)
     {
         case GL_COLOR_ARRAY:
             clientEnabled.colorArray = false;
-            GX_SetVtxDesc(GX_VA_CLR0, GX_NONE);
+            set_vtx_desc(GX_VA_CLR0, GX_NONE);
             break;
         case GL_INDEX_ARRAY:
             clientEnabled.indexArray = false;
             break;
         case GL_NORMAL_ARRAY:
             clientEnabled.normalArray = false;
-            GX_SetVtxDesc(GX_VA_NRM, GX_NONE);
+            set_vtx_desc(GX_VA_NRM, GX_NONE);
             // HACK! GX_SetVtxDesc does not set vcdNrms to zero, so we must do it manually
             __gx->vcdNrms = 0;
             break;
         case GL_TEXTURE_COORD_ARRAY:
             clientEnabled.textureCoordArray = false;
-            GX_SetVtxDesc(GX_VA_TEX0, GX_NONE);
+            set_vtx_desc(GX_VA_TEX0, GX_NONE);
             break;
         case GL_VERTEX_ARRAY:
             clientEnabled.vertexArray = false;
-            GX_SetVtxDesc(GX_VA_POS, GX_NONE);
+            set_vtx_desc(GX_VA_POS, GX_NONE);
             break;
 #ifdef DEBUG
         default:
@@ -663,7 +955,7 @@ static void load_curr_matrix(void)
             break;
         }
         case GL_PROJECTION:
-            GX_LoadProjectionMtx(CURR_MATRIX, GX_PERSPECTIVE);
+            load_projection(CURR_MATRIX, GX_PERSPECTIVE);
             break;
         case GL_TEXTURE:
             GX_LoadTexMtxImm(CURR_MATRIX, GX_TEXMTX0, GX_MTX2x4);
@@ -855,7 +1147,7 @@ void glOrtho(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top,
     
     mult_mtx44(CURR_MATRIX, mtx, CURR_MATRIX);
     if (matrixMode == GL_PROJECTION)
-        GX_LoadProjectionMtx(CURR_MATRIX, GX_ORTHOGRAPHIC);
+        load_projection(CURR_MATRIX, GX_ORTHOGRAPHIC);
     else
         load_curr_matrix();
 }
@@ -867,6 +1159,56 @@ void glFrustum(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top,
     load_curr_matrix();
 }
 
+//------------------------------------------------------------------------------
+// Object Names
+//------------------------------------------------------------------------------
+
+// Buffer and texture names are the object pointers themselves. Where a pointer
+// doesn't fit in a GLuint, as on a 64-bit host built against the GX stubs,
+// names index a table of pointers instead.
+
+#if UINTPTR_MAX > UINT32_MAX
+
+static void **nameTable;
+static GLuint nameCount;
+static GLuint nameAlloc;
+
+static GLuint obj_to_name(void *obj)
+{
+    if (nameCount == nameAlloc)
+    {
+        nameAlloc = nameAlloc ? nameAlloc * 2 : 256;
+        nameTable = realloc(nameTable, nameAlloc * sizeof(*nameTable));
+#ifdef DEBUG
+        if (nameTable == NULL)
+            fatal_error("obj_to_name: out of memory\n");
+#endif
+    }
+    nameTable[nameCount++] = obj;
+    return nameCount;
+}
+
+static void *name_to_obj(GLuint name)
+{
+    if (name == 0 || name > nameCount)
+        return NULL;
+    return nameTable[name - 1];
+}
+
+static void free_name(GLuint name)
+{
+    if (name != 0 && name <= nameCount)
+        nameTable[name - 1] = NULL;
+}
+
+#else
+
+#define obj_to_name(obj) ((GLuint)(obj))
+#define name_to_obj(name) ((void *)(name))
+#define free_name(name)
+
+#endif
+
 //------------------------------------------------------------------------------
 
 static struct Buffer *get_buffer(GLenum target)
@@ -896,6 +1238,27 @@ static void set_buffer(GLenum target, struct Buffer *buf)
     }
 }
 
+static void free_disp_lists(struct Buffer *buf)
+{
+    while (buf->dispLists != NULL)
+    {
+        struct DispList *dl = buf->dispLists;
+
+        buf->dispLists = dl->next;
+        if (dl->list != NULL)
+            free(dl->list);
+        free(dl);
+    }
+}
+
+// Called whenever a buffer's contents change
+static void touch_buffer(struct Buffer *buf)
+{
+    buf->stamp = ++bufferStamp;
+    free_disp_lists(buf);
+    vtxCacheDirty = true;
+}
+
 void glGenBuffers(GLsizei n, GLuint *buffers)
 {
     for (u32 i = 0; i < n; i++)
@@ -904,7 +1267,9 @@ void glGenBuffers(GLsizei n, GLuint *buffers)
 
         buf->data = NULL;
         buf->size = 0;
-        buffers[i] = (GLuint)buf;
+        buf->stamp = ++bufferStamp;
+        buf->dispLists = NULL;
+        buffers[i] = obj_to_name(buf);
     }
 }
 
@@ -914,19 +1279,21 @@ void glDeleteBuffers(GLsizei n, const GLuint *buffers)
 
     for (u32 i = 0; i < n; i++)
     {
-        buf = (struct Buffer *)buffers[i];
+        buf = name_to_obj(buffers[i]);
         if (buf != NULL)
         {
             if (buf->data != NULL)
                 free(buf->data);
+            free_disp_lists(buf);
             free(buf);
+            free_name(buffers[i]);
         }
     }
 }
 
 void glBindBuffer(GLenum target, GLuint buffer)
 {
-    set_buffer(target, (struct Buffer *)buffer);
+    set_buffer(target, name_to_obj(buffer));
 }
 
 void glBufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage)
@@ -944,6 +1311,7 @@ void glBufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usa
             memcpy(buf->data, data, size);
             flush_mem_range(buf->data, buf->size);
         }
+        touch_buffer(buf);
     }
 }
 
@@ -959,6 +1327,7 @@ void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvo
 #endif
     memcpy((u8 *)buf->data + offset, data, size);
     flush_mem_range(buf->data, buf->size);
+    touch_buffer(buf);
 }
 
 //------------------------------------------------------------------------------
@@ -973,12 +1342,18 @@ void glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
         .b = blue,
         .a = alpha,
     };
-    GX_SetTevColor(GX_TEVREG0, color);
+    set_tev_color(GX_TEVREG0, color);
     //GX_SetTevColorIn(GX_TEVSTAGE0, GX_CC_C0, GX_CC_ZERO, GX_CC_ZERO, GX_CC_ZERO);
     //GX_SetTevColorOp(GX_TEVSTAGE0, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
 }
 
 void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    wiigl_vertex_pointer(size, type, stride, pointer, 0);
+}
+
+// Fixed point positions with FRAC fraction bits, as GX reads them
+void wiigl_vertex_pointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer, GLuint frac)
 {
     switch (size)
     {
@@ -993,13 +1368,15 @@ void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *poin
     posDesc.components = size;
     posDesc.format = type;
     posDesc.stride = stride;
+    posDesc.frac = frac;
     if (get_buffer(GL_ARRAY_BUFFER) != NULL)
         posDesc.pointer = (u8 *)get_buffer(GL_ARRAY_BUFFER)->data + (ptrdiff_t)pointer;
     else
         posDesc.pointer = pointer;
-    GX_SetVtxDesc(GX_VA_POS, GX_INDEX16);
-    GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS, posDesc.components, posDesc.format, 0);
-    GX_SetArray(GX_VA_POS, (void *)posDesc.pointer, posDesc.stride);
+    posDesc.client = (get_buffer(GL_ARRAY_BUFFER) == NULL);
+    set_vtx_desc(GX_VA_POS, GX_INDEX16);
+    set_vtx_attr_fmt(GX_VA_POS, posDesc.components, posDesc.format, posDesc.frac);
+    set_array(GX_VA_POS, posDesc.pointer, posDesc.stride);
 }
 
 void glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
@@ -1038,11 +1415,18 @@ void glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *point
         colorDesc.pointer = (u8 *)get_buffer(GL_ARRAY_BUFFER)->data + (ptrdiff_t)pointer;
     else
         colorDesc.pointer = pointer;
-    GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, colorDesc.components, colorDesc.format, 0);
-    GX_SetArray(GX_VA_CLR0, (void *)colorDesc.pointer, colorDesc.stride);
+    colorDesc.client = (get_buffer(GL_ARRAY_BUFFER) == NULL);
+    set_vtx_attr_fmt(GX_VA_CLR0, colorDesc.components, colorDesc.format, 0);
+    set_array(GX_VA_CLR0, colorDesc.pointer, colorDesc.stride);
 }
 
 void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer)
+{
+    wiigl_tex_coord_pointer(size, type, stride, pointer, 0);
+}
+
+// Fixed point texture coordinates with FRAC fraction bits, as GX reads them
+void wiigl_tex_coord_pointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer, GLuint frac)
 {
     switch (size)
     {
@@ -1059,15 +1443,18 @@ void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *po
     texCoordDesc.components = size;
     texCoordDesc.format = type;
     texCoordDesc.stride = stride;
+    texCoordDesc.frac = frac;
     if (get_buffer(GL_ARRAY_BUFFER) != NULL)
         texCoordDesc.pointer = (u8 *)get_buffer(GL_ARRAY_BUFFER)->data + (ptrdiff_t)pointer;
     else
         texCoordDesc.pointer = pointer;
-    GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_TEX0, texCoordDesc.components, texCoordDesc.format, 0);
-    GX_SetArray(GX_VA_TEX0, (void *)texCoordDesc.pointer, texCoordDesc.stride);
+    texCoordDesc.client = (get_buffer(GL_ARRAY_BUFFER) == NULL);
+    set_vtx_attr_fmt(GX_VA_TEX0, texCoordDesc.components, texCoordDesc.format, texCoordDesc.frac);
+    set_array(GX_VA_TEX0, texCoordDesc.pointer, texCoordDesc.stride);
     
 }
 
+// GX reads GL_SHORT normals with 14 fraction bits and GL_BYTE with 6
 void glNormalPointer(GLenum type, GLsizei stride, const GLvoid *pointer)
 {
     type = gl_enum_to_gx(type);
@@ -1078,8 +1465,30 @@ void glNormalPointer(GLenum type, GLsizei stride, const GLvoid *pointer)
         nrmDesc.pointer = (u8 *)get_buffer(GL_ARRAY_BUFFER)->data + (ptrdiff_t)pointer;
     else
         nrmDesc.pointer = pointer;
-    GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_NRM, nrmDesc.components, nrmDesc.format, 0);
-    GX_SetArray(GX_VA_NRM, (void *)nrmDesc.pointer, nrmDesc.stride);
+    nrmDesc.client = (get_buffer(GL_ARRAY_BUFFER) == NULL);
+    set_vtx_attr_fmt(GX_VA_NRM, nrmDesc.components, nrmDesc.format, 0);
+    set_array(GX_VA_NRM, nrmDesc.pointer, nrmDesc.stride);
+}
+
+// Loads the projection for drawing, offset if polygon offset fill is enabled.
+// The plain projection is put back by the next draw without the offset.
+static void setup_projection(void)
+{
+    bool offset = serverEnabled.polygonOffsetFill;
+    bool same = gxShadow.projOffset == offset && (!offset || gxShadow.projOffsetUnits == polyOffsUnits);
+
+    if (need_write(DIRTY_PROJ, same, WIIGL_STATE_MATRIX))
+    {
+        Mtx44 m;
+
+        if (offset)  // Adjust the projection matrix to offset the drawn polygon
+            guMtxApplyTrans(projMtxStack.stack[projMtxStack.stackPos], m, 0, 0, -polyOffsUnits * 0.1);
+        else
+            memcpy(m, projMtxStack.stack[projMtxStack.stackPos], sizeof(Mtx44));
+        GX_LoadProjectionMtx(m, gxShadow.projType);
+        gxShadow.projOffset = offset;
+        gxShadow.projOffsetUnits = polyOffsUnits;
+    }
 }
 
 static void setup_drawing(void)
@@ -1103,75 +1512,54 @@ static void setup_drawing(void)
     if (clientEnabled.textureCoordArray)
     {
         texColorInput = GX_CC_TEXC;
-        texAlphaInput = GX_CA_TEXA;
+        if (serverEnabled.texture2d && boundTexture != NULL && boundTexture->opaque)
+            texAlphaInput = GX_CA_A1;
+        else
+            texAlphaInput = GX_CA_TEXA;
     }
     else
     {
         texColorInput = GX_CC_ONE;
-        // There doesn't seem to be a GX_CA_ONE, so let's just set a register for that.
-        GX_SetTevColor(GX_TEVREG1, (GXColor){255, 255, 255, 255});
         texAlphaInput = GX_CA_A1;
     }
+    // There doesn't seem to be a GX_CA_ONE, so let's just set a register for that.
+    if (texAlphaInput == GX_CA_A1)
+        set_tev_color(GX_TEVREG1, (GXColor){255, 255, 255, 255});
     
-    GX_SetTevColorIn(GX_TEVSTAGE0, GX_CC_ZERO, vtxColorInput, texColorInput, GX_CC_ZERO);
-    GX_SetTevAlphaIn(GX_TEVSTAGE0, GX_CA_ZERO, vtxAlphaInput, texAlphaInput, GX_CA_ZERO);
-    GX_SetTevColorOp(GX_TEVSTAGE0, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
-    GX_SetTevAlphaOp(GX_TEVSTAGE0, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
+    if (serverEnabled.texture2d && boundTexture != NULL)
+        load_tex_obj(&boundTexture->texObj);
+    setup_projection();
+    set_tev0_inputs(vtxColorInput, texColorInput, vtxAlphaInput, texAlphaInput);
 }
 
-void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+// Invalidates the vertex cache if any array it may hold has changed since
+static void inv_vtx_cache(void)
 {
-    mode = gl_enum_to_gx(mode);
-    if (serverEnabled.texture2d && boundTexture != NULL)
-        GX_LoadTexObj(&boundTexture->texObj, GX_TEXMAP0);
-    if (serverEnabled.polygonOffsetFill)
-    {
-        // Adjust the projection matrix to offset the drawn polygon
-        Mtx44 m;
-        guMtxApplyTrans(projMtxStack.stack[projMtxStack.stackPos], m, 0, 0, -polyOffsUnits * 0.1);
-        GX_LoadProjectionMtx(m, GX_PERSPECTIVE);
-    }
-    setup_drawing();
-    GX_InvVtxCache();
-    GX_Begin(mode, GX_VTXFMT0, count);
-    for (int i = 0; i < count; i++)
+    if ((clientEnabled.vertexArray && posDesc.client)
+     || (clientEnabled.normalArray && nrmDesc.client)
+     || (clientEnabled.colorArray && colorDesc.client)
+     || (clientEnabled.textureCoordArray && texCoordDesc.client))
+        vtxCacheDirty = true;
+    if (vtxCacheDirty)
     {
-        if (clientEnabled.vertexArray)
-            GX_Position1x16(first + i);
-        if (clientEnabled.normalArray)
-            GX_Normal1x16(first + i);
-        if (clientEnabled.colorArray)
-            GX_Color1x16(first + i);
-        if (clientEnabled.textureCoordArray)
-            GX_TexCoord1x16(first + i);
+        GX_InvVtxCache();
+        vtxCacheDirty = false;
     }
-    GX_End();
-    
-    if (serverEnabled.polygonOffsetFill)
-        GX_LoadProjectionMtx(projMtxStack.stack[projMtxStack.stackPos], GX_PERSPECTIVE);
 }
 
-void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+static u8 enabled_arrays(void)
 {
-    const u8 *indicesu8;
-    const u16 *indicesu16;
+    return clientEnabled.vertexArray
+         | clientEnabled.normalArray << 1
+         | clientEnabled.colorArray << 2
+         | clientEnabled.textureCoordArray << 3;
+}
+
+static void send_indices(u8 mode, GLsizei count, GLenum type, const void *indices)
+{
+    const u8 *indicesu8 = indices;
+    const u16 *indicesu16 = indices;
 
-    mode = gl_enum_to_gx(mode);
-    if (serverEnabled.texture2d && boundTexture != NULL)
-        GX_LoadTexObj(&boundTexture->texObj, GX_TEXMAP0);
-    if (serverEnabled.polygonOffsetFill)
-    {
-        // Adjust the projection matrix to offset the drawn polygon
-        Mtx44 m;
-        guMtxApplyTrans(projMtxStack.stack[projMtxStack.stackPos], m, 0, 0, -polyOffsUnits * 0.1);
-        GX_LoadProjectionMtx(m, GX_PERSPECTIVE);
-    }
-    setup_drawing();
-    GX_InvVtxCache();
-    if (get_buffer(GL_ELEMENT_ARRAY_BUFFER) != NULL)
-        indices = (u8 *)get_buffer(GL_ELEMENT_ARRAY_BUFFER)->data + (u32)indices;
-    indicesu8 = indices;
-    indicesu16 = indices;
     GX_Begin(mode, GX_VTXFMT0, count);
     for (int i = 0; i < count; i++)
     {
@@ -1200,57 +1588,121 @@ void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indic
             GX_TexCoord1x16(index);
     }
     GX_End();
-    
-    if (serverEnabled.polygonOffsetFill)
-        GX_LoadProjectionMtx(projMtxStack.stack[projMtxStack.stackPos], GX_PERSPECTIVE);
 }
 
-//------------------------------------------------------------------------------
+static void compile_disp_list(struct DispList *dl, const void *indices)
+{
+    int attrs = 0;
+    u32 size;
 
-static void *convert_to_rgb5a3(const u8 *data, u32 width, u32 height)
+    for (u8 arrays = dl->arrays; arrays != 0; arrays >>= 1)
+        attrs += arrays & 1;
+
+    // 3 bytes for GX_Begin and 2 for each index, plus room for the padding
+    size = round_up(3 + dl->count * attrs * 2, 32) + 32;
+    dl->list = memalign(32, size);
+    dl->size = 0;
+    if (dl->list == NULL)
+        return;
+    DCInvalidateRange(dl->list, size);
+    GX_BeginDispList(dl->list, size);
+    send_indices(dl->mode, dl->count, dl->type, indices);
+    dl->size = GX_EndDispList();
+    if (dl->size == 0)
+    {
+        free(dl->list);
+        dl->list = NULL;
+    }
+}
+
+// Finds the display list for drawing from the bound element buffer, compiling
+// it the first time the draw is seen and again if its vertex buffer changed.
+static struct DispList *get_disp_list(struct Buffer *ebo, u8 mode, GLsizei count, GLenum type, uintptr_t offset)
 {
-    u32 bufferWidth = round_up(width, 4);
-    u32 bufferHeight = round_up(height, 4);
-    u16 *buffer = memalign(32, bufferWidth * bufferHeight * sizeof(u16));
-    u32 blockCols = width / 4;
-    
-    memset(buffer, 0, bufferWidth * bufferHeight * sizeof(u16));
-    for (u32 x = 0; x < width; x++)
+    struct Buffer *vbo = get_buffer(GL_ARRAY_BUFFER);
+    u32 vboStamp = (vbo != NULL) ? vbo->stamp : 0;
+    u8 arrays = enabled_arrays();
+    struct DispList *dl;
+
+    for (dl = ebo->dispLists; dl != NULL; dl = dl->next)
     {
-        u32 blockX = x / 4;
-        u32 remX = x % 4;
+        if (dl->offset == offset && dl->count == count && dl->mode == mode
+         && dl->type == type && dl->arrays == arrays)
+            break;
+    }
 
-        for (u32 y = 0; y < height; y++)
-        {
-            u8 r, g, b, a;
-            u16 pixel;
-            
-            if (data[4 * (x + y * width) + 3] == 255)
-            {
-                r = (data[4 * (x + y * width) + 0] >> 3) & 31;
-                g = (data[4 * (x + y * width) + 1] >> 3) & 31;
-                b = (data[4 * (x + y * width) + 2] >> 3) & 31;
-                pixel = (1 << 15) | (r << 10) | (g << 5) | b;
-            }
-            else
-            {
-                r = (data[4 * (x + y * width) + 0] >> 4) & 15;
-                g = (data[4 * (x + y * width) + 1] >> 4) & 15;
-                b = (data[4 * (x + y * width) + 2] >> 4) & 15;
-                a = (data[4 * (x + y * width) + 3] >> 5) & 7;
-                pixel = (a << 12) | (r << 8) | (g << 4) | b;
-            }
-            
-            u32 blockY = y / 4;
-            u32 remY = y % 4;
-            u32 index = 16 * (blockX + blockY * blockCols) + (remY * 4 + remX);
-            buffer[index] = pixel;
-        }
+    if (dl == NULL)
+    {
+        // Without memory to cache it, the draw is sent immediately instead
+        dl = malloc(sizeof(*dl));
+        if (dl == NULL)
+            return NULL;
+        dl->offset = offset;
+        dl->count = count;
+        dl->mode = mode;
+        dl->type = type;
+        dl->arrays = arrays;
+        dl->list = NULL;
+        dl->next = ebo->dispLists;
+        ebo->dispLists = dl;
+    }
+    else if (dl->vbo == vbo && dl->vboStamp == vboStamp)
+    {
+        return dl;
     }
-    flush_mem_range(buffer, bufferWidth * bufferHeight * sizeof(u16));
-    return buffer;
+    else if (dl->list != NULL)
+    {
+        free(dl->list);
+    }
+
+    dl->vbo = vbo;
+    dl->vboStamp = vboStamp;
+    compile_disp_list(dl, (u8 *)ebo->data + offset);
+    return dl;
 }
 
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    mode = gl_enum_to_gx(mode);
+    setup_drawing();
+    inv_vtx_cache();
+    GX_Begin(mode, GX_VTXFMT0, count);
+    for (int i = 0; i < count; i++)
+    {
+        if (clientEnabled.vertexArray)
+            GX_Position1x16(first + i);
+        if (clientEnabled.normalArray)
+            GX_Normal1x16(first + i);
+        if (clientEnabled.colorArray)
+            GX_Color1x16(first + i);
+        if (clientEnabled.textureCoordArray)
+            GX_TexCoord1x16(first + i);
+    }
+    GX_End();
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+{
+    struct Buffer *ebo = get_buffer(GL_ELEMENT_ARRAY_BUFFER);
+    struct DispList *dl = NULL;
+
+    mode = gl_enum_to_gx(mode);
+    setup_drawing();
+    inv_vtx_cache();
+    if (ebo != NULL)
+        dl = get_disp_list(ebo, mode, count, type, (uintptr_t)indices);
+    if (dl != NULL && dl->list != NULL)
+        GX_CallDispList(dl->list, dl->size);
+    else
+    {
+        if (ebo != NULL)
+            indices = (u8 *)ebo->data + (uintptr_t)indices;
+        send_indices(mode, count, type, indices);
+    }
+}
+
+//------------------------------------------------------------------------------
+
 void glGenTextures(GLsizei n, GLuint *textures)
 {
     for (u32 i = 0; i < n; i++)
@@ -1259,9 +1711,12 @@ void glGenTextures(GLsizei n, GLuint *textures)
 
         tex->imgBuffer = NULL;
         tex->initialized = false;
+        tex->opaque = false;
+        tex->genMipmap = false;
+        tex->lods = 1;
         tex->magFilter = GX_LINEAR;
         tex->minFilter = GX_LINEAR;
-        textures[i] = (GLuint)tex;
+        textures[i] = obj_to_name(tex);
     }
 }
 
@@ -1271,21 +1726,72 @@ void glDeleteTextures(GLsizei n, const GLuint *textures)
 
     for (u32 i = 0; i < n; i++)
     {
-        tex = (struct Texture *)textures[i];
+        tex = name_to_obj(textures[i]);
         if (tex != NULL)
         {
             if (tex->imgBuffer != NULL)
                 free(tex->imgBuffer);
             free(tex);
+            free_name(textures[i]);
+            texture_changed();
         }
     }
 }
 
+// Replaces the texture's image with a new, uninitialized GX image buffer
+static void *alloc_tex_image(struct Texture *tex, u32 size)
+{
+    if (tex->imgBuffer != NULL)
+        free(tex->imgBuffer);
+    tex->imgBuffer = memalign(32, size);
+#ifdef DEBUG
+    if (tex->imgBuffer == NULL)
+        fatal_error("failed to allocate texture");
+#endif
+    return tex->imgBuffer;
+}
+
+// Sets the texture's filters and LOD range. Mipmap filters fall back to
+// sampling the base level of a texture that has no other levels.
+static void init_tex_filter(struct Texture *tex)
+{
+    u8 minFilter = tex->minFilter;
+
+    if (tex->lods == 1)
+    {
+        if (minFilter == GX_NEAR_MIP_NEAR || minFilter == GX_NEAR_MIP_LIN)
+            minFilter = GX_NEAR;
+        else if (minFilter == GX_LIN_MIP_NEAR || minFilter == GX_LIN_MIP_LIN)
+            minFilter = GX_LINEAR;
+    }
+    GX_InitTexObjLOD(&tex->texObj, minFilter, tex->magFilter, 0.0, tex->lods - 1, 0.0,
+                     GX_DISABLE, GX_DISABLE, GX_ANISO_1);
+}
+
+static void init_tex_image(struct Texture *tex, u32 width, u32 height, u8 format, u8 lods, u32 size)
+{
+    flush_mem_range(tex->imgBuffer, size);
+    GX_InitTexObj(&tex->texObj, tex->imgBuffer, width, height, format,
+                  GX_CLAMP, GX_CLAMP, lods > 1 ? GX_TRUE : GX_FALSE);
+    // GX reads I8 intensity back as alpha too, but GL luminance is opaque
+    tex->opaque = (format == GX_TF_I8);
+    tex->lods = lods;
+    tex->initialized = true;
+    init_tex_filter(tex);
+    GX_InvalidateTexAll();
+    texture_changed();
+}
+
 void glTexImage2D(GLenum target, GLint level, GLint internalformat,
   GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type,
   const GLvoid *data)
 {
     struct Texture *tex = boundTexture;
+    int src;
+    u8 gxFormat;
+    u8 lods;
+    u32 size;
+    void *buffer;
 
 #ifdef DEBUG
     if (tex == NULL)
@@ -1293,112 +1799,68 @@ void glTexImage2D(GLenum target, GLint level, GLint internalformat,
     if (type != GL_UNSIGNED_BYTE)
         fatal_error("glTexImage2D: unsupported type\n");
 #endif
+    switch (format)
+    {
+        case GL_ALPHA:           src = GXTEX_SRC_A;    break;
+        case GL_LUMINANCE:       src = GXTEX_SRC_L;    break;
+        case GL_LUMINANCE_ALPHA: src = GXTEX_SRC_LA;   break;
+        case GL_RGB:             src = GXTEX_SRC_RGB;  break;
+        case GL_RGBA:            src = GXTEX_SRC_RGBA; break;
+        default:
+            fatal_error("glTexImage2D: unknown format %i\n", format);
+            return;
+    }
     switch (internalformat)
     {
-        case GL_ALPHA:
-        {
-            u8 *temp = malloc(4 * width * height);
-            const u8 *data8 = data;
-            
-            for (int x = 0; x < width; x++)
-            {
-                for (int y = 0; y < height; y++)
-                {
-                    u8 alpha = data8[x + y * width];
-
-                    temp[4 * (x + y * width) + 0] = 0;
-                    temp[4 * (x + y * width) + 1] = 0;
-                    temp[4 * (x + y * width) + 2] = 0;
-                    temp[4 * (x + y * width) + 3] = alpha;
-                }
-            }
-            tex->imgBuffer = convert_to_rgb5a3(temp, width, height);
-            free(temp);
-            break;
-        }
-        case GL_LUMINANCE:
-        {
-            u8 *temp = malloc(4 * width * height);
-            const u8 *data8 = data;
-            
-            for (int x = 0; x < width; x++)
-            {
-                for (int y = 0; y < height; y++)
-                {
-                    u8 lum = data8[x + y * width];
-                    
-                    temp[4 * (x + y * width) + 0] = lum;
-                    temp[4 * (x + y * width) + 1] = lum;
-                    temp[4 * (x + y * width) + 2] = lum;
-                    temp[4 * (x + y * width) + 3] = 0xFF;
-                }
-            }
-            tex->imgBuffer = convert_to_rgb5a3(temp, width, height);
-            free(temp);
-            break;
-        }
-        case GL_LUMINANCE_ALPHA:
-        {
-            u8 *temp = malloc(4 * width * height);
-            const u8 *data8 = data;
-            
-            for (int x = 0; x < width; x++)
-            {
-                for (int y = 0; y < height; y++)
-                {
-                    u8 lum = data8[2 * (x + y * width) + 0];
-                    u8 alpha = data8[2 * (x + y * width) + 1];
-
-                    temp[4 * (x + y * width) + 0] = lum;
-                    temp[4 * (x + y * width) + 1] = lum;
-                    temp[4 * (x + y * width) + 2] = lum;
-                    temp[4 * (x + y * width) + 3] = alpha;
-                }
-            }
-            tex->imgBuffer = convert_to_rgb5a3(temp, width, height);
-            free(temp);
-            break;
-        }
-        case GL_RGB:
-        {
-            u8 *temp = malloc(4 * width * height);
-            const u8 *data8 = data;
-            
-            for (int x = 0; x < width; x++)
-            {
-                for (int y = 0; y < height; y++)
-                {
-                    temp[4 * (x + y * width) + 0] = data8[3 * (x + y * width) + 0];
-                    temp[4 * (x + y * width) + 1] = data8[3 * (x + y * width) + 1];
-                    temp[4 * (x + y * width) + 2] = data8[3 * (x + y * width) + 2];
-                    temp[4 * (x + y * width) + 3] = 0xFF;
-                }
-            }
-            tex->imgBuffer = convert_to_rgb5a3(temp, width, height);
-            free(temp);
-            break;
-        }
-        case GL_RGBA:
-            tex->imgBuffer = convert_to_rgb5a3(data, width, height);
-            break;
+        case GL_ALPHA:           gxFormat = GX_TF_IA8;    break;
+        case GL_LUMINANCE:       gxFormat = GX_TF_I8;     break;
+        case GL_LUMINANCE_ALPHA: gxFormat = GX_TF_IA8;    break;
+        case GL_RGB:             gxFormat = GX_TF_RGB565; break;
+        case GL_RGBA:            gxFormat = GX_TF_RGB5A3; break;
         default:
-            fatal_error("glTexImage2D: unknown format %i\n", internalformat);
+            fatal_error("glTexImage2D: unknown internal format %i\n", internalformat);
             return;
     }
+    // The GXTEX_* formats are the GX_TF_* values. Mipmaps are box-filtered
+    // down to 1x1, if GX can have them at this size.
+    lods = tex->genMipmap ? gxtex_lods(width, height) : 1;
+    size = gxtex_mip_size(gxFormat, width, height, lods);
+    buffer = alloc_tex_image(tex, size);
+    if (!gxtex_tile_mips(buffer, gxFormat, data, width, height, src, lods))
+    {
+        lods = 1;
+        gxtex_tile(buffer, gxFormat, data, width, height, src);
+    }
+    init_tex_image(tex, width, height, gxFormat, lods, size);
+}
+
+// Uploads an image already tiled for GX, such as one made by gxtexc, with
+// as many mipmap levels as its size holds
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat,
+  GLsizei width, GLsizei height, GLint border, GLsizei imageSize,
+  const GLvoid *data)
+{
+    struct Texture *tex = boundTexture;
+    u8 gxFormat = internalformat & 0xFF;
+    u8 lods = 1;
+
+    while (lods < gxtex_lods(width, height) && gxtex_mip_size(gxFormat, width, height, lods) < imageSize)
+        lods++;
 #ifdef DEBUG
-    if (tex->imgBuffer == NULL)
-        fatal_error("failed to convert texture");
+    if (tex == NULL)
+        fatal_error("glCompressedTexImage2D: no texture is bound\n");
+    if ((internalformat & ~0xFF) != GL_GX_TEXTURE_WII)
+        fatal_error("glCompressedTexImage2D: unknown format %i\n", internalformat);
+    if (imageSize != gxtex_mip_size(gxFormat, width, height, lods))
+        fatal_error("glCompressedTexImage2D: bad image size\n");
 #endif
-    GX_InitTexObj(&tex->texObj, tex->imgBuffer, width, height, GX_TF_RGB5A3,
-                  GX_CLAMP, GX_CLAMP, GX_FALSE);
-    tex->initialized = true;
-    GX_InitTexObjFilterMode(&tex->texObj, tex->minFilter, tex->magFilter);
-    GX_InvalidateTexAll();
+    memcpy(alloc_tex_image(tex, imageSize), data, imageSize);
+    init_tex_image(tex, width, height, gxFormat, lods, imageSize);
 }
 
 void glBindTexture(GLenum target, GLuint texture)
 {
-    struct Texture *tex = (struct Texture *)texture;
+    struct Texture *tex = name_to_obj(texture);
 
 #ifdef DEBUG
     if (target != GL_TEXTURE_2D)
@@ -1429,11 +1891,15 @@ void glTexParameteri(GLenum target, GLenum pname, GLint param)
     {
         case GL_TEXTURE_MAG_FILTER:
             boundTexture->magFilter = gl_enum_to_gx(param);
-            GX_InitTexObjFilterMode(texObj, boundTexture->minFilter, boundTexture->magFilter);
+            init_tex_filter(boundTexture);
             break;
         case GL_TEXTURE_MIN_FILTER:
             boundTexture->minFilter = gl_enum_to_gx(param);
-            GX_InitTexObjFilterMode(texObj, boundTexture->minFilter, boundTexture->magFilter);
+            init_tex_filter(boundTexture);
+            break;
+        case GL_GENERATE_MIPMAP:
+            // Takes effect on the next glTexImage2D
+            boundTexture->genMipmap = (param != GL_FALSE);
             break;
         case GL_TEXTURE_WRAP_S:
             wrapS = gl_enum_to_gx(param);
@@ -1450,6 +1916,7 @@ void glTexParameteri(GLenum target, GLenum pname, GLint param)
             fatal_error("glTexParameteri: unknown pname %i\n", pname);
 #endif
     }
+    texture_changed();
 }
 
 void glMaterialfv(GLenum face, GLenum pname, const GLfloat *params)
@@ -1458,10 +1925,10 @@ void glMaterialfv(GLenum face, GLenum pname, const GLfloat *params)
     switch (pname)
     {
         case GL_AMBIENT:
-            GX_SetChanAmbColor(GX_COLOR1A1, (GXColor){params[0] * 255, params[1] * 255, params[2] * 255, params[3] * 255});
+            set_chan_amb_color((GXColor){params[0] * 255, params[1] * 255, params[2] * 255, params[3] * 255});
             break;
         case GL_DIFFUSE:
-            GX_SetChanMatColor(GX_COLOR1A1, (GXColor){params[0] * 255, params[1] * 255, params[2] * 255, params[3] * 255});
+            set_chan_mat_color((GXColor){params[0] * 255, params[1] * 255, params[2] * 255, params[3] * 255});
             break;
     }
 }
@@ -1491,7 +1958,7 @@ void glBlendFunc(GLenum sfactor, GLenum dfactor)
     // TODO: implement
     sfactor = blend_factor(sfactor);
     dfactor = blend_factor(dfactor);
-    GX_SetBlendMode(GX_BM_BLEND, sfactor, dfactor, 0);
+    set_blend_mode(sfactor, dfactor);
 }
 
 void glTexGeni(GLenum coord, GLenum pname, GLint param)
@@ -1535,13 +2002,13 @@ void glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
         .b = blue * 255,
         .a = alpha * 255,
     };
-    GX_SetTevColor(GX_TEVREG0, color);
+    set_tev_color(GX_TEVREG0, color);
 }
 
 void glDepthMask(GLboolean flag)
 {
     zUpdate = flag;
-    GX_SetZMode(zEnable, zFunc, zUpdate);
+    set_z_mode(zEnable, zFunc, zUpdate);
 }
 
 void glFrontFace(GLenum mode)
@@ -1604,7 +2071,7 @@ void glPixelStorei(GLenum pname, GLint param)
 void glDepthFunc(GLenum func)
 {
     zFunc = gl_enum_to_gx(func);
-    GX_SetZMode(zEnable, zFunc, zUpdate);
+    set_z_mode(zEnable, zFunc, zUpdate);
 }
 
 void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
@@ -1633,7 +2100,7 @@ void glLightModelfv(GLenum pname, const GLfloat *params)
     {
         // Only one we need to support
         case GL_LIGHT_MODEL_AMBIENT:
-            GX_SetChanAmbColor(GX_COLOR1A1, (GXColor){params[0] * 255, params[1] * 255, params[2] * 255, params[3] * 255});
+            set_chan_amb_color((GXColor){params[0] * 255, params[1] * 255, params[2] * 255, params[3] * 255});
             break;
     }
 }
@@ -1678,7 +2145,7 @@ void glLightfv(GLenum light, GLenum pname, const GLfloat *params)
         case GL_SPECULAR:
             break;
     }
-    GX_LoadLightObj(&lightObj[lightNum], (1 << lightNum));
+    load_light_obj(&lightObj[lightNum], lightNum);
 }
 
 void glPointSize(GLfloat size)
@@ -1690,7 +2157,7 @@ void glPointSize(GLfloat size)
 void glCullFace(GLenum mode)
 {
     cullMode = gl_enum_to_gx(mode);
-    GX_SetCullMode(cullMode);
+    set_cull_mode(cullMode);
 }
 
 void glGetIntegerv(GLenum pname, GLint *data)
@@ -660,6 +660,7 @@ typedef double    GLclampd;
 #define GL_POINT_SIZE_MAX                 0x8127
 #define GL_POINT_DISTANCE_ATTENUATION     0x8129
 #define GL_GENERATE_MIPMAP                0x8191
+#define GL_GENERATE_MIPMAP_SGIS           0x8191
 #define GL_GENERATE_MIPMAP_HINT           0x8192
 #define GL_FOG_COORDINATE_SOURCE          0x8450
 #define GL_FOG_COORDINATE                 0x8451
@@ -827,9 +828,47 @@ typedef double    GLclampd;
 #define GL_COORD_REPLACE                  0x8862
 #define GL_MAX_TEXTURE_COORDS             0x8871
 
+/* Pre-tiled GX images for glCompressedTexImage2D.  The low byte is the
+ * GX_TF_* format of the data.  Mipmap levels may follow the base image,
+ * as GX lays them out, and are counted from the image size. */
+#define GL_GX_TEXTURE_WII                 0x9F00
+#define GL_GX_I8_WII                      0x9F01
+#define GL_GX_IA8_WII                     0x9F03
+#define GL_GX_RGB565_WII                  0x9F04
+#define GL_GX_RGB5A3_WII                  0x9F05
+#define GL_GX_CMPR_WII                    0x9F0E
+
 void wiigl_create_context(void);
 void wiigl_swap_buffers(void);
 
+/* glVertexPointer and glTexCoordPointer for GL_SHORT and GL_BYTE arrays in
+ * fixed point, with the given fraction bits.  The plain calls use none. */
+void wiigl_vertex_pointer(GLint size, GLenum type, GLsizei stride,
+  const GLvoid *pointer, GLuint frac);
+void wiigl_tex_coord_pointer(GLint size, GLenum type, GLsizei stride,
+  const GLvoid *pointer, GLuint frac);
+
+/* Debug query: GX state writes made, and skipped as redundant, in the last
+ * complete frame */
+enum
+{
+    WIIGL_STATE_TEXTURE,   /* texture object loads */
+    WIIGL_STATE_TEV,       /* TEV stage inputs and color registers */
+    WIIGL_STATE_MATRIX,    /* projection matrix loads */
+    WIIGL_STATE_VERTEX,    /* vertex descriptors, formats and arrays */
+    WIIGL_STATE_PIXEL,     /* depth, cull and blend modes */
+    WIIGL_STATE_LIGHTING,  /* color channels and light objects */
+    WIIGL_STATE_COUNT
+};
+
+struct wiigl_stats
+{
+    unsigned int written[WIIGL_STATE_COUNT];
+    unsigned int avoided[WIIGL_STATE_COUNT];
+};
+
+void wiigl_get_stats(struct wiigl_stats *stats);
+
 void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
 void glEnable(GLenum cap);
 void glDisable(GLenum cap);
@@ -858,6 +897,9 @@ void glDeleteTextures(GLsizei n, const GLuint *textures);
 void glTexImage2D(GLenum target, GLint level, GLint internalformat,
   GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type,
   const GLvoid *data);
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat,
+  GLsizei width, GLsizei height, GLint border, GLsizei imageSize,
+  const GLvoid *data);
 void glTexParameteri(GLenum target, GLenum pname, GLint param);
 void glBindTexture(GLenum target, GLuint texture);
 void glMaterialfv(GLenum face, GLenum pname, const GLfloat *params);
@@ -880,6 +922,9 @@ void glLoadIdentity(void);
 void glClipPlane(GLenum plane, const GLdouble *equation);
 void glOrtho(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top,
   GLdouble nearVal, GLdouble farVal);
+void glFrustum(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top,
+  GLdouble nearVal, GLdouble farVal);
+void glLoadMatrixf(const GLfloat *m);
 void glActiveTexture(GLenum texture);
 void glClientActiveTexture(GLenum texture);
 void glMultMatrixf(const GLfloat *m);
@@ -894,6 +939,8 @@ void glCullFace(GLenum mode);
 void glGetIntegerv(GLenum pname, GLint *data);
 const GLubyte *glGetString(GLenum name);
 void glPolygonMode(GLenum face, GLenum mode);
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height,
+  GLenum format, GLenum type, GLvoid *data);
 
 #define glGenBuffers_ glGenBuffers
 #define glDeleteBuffers_ glDeleteBuffers
@@ -208,6 +208,150 @@ void *image_load(const char *filename, int *width,
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * The following code reads only as much of an image as it takes to learn
+ * its size and the number of bytes per pixel image_load would give it.
+ */
+
+static int get_u32(const unsigned char *p)
+{
+    return (int) (((unsigned int) p[0] << 24) | ((unsigned int) p[1] << 16) |
+                  ((unsigned int) p[2] <<  8) |  (unsigned int) p[3]);
+}
+
+static int image_info_png(fs_file fh, int *width, int *height, int *bytes)
+{
+    static const unsigned char sig[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A,
+                                          0x1A, 0x0A };
+    unsigned char buf[33];
+    int w, h, b, type, trns = 0;
+
+    /* The signature, then IHDR, which comes first. */
+
+    if (fs_read(buf, 1, sizeof (buf), fh) != sizeof (buf) ||
+        memcmp(buf, sig, 8) != 0 || get_u32(buf + 8) != 13 ||
+        memcmp(buf + 12, "IHDR", 4) != 0)
+        return 0;
+
+    w    = get_u32(buf + 16);
+    h    = get_u32(buf + 20);
+    type = buf[25];
+
+    /*
+     * Look for transparency ahead of the image data.  png_set_expand
+     * makes it an alpha channel.
+     */
+
+    while (!trns && fs_read(buf, 1, 8, fh) == 8)
+    {
+        const int n = get_u32(buf);
+
+        if (memcmp(buf + 4, "tRNS", 4) == 0)
+            trns = 1;
+        else if (memcmp(buf + 4, "IDAT", 4) == 0 || n < 0 ||
+                 fs_seek(fh, n + 4, SEEK_CUR) != 0)
+            break;
+    }
+
+    switch (type)
+    {
+    case 0: b = 1 + trns; break;                       /* gray               */
+    case 2: b = 3 + trns; break;                       /* RGB                */
+    case 3: b = 3 + trns; break;                       /* palette            */
+    case 4: b = 2;        break;                       /* gray, alpha        */
+    case 6: b = 4;        break;                       /* RGB, alpha         */
+
+    default: return 0;
+    }
+
+    if (w > 0 && h > 0)
+    {
+        if (width)  *width  = w;
+        if (height) *height = h;
+        if (bytes)  *bytes  = b;
+        return 1;
+    }
+    return 0;
+}
+
+static int image_info_jpg(fs_file fh, int *width, int *height, int *bytes)
+{
+    unsigned char buf[6];
+    int c, n, w, h;
+
+    if (fs_getc(fh) != 0xFF || fs_getc(fh) != 0xD8)
+        return 0;
+
+    /* Walk the markers up to the start of frame. */
+
+    while ((c = fs_getc(fh)) >= 0)
+    {
+        if (c != 0xFF)
+            continue;
+
+        while ((c = fs_getc(fh)) == 0xFF)
+            ;
+
+        if (c == 0x00 || c == 0x01 || (c >= 0xD0 && c <= 0xD8))
+            continue;
+
+        if (c < 0 || c == 0xD9 || c == 0xDA || fs_read(buf, 1, 2, fh) != 2)
+            break;
+
+        n = (buf[0] << 8) | buf[1];
+
+        if (c >= 0xC0 && c <= 0xCF && c != 0xC4 && c != 0xC8 && c != 0xCC)
+        {
+            if (n < 8 || fs_read(buf, 1, 6, fh) != 6)
+                break;
+
+            w = (buf[3] << 8) | buf[4];
+            h = (buf[1] << 8) | buf[2];
+            c = buf[5];
+
+            /* A height of zero is given later, by a DNL marker. */
+
+            if (w > 0 && h > 0 && (c == 1 || c == 3 || c == 4))
+            {
+                if (width)  *width  = w;
+                if (height) *height = h;
+                if (bytes)  *bytes  = c;
+                return 1;
+            }
+            break;
+        }
+
+        if (n < 2 || fs_seek(fh, n - 2, SEEK_CUR) != 0)
+            break;
+    }
+    return 0;
+}
+
+/*
+ * Find the size of an image without decoding it.  Returns false if the
+ * header could not be read, in which case image_load may still succeed.
+ */
+int image_info(const char *filename, int *width, int *height, int *bytes)
+{
+    fs_file fh;
+    int rc = 0;
+
+    if (filename && (fh = fs_open(filename, "r")))
+    {
+        const char *ext = filename + strlen(filename) - 4;
+
+        if      (strcmp(ext, ".png") == 0 || strcmp(ext, ".PNG") == 0)
+            rc = image_info_png(fh, width, height, bytes);
+        else if (strcmp(ext, ".jpg") == 0 || strcmp(ext, ".JPG") == 0)
+            rc = image_info_jpg(fh, width, height, bytes);
+
+        fs_close(fh);
+    }
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+
 /*
  * Allocate and return a power-of-two image buffer with the given pixel buffer
  * centered within in.
@@ -7,6 +7,7 @@ void  image_size(int *, int *, int, int);
 void  image_near2(int *, int *, int, int);
 
 void *image_load(const char *, int *, int *, int *);
+int   image_info(const char *, int *, int *, int *);
 
 void *image_next2(const void *, int, int, int, int *, int *);
 void *image_scale(const void *, int, int, int, int *, int *, int);
@@ -243,15 +243,23 @@ GET_FUNC(CMD_JUMP_EXIT) { } END_FUNC;
 
 PUT_FUNC(CMD_BODY_PATH)
 {
-    put_index(fp, cmd->bodypath.bi);
-    put_index(fp, cmd->bodypath.pi);
+    int v[2];
+
+    v[0] = cmd->bodypath.bi;
+    v[1] = cmd->bodypath.pi;
+
+    put_index_array(fp, v, 2);
 }
 END_FUNC;
 
 GET_FUNC(CMD_BODY_PATH)
 {
-    cmd->bodypath.bi = get_index(fp);
-    cmd->bodypath.pi = get_index(fp);
+    int v[2];
+
+    get_index_array(fp, v, 2);
+
+    cmd->bodypath.bi = v[0];
+    cmd->bodypath.pi = v[1];
 }
 END_FUNC;
 
@@ -407,15 +415,13 @@ END_FUNC;
 
 PUT_FUNC(CMD_BALL_BASIS)
 {
-    put_array(fp, cmd->ballbasis.e[0], 3);
-    put_array(fp, cmd->ballbasis.e[1], 3);
+    put_array(fp, cmd->ballbasis.e[0], 6);
 }
 END_FUNC;
 
 GET_FUNC(CMD_BALL_BASIS)
 {
-    get_array(fp, cmd->ballbasis.e[0], 3);
-    get_array(fp, cmd->ballbasis.e[1], 3);
+    get_array(fp, cmd->ballbasis.e[0], 6);
 }
 END_FUNC;
 
@@ -426,15 +432,13 @@ END_FUNC;
 
 PUT_FUNC(CMD_BALL_PEND_BASIS)
 {
-    put_array(fp, cmd->ballpendbasis.E[0], 3);
-    put_array(fp, cmd->ballpendbasis.E[1], 3);
+    put_array(fp, cmd->ballpendbasis.E[0], 6);
 }
 END_FUNC;
 
 GET_FUNC(CMD_BALL_PEND_BASIS)
 {
-    get_array(fp, cmd->ballpendbasis.E[0], 3);
-    get_array(fp, cmd->ballpendbasis.E[1], 3);
+    get_array(fp, cmd->ballpendbasis.E[0], 6);
 }
 END_FUNC;
 
@@ -479,15 +483,13 @@ END_FUNC;
 
 PUT_FUNC(CMD_VIEW_BASIS)
 {
-    put_array(fp, cmd->viewbasis.e[0], 3);
-    put_array(fp, cmd->viewbasis.e[1], 3);
+    put_array(fp, cmd->viewbasis.e[0], 6);
 }
 END_FUNC;
 
 GET_FUNC(CMD_VIEW_BASIS)
 {
-    get_array(fp, cmd->viewbasis.e[0], 3);
-    get_array(fp, cmd->viewbasis.e[1], 3);
+    get_array(fp, cmd->viewbasis.e[0], 6);
 }
 END_FUNC;
 
@@ -515,15 +517,23 @@ END_FUNC;
 
 PUT_FUNC(CMD_PATH_FLAG)
 {
-    put_index(fp, cmd->pathflag.pi);
-    put_index(fp, cmd->pathflag.f);
+    int v[2];
+
+    v[0] = cmd->pathflag.pi;
+    v[1] = cmd->pathflag.f;
+
+    put_index_array(fp, v, 2);
 }
 END_FUNC;
 
 GET_FUNC(CMD_PATH_FLAG)
 {
-    cmd->pathflag.pi = get_index(fp);
-    cmd->pathflag.f  = get_index(fp);
+    int v[2];
+
+    get_index_array(fp, v, 2);
+
+    cmd->pathflag.pi = v[0];
+    cmd->pathflag.f = v[1];
 }
 END_FUNC;
 
@@ -597,15 +607,23 @@ END_FUNC;
 
 PUT_FUNC(CMD_MOVE_PATH)
 {
-    put_index(fp, cmd->movepath.mi);
-    put_index(fp, cmd->movepath.pi);
+    int v[2];
+
+    v[0] = cmd->movepath.mi;
+    v[1] = cmd->movepath.pi;
+
+    put_index_array(fp, v, 2);
 }
 END_FUNC;
 
 GET_FUNC(CMD_MOVE_PATH)
 {
-    cmd->movepath.mi = get_index(fp);
-    cmd->movepath.pi = get_index(fp);
+    int v[2];
+
+    get_index_array(fp, v, 2);
+
+    cmd->movepath.mi = v[0];
+    cmd->movepath.pi = v[1];
 }
 END_FUNC;
 
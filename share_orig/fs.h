@@ -17,6 +17,8 @@ const char *fs_get_write_dir(void);
 int fs_exists(const char *);
 int fs_remove(const char *);
 int fs_rename(const char *, const char *);
+int fs_stat(const char *, long *size, long long *mtime);
+int fs_touch(const char *);
 
 fs_file fs_open(const char *path, const char *mode);
 int     fs_close(fs_file);
@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <physfs.h>
+#include <utime.h>
 
 #include "fs.h"
 #include "dir.h"
@@ -174,11 +175,40 @@ int fs_exists(const char *path)
     return PHYSFS_exists(path);
 }
 
+int fs_stat(const char *path, long *size, long long *mtime)
+{
+    PHYSFS_file *handle;
+
+    if (!(handle = PHYSFS_openRead(path)))
+        return 0;
+
+    if (size)  *size  = (long) PHYSFS_fileLength(handle);
+    if (mtime) *mtime = (long long) PHYSFS_getLastModTime(path);
+
+    PHYSFS_close(handle);
+
+    return 1;
+}
+
 int fs_remove(const char *path)
 {
     return PHYSFS_delete(path);
 }
 
+int fs_touch(const char *path)
+{
+    const char *dir;
+    char *real;
+    int rc = 0;
+
+    if ((dir = PHYSFS_getWriteDir()) && (real = path_join(dir, path)))
+    {
+        rc = (utime(real, NULL) == 0);
+        free(real);
+    }
+    return rc;
+}
+
 /*---------------------------------------------------------------------------*/
 
 int fs_read(void *data, int size, int count, fs_file fh)
@@ -17,6 +17,8 @@
 #include <assert.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/stat.h>
+#include <utime.h>
 
 #include "fs.h"
 #include "dir.h"
@@ -267,12 +269,11 @@ fs_file fs_open(const char *path, const char *mode)
 
 int fs_close(fs_file fh)
 {
-    if (fclose(fh->handle))
-    {
-        free(fh);
-        return 1;
-    }
-    return 0;
+    int rc = (fclose(fh->handle) == 0);
+
+    free(fh);
+
+    return rc;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -301,6 +302,25 @@ int fs_exists(const char *path)
     return 0;
 }
 
+int fs_stat(const char *path, long *size, long long *mtime)
+{
+    struct stat st;
+    char *real;
+    int rc = 0;
+
+    if ((real = real_path(path)))
+    {
+        if (stat(real, &st) == 0)
+        {
+            if (size)  *size  = (long) st.st_size;
+            if (mtime) *mtime = (long long) st.st_mtime;
+            rc = 1;
+        }
+        free(real);
+    }
+    return rc;
+}
+
 int fs_remove(const char *path)
 {
     char *real;
@@ -313,6 +333,18 @@ int fs_remove(const char *path)
     return rc;
 }
 
+int fs_touch(const char *path)
+{
+    char *real;
+    int rc;
+
+    real = path_join(fs_dir_write, path);
+    rc = (utime(real, NULL) == 0);
+    free(real);
+
+    return rc;
+}
+
 /*---------------------------------------------------------------------------*/
 
 int fs_read(void *data, int size, int count, fs_file fh)
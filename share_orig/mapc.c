@@ -14,6 +14,8 @@
 
 /*---------------------------------------------------------------------------*/
 
+#define _DEFAULT_SOURCE 1 /* fork, mmap */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h> /* offsetof */
@@ -21,6 +23,16 @@
 #include <math.h>
 #include <sys/time.h>
 #include <assert.h>
+#include <errno.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#define ENABLE_BATCH_JOBS 1
+#endif
 
 #if ENABLE_RADIANT_CONSOLE
 /*
@@ -37,12 +49,17 @@
 #include "base_config.h"
 #include "fs.h"
 #include "common.h"
+#include "dir.h"
 
 #define MAXSTR 256
 #define MAXKEY 16
 #define SCALE  64.f
 #define SMALL  0.0005f
 
+/* Bump when a change to mapc alters the SOL files it writes. */
+
+#define MAPC_VERSION 4
+
 /*
  * The overall design  of this map converter is  very stupid, but very
  * simple. It  begins by assuming  that every mtrl, vert,  edge, side,
@@ -56,6 +73,23 @@
 static const char *input_file;
 static int         debug_output = 0;
 static int           csv_output = 0;
+static int          output_order = SOL_ORDER_NATIVE;
+static int     incremental_build = 0;
+
+enum
+{
+    NODE_SAH,                                  /* surface area heuristic     */
+    NODE_EVEN                                  /* even split of lump counts  */
+};
+
+static int          node_builder = NODE_SAH;
+static int             node_leaf = 8;          /* split nodes of this many   */
+
+#define VERT_FLOAT 1                           /* draw vertices              */
+#define VERT_SHORT 2                           /* packed vertices            */
+
+static int           vert_output = 0;
+static int           pack_output = 0;          /* SOL_PACK or 0              */
 
 /*---------------------------------------------------------------------------*/
 
@@ -239,6 +273,10 @@ static void bcast_quit(void)
 #define MAXD    1024
 #define MAXA    16384
 #define MAXI    262144
+#define MAXK    16384
+#define MAXY    1048576
+#define MAXC    262144
+#define MAXQ    262144
 
 static int overflow(const char *s)
 {
@@ -349,6 +387,26 @@ static int inci(struct s_base *fp)
     return (fp->ic < MAXI) ? fp->ic++ : overflow("indx");
 }
 
+static int inck(struct s_base *fp)
+{
+    return (fp->kc < MAXK) ? fp->kc++ : overflow("mesh");
+}
+
+static int incy(struct s_base *fp)
+{
+    return (fp->yc < MAXY) ? fp->yc++ : overflow("mndx");
+}
+
+static int incc(struct s_base *fp)
+{
+    return (fp->cc < MAXC) ? fp->cc++ : overflow("cvrt");
+}
+
+static int incq(struct s_base *fp)
+{
+    return (fp->qc < MAXQ) ? fp->qc++ : overflow("qvrt");
+}
+
 static void init_file(struct s_base *fp)
 {
     fp->mc = 0;
@@ -372,6 +430,10 @@ static void init_file(struct s_base *fp)
     fp->dc = 0;
     fp->ac = 0;
     fp->ic = 0;
+    fp->kc = 0;
+    fp->yc = 0;
+    fp->cc = 0;
+    fp->qc = 0;
 
     fp->mv = (struct b_mtrl *) calloc(MAXM, sizeof (*fp->mv));
     fp->vv = (struct b_vert *) calloc(MAXV, sizeof (*fp->vv));
@@ -394,6 +456,13 @@ static void init_file(struct s_base *fp)
     fp->dv = (struct b_dict *) calloc(MAXD, sizeof (*fp->dv));
     fp->av = (char *)          calloc(MAXA, sizeof (*fp->av));
     fp->iv = (int *)           calloc(MAXI, sizeof (*fp->iv));
+    fp->kv = (struct b_mesh *) calloc(MAXK, sizeof (*fp->kv));
+    fp->yv = (int *)           calloc(MAXY, sizeof (*fp->yv));
+
+    if (vert_output & VERT_FLOAT)
+        fp->cv = (struct b_cvrt *) calloc(MAXC, sizeof (*fp->cv));
+    if (vert_output & VERT_SHORT)
+        fp->qv = (struct b_qvrt *) calloc(MAXQ, sizeof (*fp->qv));
 }
 
 /*---------------------------------------------------------------------------*/
@@ -542,18 +611,238 @@ static void free_imagedata()
     image_n = image_alloc = 0;
 }
 
+/*
+ * With --image-cache, image sizes also persist from one run to the next
+ * in the given file, along with the size and modification time of each
+ * image.  An image that has not changed since is not opened at all.
+ * Otherwise, only the image header is read.  Each line of the file
+ * holds the modification time, the file size, the image width, height
+ * and bytes per pixel (2 or 4 with alpha), and the path of the image.
+ */
+
+#define IMAGE_CACHE_HEAD "mapc-images 1"
+
+struct _imagecache
+{
+    char name[MAXSTR];
+    long long mtime;
+    long size;
+    int w, h, b;
+};
+
+static const char *image_cache = NULL;
+
+static struct _imagecache *imagecache = NULL;
+static int cache_n = 0;
+static int cache_alloc = 0;
+static int cache_dirty = 0;
+
+static struct _imagecache *cache_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < cache_n; i++)
+        if (strcmp(imagecache[i].name, name) == 0)
+            return imagecache + i;
+
+    return NULL;
+}
+
+static void cache_note(const char *name, long long mtime, long size,
+                       int w, int h, int b)
+{
+    struct _imagecache *cp;
+
+    if (!(cp = cache_find(name)))
+    {
+        if (cache_n == cache_alloc)
+        {
+            cache_alloc = cache_alloc ? cache_alloc * 2 : 64;
+
+            if (!(imagecache = (struct _imagecache *)
+                  realloc(imagecache, cache_alloc * sizeof (*imagecache))))
+            {
+                printf("malloc error\n");
+                exit(1);
+            }
+        }
+
+        cp = imagecache + cache_n++;
+        SAFECPY(cp->name, name);
+    }
+
+    cp->mtime = mtime;
+    cp->size  = size;
+    cp->w     = w;
+    cp->h     = h;
+    cp->b     = b;
+}
+
+/*
+ * Read the cache file.  With MERGE, keep what this process has learned
+ * over what the file says.
+ */
+static void cache_load(int merge)
+{
+    char line[MAXSTR * 2];
+    long long mtime;
+    long size;
+    int w, h, b, n;
+    FILE *fin;
+
+    if (!(fin = fopen(image_cache, "r")))
+        return;
+
+    if (fgets(line, sizeof (line), fin) &&
+        strcmp(strip_newline(line), IMAGE_CACHE_HEAD) == 0)
+    {
+        while (fgets(line, sizeof (line), fin))
+        {
+            strip_newline(line);
+
+            if (sscanf(line, "%lld %ld %d %d %d %n",
+                       &mtime, &size, &w, &h, &b, &n) == 5 && line[n] &&
+                !(merge && cache_find(line + n)))
+                cache_note(line + n, mtime, size, w, h, b);
+        }
+    }
+    fclose(fin);
+}
+
+/*
+ * Hold a lock on a file beside the cache, so that only one mapc process
+ * at a time reads, merges and replaces it.  The cache itself can't be
+ * locked, as it is replaced.  Return a descriptor to unlock, or -1.
+ */
+static int cache_lock(void)
+{
+#if ENABLE_BATCH_JOBS
+    char name[MAXSTR];
+    int fd;
+
+    snprintf(name, sizeof (name), "%s.lock", image_cache);
+
+    if ((fd = open(name, O_RDWR | O_CREAT, 0666)) >= 0)
+    {
+        while (flock(fd, LOCK_EX) != 0)
+        {
+            if (errno != EINTR)
+            {
+                close(fd);
+                return -1;
+            }
+        }
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+static void cache_unlock(int fd)
+{
+#if ENABLE_BATCH_JOBS
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
+/*
+ * Write the cache file, if anything was added to it.  Other mapc
+ * processes may be doing the same, so under the lock, merge in their
+ * entries and replace the file in one step.  Without the lock (not on
+ * POSIX systems) a concurrent writer's new entries may be lost, which
+ * only costs a later run some image reads.
+ */
+static void cache_stor(void)
+{
+    char temp[MAXSTR];
+    FILE *fout;
+    int lock;
+    int i;
+
+    if (!image_cache || !cache_dirty)
+        return;
+
+#if ENABLE_BATCH_JOBS
+    snprintf(temp, sizeof (temp), "%s.%d", image_cache, (int) getpid());
+#else
+    snprintf(temp, sizeof (temp), "%s.tmp", image_cache);
+#endif
+
+    lock = cache_lock();
+
+    cache_load(1);
+
+    if ((fout = fopen(temp, "w")))
+    {
+        fprintf(fout, "%s\n", IMAGE_CACHE_HEAD);
+
+        for (i = 0; i < cache_n; i++)
+            fprintf(fout, "%lld %ld %d %d %d %s\n",
+                    imagecache[i].mtime, imagecache[i].size,
+                    imagecache[i].w, imagecache[i].h, imagecache[i].b,
+                    imagecache[i].name);
+
+        if (fclose(fout) == 0 && rename(temp, image_cache) != 0)
+        {
+            remove(image_cache);
+            rename(temp, image_cache);
+        }
+        remove(temp);
+    }
+
+    cache_unlock(lock);
+
+    cache_dirty = 0;
+}
+
+static void free_imagecache(void)
+{
+    free(imagecache);
+    imagecache = NULL;
+
+    cache_n = cache_alloc = 0;
+}
+
 static int size_load(const char *file, int *w, int *h)
 {
+    struct _imagecache *cp;
+    long long mtime;
+    long size;
     void *p;
+    int b;
 
-    if ((p = image_load(file, w, h, NULL)))
+    if (!fs_stat(file, &size, &mtime))
+        return 0;
+
+    if ((cp = cache_find(file)) && cp->mtime == mtime && cp->size == size)
     {
-        free(p);
+        *w = cp->w;
+        *h = cp->h;
         return 1;
     }
-    return 0;
+
+    /* Decode the image only if its header can't be made out. */
+
+    if (!image_info(file, w, h, &b))
+    {
+        if (!(p = image_load(file, w, h, &b)))
+            return 0;
+
+        free(p);
+    }
+
+    if (image_cache)
+    {
+        cache_note(file, mtime, size, *w, *h, b);
+        cache_dirty = 1;
+    }
+    return 1;
 }
 
+static void deps_image(const char *, int, int);
+
 static void size_image(const char *name, int *w, int *h)
 {
     char path[MAXSTR];
@@ -566,6 +855,7 @@ static void size_image(const char *name, int *w, int *h)
                 *w = imagedata[i].w;
                 *h = imagedata[i].h;
 
+                deps_image(name, *w, *h);
                 return;
             }
 
@@ -607,6 +897,248 @@ static void size_image(const char *name, int *w, int *h)
 
         image_n++;
     }
+
+    deps_image(name, *w, *h);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * The following code records  what went into a SOL file: the map, the
+ * materials and  models it read, the  sizes of the  textures it used,
+ * and the version  of mapc.  With --incremental, this  is written to a
+ * manifest next  to the SOL,  and a map  whose manifest still  matches
+ * is not compiled again.
+ */
+
+enum
+{
+    DEP_MAP,
+    DEP_MTRL,
+    DEP_OBJ,
+    DEP_IMAGE
+};
+
+static const char *dep_names[] = { "map", "mtrl", "obj", "image" };
+
+struct dep
+{
+    int  type;
+    char name[MAXSTR];
+
+    unsigned long long hash;                   /* contents, or 0 if missing  */
+    int w, h;                                  /* image size                 */
+};
+
+static struct dep *deps = NULL;
+static int deps_n = 0;
+static int deps_alloc = 0;
+
+static unsigned long long hash_bytes(unsigned long long h,
+                                     const unsigned char *p, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/* Hash the file found first among the given paths, 0 if there is none. */
+
+static unsigned long long hash_file(const char *name,
+                                    const struct path *paths, int n)
+{
+    unsigned char buf[4096];
+    char path[MAXSTR];
+    fs_file fin;
+    int i, c;
+
+    for (i = 0; i < n; i++)
+    {
+        if (paths)
+            CONCAT_PATH(path, &paths[i], name);
+        else
+            SAFECPY(path, name);
+
+        if ((fin = fs_open(path, "r")))
+        {
+            unsigned long long h = 14695981039346656037ull;
+
+            h = hash_bytes(h, (const unsigned char *) path, strlen(path));
+
+            while ((c = fs_read(buf, 1, sizeof (buf), fin)) > 0)
+                h = hash_bytes(h, buf, c);
+
+            fs_close(fin);
+
+            return h ? h : 1;
+        }
+    }
+    return 0;
+}
+
+static unsigned long long deps_hash(int type, const char *name)
+{
+    switch (type)
+    {
+    case DEP_MAP:  return hash_file(name, NULL, 1);
+    case DEP_MTRL: return hash_file(name, mtrl_paths, ARRAYSIZE(mtrl_paths));
+    case DEP_OBJ:  return hash_file(name, NULL, 1);
+    }
+    return 0;
+}
+
+static struct dep *deps_find(int type, const char *name)
+{
+    int i;
+
+    for (i = 0; i < deps_n; i++)
+        if (deps[i].type == type && strcmp(deps[i].name, name) == 0)
+            return deps + i;
+
+    return NULL;
+}
+
+static struct dep *deps_new(int type, const char *name)
+{
+    struct dep *dp;
+
+    if ((dp = deps_find(type, name)))
+        return NULL;
+
+    if (deps_n == deps_alloc)
+    {
+        deps_alloc = deps_alloc ? deps_alloc * 2 : 64;
+
+        if (!(deps = (struct dep *) realloc(deps, deps_alloc * sizeof (*deps))))
+        {
+            printf("malloc error\n");
+            exit(1);
+        }
+    }
+
+    dp = memset(deps + deps_n++, 0, sizeof (*deps));
+
+    dp->type = type;
+    SAFECPY(dp->name, name);
+
+    return dp;
+}
+
+static void deps_file(int type, const char *name)
+{
+    struct dep *dp;
+
+    if (incremental_build && (dp = deps_new(type, name)))
+        dp->hash = deps_hash(type, name);
+}
+
+static void deps_image(const char *name, int w, int h)
+{
+    struct dep *dp;
+
+    if (incremental_build && (dp = deps_new(DEP_IMAGE, name)))
+    {
+        dp->w = w;
+        dp->h = h;
+    }
+}
+
+static void deps_head(char *str, size_t len)
+{
+    snprintf(str, len,
+             "mapc %d order %d debug %d bsp %d leaf %d verts %d pack %d",
+             MAPC_VERSION, output_order, debug_output,
+             node_builder, node_leaf, vert_output, pack_output);
+}
+
+static void deps_stor(const char *name)
+{
+    char head[MAXSTR];
+    fs_file fout;
+    int i;
+
+    if ((fout = fs_open(name, "w")))
+    {
+        deps_head(head, sizeof (head));
+
+        fs_printf(fout, "%s\n", head);
+
+        for (i = 0; i < deps_n; i++)
+        {
+            const struct dep *dp = deps + i;
+
+            if (dp->type == DEP_IMAGE)
+                fs_printf(fout, "%s %d %d %s\n", dep_names[dp->type],
+                          dp->w, dp->h, dp->name);
+            else
+                fs_printf(fout, "%s %016llx %s\n", dep_names[dp->type],
+                          dp->hash, dp->name);
+        }
+        fs_close(fout);
+    }
+}
+
+/*
+ * Return true if the manifest NAME exists and everything it lists is
+ * unchanged.
+ */
+static int deps_load(const char *name)
+{
+    char line[MAXSTR * 2];
+    char head[MAXSTR];
+    char type[16];
+    unsigned long long hash;
+    fs_file fin;
+    int i, n, m, w, h, ok = 0;
+
+    if (!(fin = fs_open(name, "r")))
+        return 0;
+
+    deps_head(head, sizeof (head));
+
+    if (fs_gets(line, sizeof (line), fin) &&
+        strcmp(strip_newline(line), head) == 0)
+    {
+        ok = 1;
+
+        while (ok && fs_gets(line, sizeof (line), fin))
+        {
+            strip_newline(line);
+
+            if (sscanf(line, "%15s %n", type, &n) < 1)
+                continue;
+
+            for (i = 0; i < ARRAYSIZE(dep_names); i++)
+                if (strcmp(type, dep_names[i]) == 0)
+                    break;
+
+            if (i == DEP_IMAGE)
+            {
+                int iw, ih;
+
+                if ((ok = (sscanf(line + n, "%d %d %n", &w, &h, &m) == 2)))
+                {
+                    size_image(line + n + m, &iw, &ih);
+                    ok = (iw == w && ih == h);
+                }
+            }
+            else if (i < ARRAYSIZE(dep_names))
+            {
+                if ((ok = (sscanf(line + n, "%llx %n", &hash, &m) == 1)))
+                    ok = (deps_hash(i, line + n + m) == hash);
+            }
+            else ok = 0;
+        }
+    }
+
+    fs_close(fin);
+
+    return ok;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -626,6 +1158,8 @@ static int read_mtrl(struct s_base *fp, const char *name)
 
     mp = fp->mv + incm(fp);
 
+    deps_file(DEP_MTRL, name);
+
     if (!mtrl_read(mp, name))
     {
         SAFECPY(buf, input_file);
@@ -786,6 +1320,8 @@ static void read_obj(struct s_base *fp, const char *name, int mi)
     int t0 = fp->tc;
     int s0 = fp->sc;
 
+    deps_file(DEP_OBJ, name);
+
     if ((fin = fs_open(name, "r")))
     {
         while (fs_gets(line, MAXSTR, fin))
@@ -2052,15 +2588,254 @@ static void uniq_mtrl(struct s_base *fp)
     fp->mc = k;
 }
 
-static void uniq_vert(struct s_base *fp)
-{
-    int i, j, k = 0;
+/*
+ * The passes below keep the result of a linear search for the first
+ * equal element, but find candidates through a hash of cell keys.  An
+ * element is filed under one cell; a query probes that cell and, for
+ * approximate comparisons, its neighbours.  Among the candidates, the
+ * lowest index that compares equal wins, exactly as before.  Elements
+ * that have no cell (non-finite values, odd normals) go on a list that
+ * every query probes, and queries that have no cell search linearly.
+ */
+
+#define CELL_V (4 * SMALL)                     /* vert and texc cell size    */
+#define CELL_D (4 * SMALL)                     /* side distance cell size    */
+#define CELL_N 0.01                            /* side normal cell size      */
+
+struct uniq
+{
+    int  n;                                    /* bucket count, or 0         */
+    int *bv;                                   /* first element per bucket   */
+    int *nv;                                   /* next element in bucket     */
+    int  m;                                    /* first element with no cell */
+};
+
+typedef int (*uniq_fn)(const struct s_base *, const void *, int);
+
+static void uniq_init(struct uniq *up, int c)
+{
+    int i;
+
+    up->n = 1;
+    up->m = -1;
+
+    while (up->n < 2 * c)
+        up->n *= 2;
+
+    up->bv = malloc(up->n * sizeof (int));
+    up->nv = malloc((c > 0 ? c : 1) * sizeof (int));
+
+    /* Without buckets, every element goes on the probe-always list. */
+
+    if (up->bv == NULL)
+        up->n = 0;
+
+    for (i = 0; i < up->n; i++)
+        up->bv[i] = -1;
+}
+
+static void uniq_free(struct uniq *up)
+{
+    free(up->bv);
+    free(up->nv);
+}
+
+static unsigned int uniq_hash(const int *k, int d)
+{
+    unsigned int h = 2166136261u;
+    int i;
+
+    for (i = 0; i < d; i++)
+        h = (h ^ (unsigned int) k[i]) * 16777619u;
+
+    return h;
+}
+
+static int uniq_cell(int *k, float x, double s)
+{
+    double y = floor(x / s);
+
+    if (!(fabs(y) < 1.0e9))
+        return 0;
+
+    *k = (int) y;
+    return 1;
+}
+
+static void uniq_add(struct uniq *up, const int *k, int d, int i)
+{
+    if (k && up->n)
+    {
+        int b = uniq_hash(k, d) & (up->n - 1);
+
+        up->nv[i] = up->bv[b];
+        up->bv[b] = i;
+    }
+    else
+    {
+        up->nv[i] = up->m;
+        up->m     = i;
+    }
+}
+
+/*
+ * Return the lowest index below J of an element equal to P, probing the
+ * cells within R of cell K in each of D dimensions.  Return J if none.
+ */
+static int uniq_find(const struct uniq *up, const int *k, int d, int r,
+                     const struct s_base *fp, const void *p,
+                     uniq_fn comp, int j)
+{
+    int e[4];
+    int c, i, o, x, q;
+
+    if (k == NULL)
+    {
+        for (x = 0; x < j; x++)
+            if (comp(fp, p, x))
+                return x;
+        return j;
+    }
+
+    if (up->n)
+    {
+        for (c = 1, i = 0; i < d; i++)
+            c *= 2 * r + 1;
+
+        for (o = 0; o < c; o++)
+        {
+            for (q = o, i = 0; i < d; i++, q /= 2 * r + 1)
+                e[i] = k[i] + q % (2 * r + 1) - r;
+
+            for (x = up->bv[uniq_hash(e, d) & (up->n - 1)]; x >= 0;
+                 x = up->nv[x])
+                if (x < j && comp(fp, p, x))
+                    j = x;
+        }
+    }
+
+    for (x = up->m; x >= 0; x = up->nv[x])
+        if (x < j && comp(fp, p, x))
+            j = x;
+
+    return j;
+}
+
+static int find_vert(const struct s_base *fp, const void *p, int j)
+{
+    return comp_vert(p, fp->vv + j);
+}
+
+static int find_edge(const struct s_base *fp, const void *p, int j)
+{
+    return comp_edge(p, fp->ev + j);
+}
+
+static int find_side(const struct s_base *fp, const void *p, int j)
+{
+    return comp_side(p, fp->sv + j);
+}
+
+static int find_texc(const struct s_base *fp, const void *p, int j)
+{
+    return comp_texc(p, fp->tv + j);
+}
+
+static int find_offs(const struct s_base *fp, const void *p, int j)
+{
+    return comp_offs(p, fp->ov + j);
+}
+
+static int find_geom(const struct s_base *fp, const void *p, int j)
+{
+    return comp_geom(p, fp->gv + j);
+}
+
+/*
+ * Cell keys.  A vert or texc matches within SMALL on each axis, so the
+ * neighbouring cells cover it.  Sides match within SMALL in distance
+ * and with a dot product of at least one, which for normals of unit
+ * length leaves them well within one normal cell of each other.  Edges
+ * match on the unordered vert pair, except that a degenerate edge
+ * matches any edge using its vert, so it has no key.
+ */
+
+static int *key_vert(int *k, const struct b_vert *vp)
+{
+    if (uniq_cell(k + 0, vp->p[0], CELL_V) &&
+        uniq_cell(k + 1, vp->p[1], CELL_V) &&
+        uniq_cell(k + 2, vp->p[2], CELL_V))
+        return k;
+
+    return NULL;
+}
+
+static int *key_edge(int *k, const struct b_edge *ep)
+{
+    if (ep->vi == ep->vj)
+        return NULL;
+
+    k[0] = MIN(ep->vi, ep->vj);
+    k[1] = MAX(ep->vi, ep->vj);
+
+    return k;
+}
+
+static int *key_side(int *k, const struct b_side *sp)
+{
+    double l = ((double) sp->n[0] * sp->n[0] +
+                (double) sp->n[1] * sp->n[1] +
+                (double) sp->n[2] * sp->n[2]);
+
+    if (fabs(l - 1.0) < 1.0e-5 &&
+        uniq_cell(k + 0, sp->d,    CELL_D) &&
+        uniq_cell(k + 1, sp->n[0], CELL_N) &&
+        uniq_cell(k + 2, sp->n[1], CELL_N) &&
+        uniq_cell(k + 3, sp->n[2], CELL_N))
+        return k;
+
+    return NULL;
+}
+
+static int *key_texc(int *k, const struct b_texc *tp)
+{
+    if (uniq_cell(k + 0, tp->u[0], CELL_V) &&
+        uniq_cell(k + 1, tp->u[1], CELL_V))
+        return k;
+
+    return NULL;
+}
+
+static int *key_offs(int *k, const struct b_offs *op)
+{
+    k[0] = op->ti;
+    k[1] = op->si;
+    k[2] = op->vi;
+
+    return k;
+}
+
+static int *key_geom(int *k, const struct b_geom *gp)
+{
+    k[0] = gp->mi;
+    k[1] = gp->oi;
+    k[2] = gp->oj;
+    k[3] = gp->ok;
+
+    return k;
+}
+
+static void uniq_vert(struct s_base *fp)
+{
+    struct uniq u;
+    int i, j, k = 0, c[3], *key;
+
+    uniq_init(&u, fp->vc);
 
     for (i = 0; i < fp->vc; i++)
     {
-        for (j = 0; j < k; j++)
-            if (comp_vert(fp->vv + i, fp->vv + j))
-                break;
+        key = key_vert(c, fp->vv + i);
+        j   = uniq_find(&u, key, 3, 1, fp, fp->vv + i, find_vert, k);
 
         vert_swaps[i] = j;
 
@@ -2068,10 +2843,13 @@ static void uniq_vert(struct s_base *fp)
         {
             if (i != k)
                 fp->vv[k] = fp->vv[i];
+            uniq_add(&u, key, 3, k);
             k++;
         }
     }
 
+    uniq_free(&u);
+
     apply_vert_swaps(fp);
 
     fp->vc = k;
@@ -2079,13 +2857,15 @@ static void uniq_vert(struct s_base *fp)
 
 static void uniq_edge(struct s_base *fp)
 {
-    int i, j, k = 0;
+    struct uniq u;
+    int i, j, k = 0, c[2], *key;
+
+    uniq_init(&u, fp->ec);
 
     for (i = 0; i < fp->ec; i++)
     {
-        for (j = 0; j < k; j++)
-            if (comp_edge(fp->ev + i, fp->ev + j))
-                break;
+        key = key_edge(c, fp->ev + i);
+        j   = uniq_find(&u, key, 2, 0, fp, fp->ev + i, find_edge, k);
 
         edge_swaps[i] = j;
 
@@ -2093,10 +2873,21 @@ static void uniq_edge(struct s_base *fp)
         {
             if (i != k)
                 fp->ev[k] = fp->ev[i];
+
+            /* A degenerate edge is found by its own pair only. */
+
+            if (key == NULL)
+            {
+                c[0] = c[1] = fp->ev[k].vi;
+                key  = c;
+            }
+            uniq_add(&u, key, 2, k);
             k++;
         }
     }
 
+    uniq_free(&u);
+
     apply_edge_swaps(fp);
 
     fp->ec = k;
@@ -2104,13 +2895,15 @@ static void uniq_edge(struct s_base *fp)
 
 static void uniq_offs(struct s_base *fp)
 {
-    int i, j, k = 0;
+    struct uniq u;
+    int i, j, k = 0, c[3], *key;
+
+    uniq_init(&u, fp->oc);
 
     for (i = 0; i < fp->oc; i++)
     {
-        for (j = 0; j < k; j++)
-            if (comp_offs(fp->ov + i, fp->ov + j))
-                break;
+        key = key_offs(c, fp->ov + i);
+        j   = uniq_find(&u, key, 3, 0, fp, fp->ov + i, find_offs, k);
 
         offs_swaps[i] = j;
 
@@ -2118,10 +2911,13 @@ static void uniq_offs(struct s_base *fp)
         {
             if (i != k)
                 fp->ov[k] = fp->ov[i];
+            uniq_add(&u, key, 3, k);
             k++;
         }
     }
 
+    uniq_free(&u);
+
     apply_offs_swaps(fp);
 
     fp->oc = k;
@@ -2129,13 +2925,15 @@ static void uniq_offs(struct s_base *fp)
 
 static void uniq_geom(struct s_base *fp)
 {
-    int i, j, k = 0;
+    struct uniq u;
+    int i, j, k = 0, c[4], *key;
+
+    uniq_init(&u, fp->gc);
 
     for (i = 0; i < fp->gc; i++)
     {
-        for (j = 0; j < k; j++)
-            if (comp_geom(fp->gv + i, fp->gv + j))
-                break;
+        key = key_geom(c, fp->gv + i);
+        j   = uniq_find(&u, key, 4, 0, fp, fp->gv + i, find_geom, k);
 
         geom_swaps[i] = j;
 
@@ -2143,10 +2941,13 @@ static void uniq_geom(struct s_base *fp)
         {
             if (i != k)
                 fp->gv[k] = fp->gv[i];
+            uniq_add(&u, key, 4, k);
             k++;
         }
     }
 
+    uniq_free(&u);
+
     apply_geom_swaps(fp);
 
     fp->gc = k;
@@ -2154,13 +2955,15 @@ static void uniq_geom(struct s_base *fp)
 
 static void uniq_texc(struct s_base *fp)
 {
-    int i, j, k = 0;
+    struct uniq u;
+    int i, j, k = 0, c[2], *key;
+
+    uniq_init(&u, fp->tc);
 
     for (i = 0; i < fp->tc; i++)
     {
-        for (j = 0; j < k; j++)
-            if (comp_texc(fp->tv + i, fp->tv + j))
-                break;
+        key = key_texc(c, fp->tv + i);
+        j   = uniq_find(&u, key, 2, 1, fp, fp->tv + i, find_texc, k);
 
         texc_swaps[i] = j;
 
@@ -2168,10 +2971,13 @@ static void uniq_texc(struct s_base *fp)
         {
             if (i != k)
                 fp->tv[k] = fp->tv[i];
+            uniq_add(&u, key, 2, k);
             k++;
         }
     }
 
+    uniq_free(&u);
+
     apply_texc_swaps(fp);
 
     fp->tc = k;
@@ -2179,13 +2985,15 @@ static void uniq_texc(struct s_base *fp)
 
 static void uniq_side(struct s_base *fp)
 {
-    int i, j, k = 0;
+    struct uniq u;
+    int i, j, k = 0, c[4], *key;
+
+    uniq_init(&u, fp->sc);
 
     for (i = 0; i < fp->sc; i++)
     {
-        for (j = 0; j < k; j++)
-            if (comp_side(fp->sv + i, fp->sv + j))
-                break;
+        key = key_side(c, fp->sv + i);
+        j   = uniq_find(&u, key, 4, 1, fp, fp->sv + i, find_side, k);
 
         side_swaps[i] = j;
 
@@ -2193,10 +3001,13 @@ static void uniq_side(struct s_base *fp)
         {
             if (i != k)
                 fp->sv[k] = fp->sv[i];
+            uniq_add(&u, key, 4, k);
             k++;
         }
     }
 
+    uniq_free(&u);
+
     apply_side_swaps(fp);
 
     fp->sc = k;
@@ -2493,9 +3304,188 @@ static int test_lump_side(const struct s_base *fp,
     return 0;
 }
 
+/*
+ * The BSP of each body is built  top-down.  The default builder picks
+ * the splitting side with a  surface area heuristic: the expected cost
+ * of a node is the  lumps it holds plus the cost of each child, scaled
+ * by the chance that a query  reaching the node reaches the child, as
+ * estimated from the surface areas of boxes around the bounding spheres
+ * of their lumps.  Candidates  are the sides of the lumps  in the node.
+ * The older builder picks the side, among all sides of the file, that
+ * most evenly splits the lumps.
+ */
+
+#define NODE_TRAV 0.25f                        /* node cost, in lump tests   */
+#define NODE_SPAN 4.0f                         /* weight of straddling lumps */
+
+static int *node_mark;                         /* sides tried, by node       */
+static int  node_stamp;
+
+static void node_box(float b[6])
+{
+    b[0] = b[1] = b[2] = +HUGE_VALF;
+    b[3] = b[4] = b[5] = -HUGE_VALF;
+}
+
+static void node_grow(float b[6], const struct b_lump *lp, const float s[4])
+{
+    int i;
+
+    if (lp->vc)
+        for (i = 0; i < 3; i++)
+        {
+            b[i]     = MIN(b[i],     s[i] - s[3]);
+            b[i + 3] = MAX(b[i + 3], s[i] + s[3]);
+        }
+}
+
+static float node_area(const float b[6])
+{
+    float x = b[3] - b[0];
+    float y = b[4] - b[1];
+    float z = b[5] - b[2];
+
+    if (x < 0.0f || y < 0.0f || z < 0.0f)
+        return 0.0f;
+
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+static int node_even(struct s_base *fp, int l0, int lc, float bsphere[][4])
+{
+    int sj  = 0;
+    int sjd = lc;
+    int sjo = lc;
+    int si;
+    int li;
+
+    /* Find the side that most evenly splits the given lumps. */
+
+    for (si = 0; si < fp->sc; si++)
+    {
+        int o = 0;
+        int d = 0;
+        int k = 0;
+
+        for (li = 0; li < lc; li++)
+            if ((k = test_lump_side(fp,
+                                    fp->lv + l0 + li,
+                                    fp->sv + si,
+                                    bsphere[l0 + li])))
+                d += k;
+            else
+                o++;
+
+        d = abs(d);
+
+        if ((d < sjd) || (d == sjd && o < sjo))
+        {
+            sj  = si;
+            sjd = d;
+            sjo = o;
+        }
+    }
+    return sj;
+}
+
+/*
+ * Return the side with the least expected cost, or -1 if no side splits
+ * the lumps.  The estimate prices each child as a leaf, which overstates
+ * children that will be split again, so the lumps straddling the side,
+ * which every query of the node must test, are weighed more heavily.
+ */
+
+static int node_sah(struct s_base *fp, int l0, int lc, float bsphere[][4])
+{
+    float a, c, best = HUGE_VALF;
+    float box[6];
+    float f[6];
+    float b[6];
+
+    int sj = -1;
+    int li, lj, i;
+
+    node_box(box);
+
+    for (li = 0; li < lc; li++)
+        node_grow(box, fp->lv + l0 + li, bsphere[l0 + li]);
+
+    if ((a = node_area(box)) <= 0.0f)
+        return -1;
+
+    node_stamp++;
+
+    for (li = 0; li < lc; li++)
+    {
+        const struct b_lump *lp = fp->lv + l0 + li;
+
+        for (i = 0; i < lp->sc; i++)
+        {
+            int si = fp->iv[lp->s0 + i];
+            int nf = 0;
+            int nb = 0;
+            int no = 0;
+
+            if (node_mark[si] == node_stamp)
+                continue;
+
+            node_mark[si] = node_stamp;
+
+            node_box(f);
+            node_box(b);
+
+            for (lj = 0; lj < lc; lj++)
+                switch (test_lump_side(fp,
+                                       fp->lv + l0 + lj,
+                                       fp->sv + si,
+                                       bsphere[l0 + lj]))
+                {
+                case +1:
+                    node_grow(f, fp->lv + l0 + lj, bsphere[l0 + lj]);
+                    nf++;
+                    break;
+                case  0:
+                    no++;
+                    break;
+                case -1:
+                    node_grow(b, fp->lv + l0 + lj, bsphere[l0 + lj]);
+                    nb++;
+                    break;
+                }
+
+            /* A split must leave every part smaller than the whole. */
+
+            if (nf == lc || nb == lc || no == lc)
+                continue;
+
+            c = NODE_TRAV + no * NODE_SPAN +
+                (node_area(f) * nf + node_area(b) * nb) / a;
+
+            if (c < best)
+            {
+                best = c;
+                sj   = si;
+            }
+        }
+    }
+    return sj;
+}
+
 static int node_node(struct s_base *fp, int l0, int lc, float bsphere[][4])
 {
-    if (lc < 8)
+    int sj = -1;
+
+    if (lc >= node_leaf)
+    {
+        /* The SAH builder needs its marks.  Split evenly if they failed. */
+
+        if (node_builder == NODE_EVEN || node_mark == NULL)
+            sj = node_even(fp, l0, lc, bsphere);
+        else
+            sj = node_sah(fp, l0, lc, bsphere);
+    }
+
+    if (sj < 0)
     {
         /* Base case.  Dump all given lumps into a leaf node. */
 
@@ -2509,42 +3499,11 @@ static int node_node(struct s_base *fp, int l0, int lc, float bsphere[][4])
     }
     else
     {
-        int sj  = 0;
-        int sjd = lc;
-        int sjo = lc;
-        int si;
         int li = 0, lic = 0;
         int lj = 0, ljc = 0;
         int lk = 0, lkc = 0;
         int i;
 
-        /* Find the side that most evenly splits the given lumps. */
-
-        for (si = 0; si < fp->sc; si++)
-        {
-            int o = 0;
-            int d = 0;
-            int k = 0;
-
-            for (li = 0; li < lc; li++)
-                if ((k = test_lump_side(fp,
-                                        fp->lv + l0 + li,
-                                        fp->sv + si,
-                                        bsphere[l0 + li])))
-                    d += k;
-                else
-                    o++;
-
-            d = abs(d);
-
-            if ((d < sjd) || (d == sjd && o < sjo))
-            {
-                sj  = si;
-                sjd = d;
-                sjo = o;
-            }
-        }
-
         /* Flag each lump with its position WRT the side. */
 
         for (li = 0; li < lc; li++)
@@ -2666,9 +3625,54 @@ static void lump_bounding_sphere(struct s_base *fp,
     bsphere[3] = fsqrtf(r);
 }
 
-static void node_file(struct s_base *fp)
+/*
+ * Return the expected cost of a query of node NI, in lump tests, by the
+ * same measure the builder uses.  Find the box of its lumps in BOX.
+ */
+static float node_cost(const struct s_base *fp, int ni,
+                       float bsphere[][4], float box[6])
+{
+    const struct b_node *np = fp->nv + ni;
+
+    float c = (float) np->lc, a;
+    float b[2][6];
+    float e[2];
+    int i;
+
+    node_box(box);
+
+    for (i = 0; i < np->lc; i++)
+        node_grow(box, fp->lv + np->l0 + i, bsphere[np->l0 + i]);
+
+    if (np->ni < 0 && np->nj < 0)
+        return c;
+
+    e[0] = np->ni < 0 ? 0.0f : node_cost(fp, np->ni, bsphere, b[0]);
+    e[1] = np->nj < 0 ? 0.0f : node_cost(fp, np->nj, bsphere, b[1]);
+
+    for (i = 0; i < 3; i++)
+    {
+        box[i]     = MIN(box[i],     MIN(b[0][i],     b[1][i]));
+        box[i + 3] = MAX(box[i + 3], MAX(b[0][i + 3], b[1][i + 3]));
+    }
+
+    c += NODE_TRAV;
+
+    if ((a = node_area(box)) > 0.0f)
+    {
+        if (np->ni >= 0) c += e[0] * node_area(b[0]) / a;
+        if (np->nj >= 0) c += e[1] * node_area(b[1]) / a;
+    }
+    else c += e[0] + e[1];
+
+    return c;
+}
+
+static float node_file(struct s_base *fp)
 {
     float bsphere[MAXL][4];
+    float box[6];
+    float c = 0.0f;
     int i;
 
     /* Compute a bounding sphere for each lump. */
@@ -2678,15 +3682,454 @@ static void node_file(struct s_base *fp)
 
     /* Sort the lumps of each body into BSP nodes. */
 
+    node_mark  = (int *) calloc(fp->sc + 1, sizeof (int));
+    node_stamp = 0;
+
     for (i = 0; i < fp->bc; i++)
         fp->bv[i].ni = node_node(fp, fp->bv[i].l0, fp->bv[i].lc, bsphere);
+
+    free(node_mark);
+    node_mark = NULL;
+
+    /* Sum the expected query cost of each body. */
+
+    for (i = 0; i < fp->bc; i++)
+        c += node_cost(fp, fp->bv[i].ni, bsphere, box);
+
+    return c;
 }
 
 /*---------------------------------------------------------------------------*/
 
-struct dump_stats
-{
-    size_t off;
+/*
+ * Draw batches.  The renderer draws each body one material at a time,
+ * from a vertex array holding the offs its geoms use.  Those batches
+ * are built here, in the order the renderer would build them, and the
+ * triangles of each are reordered for the post-transform vertex cache
+ * after Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".  Blended
+ * materials keep their triangle order, as it may show.
+ */
+
+#define MESH_CACHE 32                          /* modelled cache size        */
+
+static float mesh_score(int c, int n)
+{
+    float s = 0.0f;
+
+    if (n == 0)
+        return -1.0f;
+
+    /* The last triangle's vertices score the same, in whatever order. */
+
+    if (c >= 0)
+    {
+        if (c < 3)
+            s = 0.75f;
+        else
+            s = powf(1.0f - (float) (c - 3) / (MESH_CACHE - 3), 1.5f);
+    }
+
+    /* Vertices with few triangles left are worth finishing. */
+
+    return s + 2.0f / sqrtf((float) n);
+}
+
+/*
+ * Reorder the GC triangles of TV, triples of indices below OC, so that
+ * each reuses as many of the recently used vertices as possible.
+ */
+static void mesh_sort(int *tv, int gc, int oc)
+{
+    int   *nv = (int   *) calloc(oc + 1, sizeof (int));
+    int   *av = (int   *) malloc(gc * 3 * sizeof (int));
+    int   *cv = (int   *) malloc(oc * sizeof (int));
+    float *sv = (float *) malloc(oc * sizeof (float));
+    float *wv = (float *) malloc(gc * sizeof (float));
+    int   *dv = (int   *) calloc(gc, sizeof (int));
+    int   *rv = (int   *) malloc(gc * 3 * sizeof (int));
+
+    int cache[MESH_CACHE + 3];
+    int cn = 0;
+
+    if (nv && av && cv && sv && wv && dv && rv)
+    {
+        int gi, gj, oi, i, j, k, n = 0, best = -1;
+
+        /* List the triangles of each vertex, from NV[oi] to NV[oi + 1]. */
+
+        for (i = 0; i < gc * 3; i++)
+            nv[tv[i] + 1]++;
+        for (oi = 0; oi < oc; oi++)
+            nv[oi + 1] += nv[oi];
+        for (oi = 0; oi < oc; oi++)
+            cv[oi] = nv[oi];
+        for (i = 0; i < gc * 3; i++)
+            av[cv[tv[i]]++] = i / 3;
+
+        /* CV now counts down the triangles left, listed first in AV. */
+
+        for (oi = 0; oi < oc; oi++)
+        {
+            cv[oi] = nv[oi + 1] - nv[oi];
+            sv[oi] = mesh_score(-1, cv[oi]);
+        }
+        for (gi = 0; gi < gc; gi++)
+        {
+            wv[gi] = sv[tv[gi * 3]] + sv[tv[gi * 3 + 1]] + sv[tv[gi * 3 + 2]];
+
+            if (best < 0 || wv[gi] > wv[best])
+                best = gi;
+        }
+
+        for (i = 0; i < gc; i++)
+        {
+            int next[MESH_CACHE + 3];
+            int nn = 0;
+
+            /* Without a candidate, take the next triangle left. */
+
+            if (best < 0)
+            {
+                while (dv[n])
+                    n++;
+                best = n;
+            }
+
+            dv[best] = 1;
+
+            rv[i * 3 + 0] = tv[best * 3 + 0];
+            rv[i * 3 + 1] = tv[best * 3 + 1];
+            rv[i * 3 + 2] = tv[best * 3 + 2];
+
+            /* Unlist it from its vertices and move them to the front. */
+
+            for (j = 0; j < 3; j++)
+            {
+                int *lv = av + nv[oi = tv[best * 3 + j]];
+
+                for (k = 0; k < cv[oi]; k++)
+                    if (lv[k] == best)
+                    {
+                        lv[k] = lv[--cv[oi]];
+                        lv[cv[oi]] = best;
+                        break;
+                    }
+
+                for (k = 0; k < nn && next[k] != oi; k++);
+
+                if (k == nn)
+                    next[nn++] = oi;
+            }
+
+            for (j = 0; j < cn; j++)
+            {
+                for (k = 0; k < nn && next[k] != cache[j]; k++);
+
+                if (k == nn)
+                    next[nn++] = cache[j];
+            }
+
+            /* Rescore the vertices, including those pushed out. */
+
+            for (j = 0; j < nn; j++)
+                sv[next[j]] = mesh_score(j < MESH_CACHE ? j : -1,
+                                         cv[next[j]]);
+
+            /* Rescore their triangles and pick the best in the cache. */
+
+            best = -1;
+
+            for (j = 0; j < nn; j++)
+            {
+                const int *lv = av + nv[oi = next[j]];
+
+                for (k = 0; k < cv[oi]; k++)
+                {
+                    gj = lv[k];
+
+                    wv[gj] = (sv[tv[gj * 3 + 0]] +
+                              sv[tv[gj * 3 + 1]] +
+                              sv[tv[gj * 3 + 2]]);
+
+                    if (best < 0 || wv[gj] > wv[best])
+                        best = gj;
+                }
+            }
+
+            cn = MIN(nn, MESH_CACHE);
+
+            for (j = 0; j < cn; j++)
+                cache[j] = next[j];
+        }
+
+        memcpy(tv, rv, gc * 3 * sizeof (int));
+    }
+
+    free(rv);
+    free(dv);
+    free(wv);
+    free(sv);
+    free(cv);
+    free(av);
+    free(nv);
+}
+
+/*
+ * Renumber the vertices of the GC triangles of TV in order of first
+ * use, and reorder the OC offs indices of OV to match.
+ */
+static void mesh_renumber(int *tv, int gc, int *ov, int oc)
+{
+    int *iv = (int *) malloc(oc * sizeof (int));
+    int *uv = (int *) malloc(oc * sizeof (int));
+
+    if (iv && uv)
+    {
+        int i, n = 0;
+
+        for (i = 0; i < oc; i++)
+            iv[i] = -1;
+
+        for (i = 0; i < gc * 3; i++)
+        {
+            if (iv[tv[i]] < 0)
+            {
+                uv[n] = ov[tv[i]];
+                iv[tv[i]] = n++;
+            }
+            tv[i] = iv[tv[i]];
+        }
+
+        memcpy(ov, uv, n * sizeof (int));
+    }
+
+    free(uv);
+    free(iv);
+}
+
+static void mesh_geom(struct s_base *fp, int *tv, int *gn,
+                      int *ov, int *on, int *iv, int g0, int gc, int mi)
+{
+    int gi;
+
+    /* Append the geoms with material mi, numbering offs as they come. */
+
+    for (gi = 0; gi < gc; gi++)
+    {
+        const struct b_geom *gp = fp->gv + fp->iv[g0 + gi];
+
+        if (gp->mi == mi)
+        {
+            const int oj[3] = { gp->oi, gp->oj, gp->ok };
+            int i;
+
+            for (i = 0; i < 3; i++)
+            {
+                if (iv[oj[i]] < 0)
+                {
+                    ov[*on]   = oj[i];
+                    iv[oj[i]] = (*on)++;
+                }
+                tv[(*gn) * 3 + i] = iv[oj[i]];
+            }
+            (*gn)++;
+        }
+    }
+}
+
+/*
+ * Vertex streams.  With --verts, the vertices of each batch are also
+ * written out as the renderer would assemble them, in floats or packed
+ * into shorts in the fixed point formats GX takes as they are.  Packed
+ * positions use the same fraction bits across a body, so that the
+ * vertices its batches share still meet.
+ */
+
+static int mesh_frac(float m)
+{
+    int f = 14;
+
+    /* Use the most fraction bits that keep magnitude M in range. */
+
+    while (f > 0 && m * (1 << f) > 32767.0f)
+        f--;
+
+    return f;
+}
+
+static short mesh_fix(float x, int f)
+{
+    const float y = floorf(x * (1 << f) + 0.5f);
+
+    return (short) CLAMP(-32768.0f, y, 32767.0f);
+}
+
+static float mesh_size(const struct s_base *fp, int g0, int gc, float m)
+{
+    int gi, i;
+
+    for (gi = 0; gi < gc; gi++)
+    {
+        const struct b_geom *gp = fp->gv + fp->iv[g0 + gi];
+        const int oj[3] = { gp->oi, gp->oj, gp->ok };
+
+        for (i = 0; i < 3; i++)
+        {
+            const float *p = fp->vv[fp->ov[oj[i]].vi].p;
+
+            m = MAX(m, fabsf(p[0]));
+            m = MAX(m, fabsf(p[1]));
+            m = MAX(m, fabsf(p[2]));
+        }
+    }
+    return m;
+}
+
+static void mesh_vert(struct s_base *fp, struct b_mesh *kp,
+                      const int *ov, int f)
+{
+    int i;
+
+    kp->c0 = fp->cc;
+    kp->q0 = fp->qc;
+    kp->qp = f;
+    kp->qt = 0;
+
+    if (vert_output & VERT_FLOAT)
+        for (i = 0; i < kp->oc; i++)
+        {
+            const struct b_offs *op = fp->ov + ov[i];
+            struct b_cvrt *cp = fp->cv + incc(fp);
+
+            v_cpy(cp->p, fp->vv[op->vi].p);
+            v_cpy(cp->n, fp->sv[op->si].n);
+
+            cp->t[0] = fp->tv[op->ti].u[0];
+            cp->t[1] = fp->tv[op->ti].u[1];
+        }
+
+    if (vert_output & VERT_SHORT)
+    {
+        float m = 0.0f;
+        int j;
+
+        for (i = 0; i < kp->oc; i++)
+        {
+            m = MAX(m, fabsf(fp->tv[fp->ov[ov[i]].ti].u[0]));
+            m = MAX(m, fabsf(fp->tv[fp->ov[ov[i]].ti].u[1]));
+        }
+
+        kp->qt = mesh_frac(m);
+
+        for (i = 0; i < kp->oc; i++)
+        {
+            const struct b_offs *op = fp->ov + ov[i];
+            struct b_qvrt *qp = fp->qv + incq(fp);
+
+            for (j = 0; j < 3; j++)
+            {
+                qp->p[j] = mesh_fix(fp->vv[op->vi].p[j], kp->qp);
+                qp->n[j] = mesh_fix(fp->sv[op->si].n[j], 14);
+            }
+            qp->t[0] = mesh_fix(fp->tv[op->ti].u[0], kp->qt);
+            qp->t[1] = mesh_fix(fp->tv[op->ti].u[1], kp->qt);
+        }
+    }
+}
+
+static void mesh_body(struct s_base *fp, int bi, int *ov, int *iv)
+{
+    const struct b_body *bp = fp->bv + bi;
+    int *tv;
+    int mi, li, i, c = bp->gc, f;
+    float m = 0.0f;
+
+    /* Lumps may share geoms, so count them as the lumps list them. */
+
+    for (li = 0; li < bp->lc; li++)
+    {
+        c += fp->lv[bp->l0 + li].gc;
+        m  = mesh_size(fp, fp->lv[bp->l0 + li].g0,
+                           fp->lv[bp->l0 + li].gc, m);
+    }
+
+    f = mesh_frac(mesh_size(fp, bp->g0, bp->gc, m));
+
+    if (!(tv = (int *) malloc(c * 3 * sizeof (int))))
+        return;
+
+    for (mi = 0; mi < fp->mc; mi++)
+    {
+        int gn = 0;
+        int on = 0;
+
+        for (li = 0; li < bp->lc; li++)
+            mesh_geom(fp, tv, &gn, ov, &on, iv,
+                      fp->lv[bp->l0 + li].g0,
+                      fp->lv[bp->l0 + li].gc, mi);
+
+        mesh_geom(fp, tv, &gn, ov, &on, iv, bp->g0, bp->gc, mi);
+
+        for (i = 0; i < on; i++)
+            iv[ov[i]] = -1;
+
+        if (gn)
+        {
+            struct b_mesh *kp = fp->kv + inck(fp);
+
+            if (!(fp->mv[mi].fl & (M_TRANSPARENT | M_PARTICLE)))
+            {
+                mesh_sort(tv, gn, on);
+                mesh_renumber(tv, gn, ov, on);
+            }
+
+            kp->bi = bi;
+            kp->mi = mi;
+            kp->oc = on;
+            kp->gc = gn;
+            kp->o0 = fp->yc;
+
+            for (i = 0; i < on; i++)
+                fp->yv[incy(fp)] = ov[i];
+
+            kp->g0 = fp->yc;
+
+            for (i = 0; i < gn * 3; i++)
+                fp->yv[incy(fp)] = tv[i];
+
+            mesh_vert(fp, kp, ov, f);
+        }
+    }
+
+    free(tv);
+}
+
+static void mesh_file(struct s_base *fp)
+{
+    int *ov = (int *) malloc(fp->oc * sizeof (int));
+    int *iv = (int *) malloc(fp->oc * sizeof (int));
+    int i;
+
+    /* Without the batches, the renderer builds its own. */
+
+    if (ov && iv)
+    {
+        for (i = 0; i < fp->oc; i++)
+            iv[i] = -1;
+
+        for (i = 0; i < fp->bc; i++)
+            mesh_body(fp, i, ov, iv);
+    }
+
+    free(iv);
+    free(ov);
+}
+
+/*---------------------------------------------------------------------------*/
+
+struct dump_stats
+{
+    size_t off;
     char name[5];
     char desc[32];
     int *ptr;
@@ -2716,7 +4159,11 @@ static struct dump_stats stats[] = {
     { offsetof (struct s_base, uc), "ball", "balls" },
     { offsetof (struct s_base, ac), "char", "chars" },
     { offsetof (struct s_base, dc), "dict", "dicts" },
-    { offsetof (struct s_base, ic), "indx", "indices" }
+    { offsetof (struct s_base, ic), "indx", "indices" },
+    { offsetof (struct s_base, kc), "mesh", "meshes" },
+    { offsetof (struct s_base, yc), "mndx", "mesh indices" },
+    { offsetof (struct s_base, cc), "cvrt", "draw vertices" },
+    { offsetof (struct s_base, qc), "qvrt", "packed vertices" }
 };
 
 static void dump_init(struct s_base *fp)
@@ -2727,25 +4174,35 @@ static void dump_init(struct s_base *fp)
         stats[i].ptr = (int *) &((unsigned char *) fp)[stats[i].off];
 }
 
-static void dump_file(struct s_base *p, const char *name, double t)
+static void dump_count(struct s_base *p, int *n, int *c)
 {
-    int i, j;
-    int c = 0;
-    int n = 0;
+    int i;
 
-    dump_init(p);
+    *n = 0;
+    *c = 0;
 
     /* Count the number of solid lumps. */
 
     for (i = 0; i < p->lc; i++)
         if ((p->lv[i].fl & 1) == 0)
-            n++;
+            (*n)++;
 
     /* Count the total value of all coins. */
 
     for (i = 0; i < p->hc; i++)
         if (p->hv[i].t == ITEM_COIN)
-            c += p->hv[i].n;
+            *c += p->hv[i].n;
+}
+
+static void dump_file(struct s_base *p, const char *name,
+                      double t, double u, float e)
+{
+    int i, j;
+    int c = 0;
+    int n = 0;
+
+    dump_init(p);
+    dump_count(p, &n, &c);
 
 #if ENABLE_RADIANT_CONSOLE
     if (bcast_socket)
@@ -2753,7 +4210,8 @@ static void dump_file(struct s_base *p, const char *name, double t)
         char msg[512];
         char buf[64];
 
-        sprintf(msg, "%s (%d/$%d) %.3f\n", name, n, c, t);
+        sprintf(msg, "%s (%d/$%d) %.3f (uniq %.3f) (bsp %.1f)\n",
+                name, n, c, t, u, e);
 
         for (i = 0; i < ARRAYSIZE(stats); i++)
         {
@@ -2767,12 +4225,12 @@ static void dump_file(struct s_base *p, const char *name, double t)
 
     if (csv_output)
     {
-        printf("name,n,c,t,");
+        printf("name,n,c,t,u,bsp,");
 
         for (i = 0; i < ARRAYSIZE(stats); i++)
             printf("%s%s", stats[i].name, (i + 1 < ARRAYSIZE(stats) ?
                                            "," : "\n"));
-        printf("%s,%d,%d,%.3f,", name, n, c, t);
+        printf("%s,%d,%d,%.3f,%.3f,%.1f,", name, n, c, t, u, e);
 
         for (i = 0; i < ARRAYSIZE(stats); i++)
             printf("%d%s", *stats[i].ptr, (i + 1 < ARRAYSIZE(stats) ?
@@ -2782,7 +4240,8 @@ static void dump_file(struct s_base *p, const char *name, double t)
     {
         const int COLS = 11;
 
-        printf("%s (%d/$%d) %.3f\n", name, n, c, t);
+        printf("%s (%d/$%d) %.3f (uniq %.3f) (bsp %.1f)\n",
+               name, n, c, t, u, e);
 
         for (i = 0, j = 0; i < ARRAYSIZE(stats); i++)
         {
@@ -2801,6 +4260,497 @@ static void dump_file(struct s_base *p, const char *name, double t)
     }
 }
 
+/*---------------------------------------------------------------------------*/
+
+static double time_diff(const struct timeval *t0, const struct timeval *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) + (t1->tv_usec - t0->tv_usec) / 1000000.0;
+}
+
+/*
+ * Return true if DST is up to date with its manifest.  Touch it if so,
+ * so that make, which sees only that the map or mapc is newer, does not
+ * run mapc for it again.
+ */
+static int compile_fresh(const char *dst)
+{
+    char name[MAXSTR];
+
+    SAFECPY(name, dst);
+    SAFECAT(name, ".dep");
+
+    if (incremental_build && fs_exists(dst) && deps_load(name))
+    {
+        fs_touch(dst);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Compile map SRC, open as FIN, returning the total time in T, the time
+ * spent in uniq_file in U and the expected cost of the BSPs in E.  The
+ * symbol table and targets start over, but the image size cache carries
+ * over from any previous map.
+ */
+static void compile_file(struct s_base *fp, fs_file fin,
+                         const char *src, const char *dst,
+                         double *t, double *u, float *e)
+{
+    struct timeval time0;
+    struct timeval time1;
+    struct timeval uniq0;
+    struct timeval uniq1;
+
+    /* Unresolved target references must find zeroes, as in a new process. */
+
+    memset(targ_p,  0, sizeof (targ_p));
+    memset(targ_wi, 0, sizeof (targ_wi));
+    memset(targ_ji, 0, sizeof (targ_ji));
+
+    symc   = 0;
+    refc   = 0;
+    targ_n = 0;
+
+    read_dict_entries = 0;
+
+    deps_n = 0;
+    deps_file(DEP_MAP, src);
+
+    gettimeofday(&time0, 0);
+    {
+        init_file(fp);
+        read_map(fp, fin);
+
+        resolve();
+        targets(fp);
+
+        clip_file(fp);
+        move_file(fp);
+
+        gettimeofday(&uniq0, 0);
+        uniq_file(fp);
+        gettimeofday(&uniq1, 0);
+
+        smth_file(fp);
+        sort_file(fp);
+        *e = node_file(fp);
+        mesh_file(fp);
+
+        if (sol_stor_base(fp, dst, output_order | pack_output) &&
+            incremental_build)
+        {
+            char name[MAXSTR];
+
+            SAFECPY(name, dst);
+            SAFECAT(name, ".dep");
+
+            deps_stor(name);
+        }
+    }
+    gettimeofday(&time1, 0);
+
+    *t = time_diff(&time0, &time1);
+    *u = time_diff(&uniq0, &uniq1);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Batch mode compiles every map under the data directory in a single
+ * process, so the file system is set up once and each texture is sized
+ * once.  Mapc keeps the map being compiled in globals, so parallel jobs
+ * are worker processes rather than threads.  They claim maps from a
+ * shared counter and file their results in shared memory; each keeps
+ * its own image size cache, and merges it into the --image-cache file
+ * when done.
+ */
+
+struct batch_map
+{
+    char   src[MAXSTR];                        /* map, relative to data      */
+    int    ok;                                 /* compiled or up to date?    */
+    int    skip;                               /* up to date?                */
+    double t;                                  /* total time                 */
+    double u;                                  /* time in uniq_file          */
+    float  e;                                  /* expected BSP query cost    */
+    int    n;                                  /* solid lumps                */
+    int    c;                                  /* coin value                 */
+    int    v[ARRAYSIZE(stats)];                /* element counts             */
+};
+
+struct batch
+{
+    int next;                                  /* next unclaimed map         */
+    int count;
+    struct batch_map mv[1];
+};
+
+static int batch_filter(struct dir_item *item)
+{
+    const char *name = base_name(item->path);
+
+    if (dir_exists(item->path))
+        return name[0] != '.';
+
+    return (str_ends_with(name, ".map") &&
+            !str_ends_with(name, ".autosave.map"));
+}
+
+static int batch_comp(const void *p, const void *q)
+{
+    return strcmp(*(char * const *) p, *(char * const *) q);
+}
+
+/* Collect the maps under DATA/PATH into LIST, a growing array of names. */
+
+static void batch_scan(const char *data, const char *path,
+                       char ***list, int *count, int *alloc)
+{
+    char *full = path_join(data, path);
+    Array items;
+    int i;
+
+    if ((items = dir_scan(full, batch_filter, NULL, NULL)))
+    {
+        for (i = 0; i < array_len(items); i++)
+        {
+            const char *name = base_name(DIR_ITEM_GET(items, i)->path);
+            char *rel = path_join(path, name);
+
+            if (dir_exists(DIR_ITEM_GET(items, i)->path))
+            {
+                batch_scan(data, rel, list, count, alloc);
+                free(rel);
+            }
+            else
+            {
+                if (*count == *alloc)
+                {
+                    *alloc = *alloc ? *alloc * 2 : 256;
+                    *list  = realloc(*list, *alloc * sizeof (char *));
+                }
+                (*list)[(*count)++] = rel;
+            }
+        }
+        dir_free(items);
+    }
+    free(full);
+}
+
+static void batch_compile(struct batch_map *mp)
+{
+    char dst[MAXSTR];
+    struct s_base f;
+    fs_file fin;
+    int i;
+
+    /* A name cut short when the batch was built no longer ends in .map. */
+
+    if (!str_ends_with(mp->src, ".map") ||
+        snprintf(dst, sizeof (dst), "%.*s.sol",
+                 (int) strlen(mp->src) - 4, mp->src) >= (int) sizeof (dst))
+    {
+        fprintf(stderr, "%s: Name too long\n", mp->src);
+        return;
+    }
+
+    input_file = mp->src;
+
+    if (compile_fresh(dst))
+    {
+        mp->ok   = 1;
+        mp->skip = 1;
+    }
+    else if ((fin = fs_open(mp->src, "r")))
+    {
+        memset(&f, 0, sizeof (f));
+
+        compile_file(&f, fin, mp->src, dst, &mp->t, &mp->u, &mp->e);
+        fs_close(fin);
+
+        dump_init(&f);
+        dump_count(&f, &mp->n, &mp->c);
+
+        for (i = 0; i < ARRAYSIZE(stats); i++)
+            mp->v[i] = *stats[i].ptr;
+
+        sol_free_base(&f);
+
+        mp->ok = 1;
+    }
+    else fprintf(stderr, "%s: %s\n", mp->src, fs_error());
+}
+
+static void batch_work(struct batch *bp)
+{
+    int i;
+
+#if ENABLE_BATCH_JOBS
+    while ((i = __sync_fetch_and_add(&bp->next, 1)) < bp->count)
+        batch_compile(bp->mv + i);
+#else
+    while ((i = bp->next++) < bp->count)
+        batch_compile(bp->mv + i);
+#endif
+
+    cache_stor();
+}
+
+static void batch_print(const struct batch *bp)
+{
+    int i, j;
+
+    printf("name,n,c,t,u,bsp,");
+
+    for (i = 0; i < ARRAYSIZE(stats); i++)
+        printf("%s%s", stats[i].name, (i + 1 < ARRAYSIZE(stats) ?
+                                       "," : "\n"));
+
+    for (i = 0; i < bp->count; i++)
+    {
+        const struct batch_map *mp = bp->mv + i;
+
+        if (!mp->ok || mp->skip)
+            continue;
+
+        printf("%s,%d,%d,%.3f,%.3f,%.1f,",
+               mp->src, mp->n, mp->c, mp->t, mp->u, mp->e);
+
+        for (j = 0; j < ARRAYSIZE(stats); j++)
+            printf("%d%s", mp->v[j], (j + 1 < ARRAYSIZE(stats) ?
+                                      "," : "\n"));
+    }
+}
+
+static int batch_file(const char *data, int jobs)
+{
+    struct batch *bp;
+    char **list = NULL;
+    size_t size;
+    int count = 0;
+    int alloc = 0;
+    int rc = 0;
+    int i;
+
+    if (!fs_add_path_with_archives(data) || !fs_set_write_dir(data))
+    {
+        fprintf(stderr, "Failure to establish data directory\n");
+        return 1;
+    }
+
+    batch_scan(data, "", &list, &count, &alloc);
+
+    if (count)
+        qsort(list, count, sizeof (char *), batch_comp);
+
+    size = sizeof (struct batch) + MAX(count - 1, 0) * sizeof (struct batch_map);
+
+#if ENABLE_BATCH_JOBS
+    if ((bp = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+        bp = NULL;
+    else
+        memset(bp, 0, size);
+#else
+    bp = calloc(1, size);
+#endif
+
+    if (bp == NULL)
+    {
+        fprintf(stderr, "Failure to allocate batch of %d maps\n", count);
+        return 1;
+    }
+
+    bp->count = count;
+
+    for (i = 0; i < count; i++)
+    {
+        SAFECPY(bp->mv[i].src, list[i]);
+        free(list[i]);
+    }
+    free(list);
+
+    /* This process is one of the jobs. */
+
+#if ENABLE_BATCH_JOBS
+    fflush(stdout);
+    fflush(stderr);
+
+    for (i = 1; i < jobs; i++)
+    {
+        pid_t pid = fork();
+
+        if (pid == 0)
+        {
+            batch_work(bp);
+            _exit(0);
+        }
+        if (pid < 0)
+            break;
+    }
+
+    batch_work(bp);
+
+    while (wait(NULL) > 0)
+        ;
+#else
+    batch_work(bp);
+#endif
+
+    batch_print(bp);
+
+    for (i = 0; i < count; i++)
+        if (!bp->mv[i].ok)
+            rc = 1;
+
+#if ENABLE_BATCH_JOBS
+    munmap(bp, size);
+#else
+    free(bp);
+#endif
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Set indices.  For each set file, an index holds the dictionary of
+ * every level it lists, so that the game can browse a set with a single
+ * read instead of opening each SOL.  The format is shared with ball/set.c:
+ * a header line, then for each level its file name, its keys and values
+ * as NUL-terminated strings, and an empty string.
+ */
+
+#define INDEX_VERSION 1
+
+static int index_filter(struct dir_item *item)
+{
+    const char *name = base_name(item->path);
+
+    return str_starts_with(name, "set-") && str_ends_with(name, ".txt");
+}
+
+static void index_put(char **buf, size_t *len, size_t *max, const char *s)
+{
+    const size_t n = strlen(s) + 1;
+
+    if (*len + n > *max)
+    {
+        *max = MAX(*max * 2, *len + n);
+        *buf = (char *) realloc(*buf, *max);
+    }
+
+    memcpy(*buf + *len, s, n);
+    *len += n;
+}
+
+static int index_set(const char *name)
+{
+    char dst[MAXSTR];
+    char *line;
+    fs_file fin;
+    fs_file fout;
+    int count = 0;
+    int i;
+
+    char  *buf = NULL;
+    size_t len = 0;
+    size_t max = 0;
+
+    SAFECPY(dst, name);
+    strcpy(dst + strlen(dst) - 4, ".idx");
+
+    if (!(fin = fs_open(name, "r")))
+        return 0;
+
+    /* Skip name, description, id, shot and scores. */
+
+    for (i = 0; i < 5 && read_line(&line, fin); i++)
+        free(line);
+
+    while (i == 5 && read_line(&line, fin))
+    {
+        struct s_base base;
+
+        if (sol_load_meta(&base, line))
+        {
+            int j;
+
+            index_put(&buf, &len, &max, line);
+
+            for (j = 0; j < base.dc; j++)
+            {
+                index_put(&buf, &len, &max, base.av + base.dv[j].ai);
+                index_put(&buf, &len, &max, base.av + base.dv[j].aj);
+            }
+
+            index_put(&buf, &len, &max, "");
+            count++;
+
+            sol_free_base(&base);
+            free(line);
+        }
+        else
+        {
+            fprintf(stderr, "%s: failure to load %s\n", name, line);
+            free(line);
+            fs_close(fin);
+            free(buf);
+
+            /* Leave no stale index behind. */
+
+            fs_remove(dst);
+            return 0;
+        }
+    }
+
+    fs_close(fin);
+
+    if ((fout = fs_open(dst, "w")))
+    {
+        fs_printf(fout, "index %d %d\n", INDEX_VERSION, count);
+
+        if (len)
+            fs_write(buf, 1, (int) len, fout);
+
+        fs_close(fout);
+
+        if (!csv_output)
+            printf("%s (%d levels)\n", dst, count);
+    }
+
+    free(buf);
+
+    return fout != NULL;
+}
+
+static int index_file(const char *data)
+{
+    Array items;
+    int rc = 0;
+    int i;
+
+    if (!fs_add_path_with_archives(data) || !fs_set_write_dir(data))
+    {
+        fprintf(stderr, "Failure to establish data directory\n");
+        return 1;
+    }
+
+    if ((items = dir_scan(data, index_filter, NULL, NULL)))
+    {
+        for (i = 0; i < array_len(items); i++)
+            if (!index_set(base_name(DIR_ITEM_GET(items, i)->path)))
+                rc = 1;
+
+        dir_free(items);
+    }
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     char src[MAXSTR] = "";
@@ -2808,8 +4758,10 @@ int main(int argc, char *argv[])
     struct s_base f;
     fs_file fin;
 
-    struct timeval time0;
-    struct timeval time1;
+    int batch = 0;
+    int sets  = 0;
+    int jobs  = 1;
+    int rc    = 0;
 
     if (!fs_init(argv[0]))
     {
@@ -2824,10 +4776,25 @@ int main(int argc, char *argv[])
 
         input_file = argv[1];
 
+        if (strcmp(argv[1], "--batch") == 0)
+            batch = 1;
+        if (strcmp(argv[1], "--index") == 0)
+            sets = 1;
+
         for (argi = 3; argi < argc; ++argi)
         {
             if (strcmp(argv[argi], "--debug") == 0) debug_output = 1;
             if (strcmp(argv[argi], "--csv")   == 0)   csv_output = 1;
+
+            if (strcmp(argv[argi], "--incremental") == 0)
+                incremental_build = 1;
+
+            if (strcmp(argv[argi], "--big-endian")    == 0)
+                output_order = SOL_ORDER_BIG;
+            if (strcmp(argv[argi], "--little-endian") == 0)
+                output_order = SOL_ORDER_LITTLE;
+            if (strcmp(argv[argi], "--pack")          == 0)
+                pack_output = SOL_PACK;
 #if ENABLE_RADIANT_CONSOLE
             if (strcmp(argv[argi], "--bcast") == 0) bcast_init();
 #endif
@@ -2836,6 +4803,54 @@ int main(int argc, char *argv[])
                 if (++argi < argc)
                     fs_add_path(argv[argi]);
             }
+            if (strcmp(argv[argi], "--image-cache") == 0)
+            {
+                if (++argi < argc)
+                    image_cache = argv[argi];
+            }
+            if (strcmp(argv[argi], "--jobs")  == 0)
+            {
+                if (++argi < argc)
+                    jobs = MAX(atoi(argv[argi]), 1);
+            }
+            if (strcmp(argv[argi], "--bsp")   == 0)
+            {
+                if (++argi < argc)
+                    node_builder = (strcmp(argv[argi], "even") == 0 ?
+                                    NODE_EVEN : NODE_SAH);
+            }
+            if (strcmp(argv[argi], "--leaf")  == 0)
+            {
+                if (++argi < argc)
+                    node_leaf = MAX(atoi(argv[argi]), 2);
+            }
+            if (strcmp(argv[argi], "--verts") == 0)
+            {
+                if (++argi < argc)
+                {
+                    if (strcmp(argv[argi], "float") == 0)
+                        vert_output |= VERT_FLOAT;
+                    if (strcmp(argv[argi], "short") == 0)
+                        vert_output |= VERT_SHORT;
+                }
+            }
+        }
+
+        if (image_cache)
+            cache_load(0);
+
+        if (batch)
+        {
+            rc = batch_file(argv[2], jobs);
+            fs_quit();
+            return rc;
+        }
+
+        if (sets)
+        {
+            rc = index_file(argv[2]);
+            fs_quit();
+            return rc;
         }
 
         strncpy(src, argv[1], MAXSTR - 1);
@@ -2851,6 +4866,9 @@ int main(int argc, char *argv[])
 
         if ((fin = fs_open(base_name(src), "r")))
         {
+            double t, u;
+            float  e;
+
             if (!fs_add_path_with_archives(argv[2]))
             {
                 fprintf(stderr, "Failure to establish data directory\n");
@@ -2859,31 +4877,25 @@ int main(int argc, char *argv[])
                 return 1;
             }
 
-            gettimeofday(&time0, 0);
+            if (compile_fresh(base_name(dst)))
             {
-                init_file(&f);
-                read_map(&f, fin);
-
-                resolve();
-                targets(&f);
-
-                clip_file(&f);
-                move_file(&f);
-                uniq_file(&f);
-                smth_file(&f);
-                sort_file(&f);
-                node_file(&f);
-
-                sol_stor_base(&f, base_name(dst));
+                if (!csv_output)
+                    printf("%s is up to date\n", dst);
             }
-            gettimeofday(&time1, 0);
+            else
+            {
+                compile_file(&f, fin, base_name(src), base_name(dst),
+                             &t, &u, &e);
 
-            dump_file(&f, dst, (time1.tv_sec  - time0.tv_sec) +
-                               (time1.tv_usec - time0.tv_usec) / 1000000.0);
+                dump_file(&f, dst, t, u, e);
+            }
 
             fs_close(fin);
 
+            cache_stor();
+
             free_imagedata();
+            free_imagecache();
         }
 
 #if ENABLE_RADIANT_CONSOLE
@@ -2891,7 +4903,16 @@ int main(int argc, char *argv[])
 #endif
 
     }
-    else fprintf(stderr, "Usage: %s <map> <data> [--debug] [--csv]\n", argv[0]);
+    else fprintf(stderr, "Usage: %s <map> <data> [--debug] [--csv] "
+                 "[--incremental] [--big-endian | --little-endian] "
+                 "[--bsp sah | even] [--leaf N] [--verts float | short] "
+                 "[--pack] [--image-cache <file>]\n"
+                 "       %s --batch <data> [--jobs N] [--debug] "
+                 "[--incremental] [--big-endian | --little-endian] "
+                 "[--bsp sah | even] [--leaf N] [--verts float | short] "
+                 "[--pack] [--image-cache <file>]\n"
+                 "       %s --index <data>\n",
+                 argv[0], argv[0], argv[0]);
 
     return 0;
 }
@@ -14,7 +14,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
+#include <limits.h>
+#include <zlib.h>
 
 #include "solid_base.h"
 #include "base_config.h"
@@ -26,11 +29,13 @@
 enum
 {
     SOL_VERSION_1_5 = 6,
-    SOL_VERSION_DEV
+    SOL_VERSION_DEV,
+    SOL_VERSION_IMAGE,
+    SOL_VERSION_PACK
 };
 
 #define SOL_VERSION_MIN  SOL_VERSION_1_5
-#define SOL_VERSION_CURR SOL_VERSION_DEV
+#define SOL_VERSION_CURR SOL_VERSION_IMAGE
 
 #define SOL_MAGIC (0xAF | 'S' << 8 | 'O' << 16 | 'L' << 24)
 
@@ -47,7 +52,7 @@ static int sol_file(fs_file fin)
     version = get_index(fin);
 
     if (magic != SOL_MAGIC || (version < SOL_VERSION_MIN ||
-                               version > SOL_VERSION_CURR))
+                               version > SOL_VERSION_DEV))
         return 0;
 
     sol_version = version;
@@ -111,113 +116,56 @@ static void sol_load_mtrl(fs_file fin, struct b_mtrl *mp)
     }
 }
 
-static void sol_load_vert(fs_file fin, struct b_vert *vp)
-{
-    get_array(fin, vp->p, 3);
-}
-
-static void sol_load_edge(fs_file fin, struct b_edge *ep)
+/*
+ * 1.5 geoms store their three offsets inline.  Merge them into the
+ * offset vector.
+ */
+static void sol_load_geom(fs_file fin, struct b_geom *gp, struct s_base *fp)
 {
-    ep->vi = get_index(fin);
-    ep->vj = get_index(fin);
-}
+    struct b_offs ov[3];
+    int i, j, iv[3], oc;
+    void *p;
 
-static void sol_load_side(fs_file fin, struct b_side *sp)
-{
-    get_array(fin, sp->n, 3);
+    gp->mi = get_index(fin);
 
-    sp->d = get_float(fin);
-}
+    oc = 0;
 
-static void sol_load_texc(fs_file fin, struct b_texc *tp)
-{
-    get_array(fin, tp->u, 2);
-}
+    for (i = 0; i < 3; i++)
+    {
+        ov[i].ti = get_index(fin);
+        ov[i].si = get_index(fin);
+        ov[i].vi = get_index(fin);
 
-static void sol_load_offs(fs_file fin, struct b_offs *op)
-{
-    op->ti = get_index(fin);
-    op->si = get_index(fin);
-    op->vi = get_index(fin);
-}
+        iv[i] = -1;
 
-static void sol_load_geom(fs_file fin, struct b_geom *gp, struct s_base *fp)
-{
-    gp->mi = get_index(fin);
+        for (j = 0; j < fp->oc; j++)
+            if (ov[i].ti == fp->ov[j].ti &&
+                ov[i].si == fp->ov[j].si &&
+                ov[i].vi == fp->ov[j].vi)
+            {
+                iv[i] = j;
+                break;
+            }
 
-    if (sol_version >= SOL_VERSION_DEV)
-    {
-        gp->oi = get_index(fin);
-        gp->oj = get_index(fin);
-        gp->ok = get_index(fin);
+        if (j == fp->oc)
+            oc++;
     }
-    else
-    {
-        struct b_offs ov[3];
-        int i, j, iv[3], oc;
-        void *p;
 
-        oc = 0;
+    if (oc && (p = realloc(fp->ov, sizeof (struct b_offs) * (fp->oc + oc))))
+    {
+        fp->ov = p;
 
         for (i = 0; i < 3; i++)
-        {
-            ov[i].ti = get_index(fin);
-            ov[i].si = get_index(fin);
-            ov[i].vi = get_index(fin);
-
-            iv[i] = -1;
-
-            for (j = 0; j < fp->oc; j++)
-                if (ov[i].ti == fp->ov[j].ti &&
-                    ov[i].si == fp->ov[j].si &&
-                    ov[i].vi == fp->ov[j].vi)
-                {
-                    iv[i] = j;
-                    break;
-                }
-
-            if (j == fp->oc)
-                oc++;
-        }
-
-        if (oc && (p = realloc(fp->ov, sizeof (struct b_offs) * (fp->oc + oc))))
-        {
-            fp->ov = p;
-
-            for (i = 0; i < 3; i++)
-                if (iv[i] < 0)
-                {
-                    fp->ov[fp->oc] = ov[i];
-                    iv[i] = fp->oc++;
-                }
-        }
-
-        gp->oi = iv[0];
-        gp->oj = iv[1];
-        gp->ok = iv[2];
+            if (iv[i] < 0)
+            {
+                fp->ov[fp->oc] = ov[i];
+                iv[i] = fp->oc++;
+            }
     }
-}
 
-static void sol_load_lump(fs_file fin, struct b_lump *lp)
-{
-    lp->fl = get_index(fin);
-    lp->v0 = get_index(fin);
-    lp->vc = get_index(fin);
-    lp->e0 = get_index(fin);
-    lp->ec = get_index(fin);
-    lp->g0 = get_index(fin);
-    lp->gc = get_index(fin);
-    lp->s0 = get_index(fin);
-    lp->sc = get_index(fin);
-}
-
-static void sol_load_node(fs_file fin, struct b_node *np)
-{
-    np->si = get_index(fin);
-    np->ni = get_index(fin);
-    np->nj = get_index(fin);
-    np->l0 = get_index(fin);
-    np->lc = get_index(fin);
+    gp->oi = iv[0];
+    gp->oj = iv[1];
+    gp->ok = iv[2];
 }
 
 static void sol_load_path(fs_file fin, struct b_path *pp)
@@ -273,13 +221,6 @@ static void sol_load_item(fs_file fin, struct b_item *hp)
     hp->n = get_index(fin);
 }
 
-static void sol_load_goal(fs_file fin, struct b_goal *zp)
-{
-    get_array(fin, zp->p, 3);
-
-    zp->r = get_float(fin);
-}
-
 static void sol_load_swch(fs_file fin, struct b_swch *xp)
 {
     get_array(fin, xp->p, 3);
@@ -311,33 +252,6 @@ static void sol_load_bill(fs_file fin, struct b_bill *rp)
     get_array(fin, rp->p,  3);
 }
 
-static void sol_load_jump(fs_file fin, struct b_jump *jp)
-{
-    get_array(fin, jp->p, 3);
-    get_array(fin, jp->q, 3);
-
-    jp->r = get_float(fin);
-}
-
-static void sol_load_ball(fs_file fin, struct b_ball *up)
-{
-    get_array(fin, up->p, 3);
-
-    up->r = get_float(fin);
-}
-
-static void sol_load_view(fs_file fin, struct b_view *wp)
-{
-    get_array(fin, wp->p, 3);
-    get_array(fin, wp->q, 3);
-}
-
-static void sol_load_dict(fs_file fin, struct b_dict *dp)
-{
-    dp->ai = get_index(fin);
-    dp->aj = get_index(fin);
-}
-
 static void sol_load_indx(fs_file fin, struct s_base *fp)
 {
     fp->ac = get_index(fin);
@@ -366,6 +280,26 @@ static void sol_load_indx(fs_file fin, struct s_base *fp)
     fp->ic = get_index(fin);
 }
 
+/*
+ * Check that no count is negative or more than the LEN bytes of the
+ * file could hold, so that a corrupt one cannot ask for huge vectors.
+ */
+static int sol_load_size(const struct s_base *fp, int len)
+{
+    const int c[] = {
+        fp->ac, fp->dc, fp->mc, fp->vc, fp->ec, fp->sc, fp->tc,
+        fp->oc, fp->gc, fp->lc, fp->nc, fp->pc, fp->bc, fp->hc,
+        fp->zc, fp->jc, fp->xc, fp->rc, fp->uc, fp->wc, fp->ic
+    };
+    int i;
+
+    for (i = 0; i < ARRAYSIZE(c); i++)
+        if (c[i] < 0 || c[i] > len)
+            return 0;
+
+    return 1;
+}
+
 static int sol_load_file(fs_file fin, struct s_base *fp)
 {
     int i;
@@ -375,6 +309,9 @@ static int sol_load_file(fs_file fin, struct s_base *fp)
 
     sol_load_indx(fin, fp);
 
+    if (!sol_load_size(fp, fs_length(fin)))
+        return 0;
+
     if (fp->ac)
         fp->av = (char *)          calloc(fp->ac, sizeof (*fp->av));
     if (fp->mc)
@@ -418,29 +355,56 @@ static int sol_load_file(fs_file fin, struct s_base *fp)
     if (fp->ic)
         fp->iv = (int *)           calloc(fp->ic, sizeof (*fp->iv));
 
+    if ((fp->ac && !fp->av) || (fp->mc && !fp->mv) || (fp->vc && !fp->vv) ||
+        (fp->ec && !fp->ev) || (fp->sc && !fp->sv) || (fp->tc && !fp->tv) ||
+        (fp->oc && !fp->ov) || (fp->gc && !fp->gv) || (fp->lc && !fp->lv) ||
+        (fp->nc && !fp->nv) || (fp->pc && !fp->pv) || (fp->bc && !fp->bv) ||
+        (fp->hc && !fp->hv) || (fp->zc && !fp->zv) || (fp->jc && !fp->jv) ||
+        (fp->xc && !fp->xv) || (fp->rc && !fp->rv) || (fp->uc && !fp->uv) ||
+        (fp->wc && !fp->wv) || (fp->dc && !fp->dv) || (fp->ic && !fp->iv))
+        return 0;
+
     if (fp->ac)
         fs_read(fp->av, 1, fp->ac, fin);
 
-    for (i = 0; i < fp->dc; i++) sol_load_dict(fin, fp->dv + i);
+    /*
+     * Structures made of nothing but ints or nothing but floats are laid
+     * out on disk exactly as in memory, so read each of those vectors in
+     * a single run.
+     */
+
+    get_index_array(fin, (int *) fp->dv, fp->dc * 2);
+
     for (i = 0; i < fp->mc; i++) sol_load_mtrl(fin, fp->mv + i);
-    for (i = 0; i < fp->vc; i++) sol_load_vert(fin, fp->vv + i);
-    for (i = 0; i < fp->ec; i++) sol_load_edge(fin, fp->ev + i);
-    for (i = 0; i < fp->sc; i++) sol_load_side(fin, fp->sv + i);
-    for (i = 0; i < fp->tc; i++) sol_load_texc(fin, fp->tv + i);
-    for (i = 0; i < fp->oc; i++) sol_load_offs(fin, fp->ov + i);
-    for (i = 0; i < fp->gc; i++) sol_load_geom(fin, fp->gv + i, fp);
-    for (i = 0; i < fp->lc; i++) sol_load_lump(fin, fp->lv + i);
-    for (i = 0; i < fp->nc; i++) sol_load_node(fin, fp->nv + i);
+
+    get_array      (fin, (float *) fp->vv, fp->vc * 3);
+    get_index_array(fin, (int *)   fp->ev, fp->ec * 2);
+    get_array      (fin, (float *) fp->sv, fp->sc * 4);
+    get_array      (fin, (float *) fp->tv, fp->tc * 2);
+    get_index_array(fin, (int *)   fp->ov, fp->oc * 3);
+
+    if (sol_version >= SOL_VERSION_DEV)
+        get_index_array(fin, (int *) fp->gv, fp->gc * 4);
+    else
+        for (i = 0; i < fp->gc; i++) sol_load_geom(fin, fp->gv + i, fp);
+
+    get_index_array(fin, (int *) fp->lv, fp->lc * 9);
+    get_index_array(fin, (int *) fp->nv, fp->nc * 5);
+
     for (i = 0; i < fp->pc; i++) sol_load_path(fin, fp->pv + i);
     for (i = 0; i < fp->bc; i++) sol_load_body(fin, fp->bv + i);
     for (i = 0; i < fp->hc; i++) sol_load_item(fin, fp->hv + i);
-    for (i = 0; i < fp->zc; i++) sol_load_goal(fin, fp->zv + i);
-    for (i = 0; i < fp->jc; i++) sol_load_jump(fin, fp->jv + i);
+
+    get_array(fin, (float *) fp->zv, fp->zc * 4);
+    get_array(fin, (float *) fp->jv, fp->jc * 7);
+
     for (i = 0; i < fp->xc; i++) sol_load_swch(fin, fp->xv + i);
     for (i = 0; i < fp->rc; i++) sol_load_bill(fin, fp->rv + i);
-    for (i = 0; i < fp->uc; i++) sol_load_ball(fin, fp->uv + i);
-    for (i = 0; i < fp->wc; i++) sol_load_view(fin, fp->wv + i);
-    for (i = 0; i < fp->ic; i++) fp->iv[i] = get_index(fin);
+
+    get_array(fin, (float *) fp->uv, fp->uc * 4);
+    get_array(fin, (float *) fp->wv, fp->wc * 6);
+
+    get_index_array(fin, fp->iv, fp->ic);
 
     /* Magically "fix" all of our code. */
 
@@ -460,316 +424,1145 @@ static int sol_load_head(fs_file fin, struct s_base *fp)
 
     sol_load_indx(fin, fp);
 
+    if (!sol_load_size(fp, fs_length(fin)))
+        return 0;
+
     if (fp->ac)
     {
-        fp->av = (char *) calloc(fp->ac, sizeof (*fp->av));
+        if (!(fp->av = (char *) calloc(fp->ac, sizeof (*fp->av))))
+            return 0;
+
         fs_read(fp->av, 1, fp->ac, fin);
     }
 
     if (fp->dc)
     {
-        int i;
-
-        fp->dv = (struct b_dict *) calloc(fp->dc, sizeof (*fp->dv));
+        if (!(fp->dv = (struct b_dict *) calloc(fp->dc, sizeof (*fp->dv))))
+            return 0;
 
-        for (i = 0; i < fp->dc; i++)
-            sol_load_dict(fin, fp->dv + i);
+        get_index_array(fin, (int *) fp->dv, fp->dc * 2);
     }
 
     return 1;
 }
 
-int sol_load_base(struct s_base *fp, const char *filename)
-{
-    fs_file fin;
-    int res = 0;
+/*---------------------------------------------------------------------------*/
 
-    memset(fp, 0, sizeof (*fp));
+/*
+ * SOL image format.
+ *
+ * An image is the in-memory form of struct s_base written to disk as
+ * is, so that loading it takes one read and no per-element parsing.
+ * It starts with a header of three words (magic, version and section
+ * count) padded to 16 bytes, followed by a table of sections of four
+ * words each (id, count, element size and offset).  Section data is
+ * aligned to 16 bytes.  Every word in the file, header included, is
+ * in the byte order of the machine it was written for; a reader that
+ * finds the magic number byte-swapped swaps the whole image in place.
+ *
+ * Section ids are the X letters of the naming convention in
+ * solid_base.h.  Readers skip sections they do not know.
+ *
+ * A packed image has the same header and section table, with the
+ * fourth header word giving the length of the unpacked image.  The
+ * table is followed by one word per section giving its packed length,
+ * then the data of each section in table order, each as a separate
+ * zlib stream.  Offsets in the table are those of the unpacked image,
+ * so a reader can inflate each section straight into its place.
+ */
 
-    if ((fin = fs_open(filename, "r")))
-    {
-        res = sol_load_file(fin, fp);
-        fs_close(fin);
-    }
-    return res;
-}
+#define SOL_IMAGE_ALIGN 16
 
-int sol_load_meta(struct s_base *fp, const char *filename)
-{
-    fs_file fin;
-    int res = 0;
+#define SOL_IMAGE_PAD(n) (((n) + SOL_IMAGE_ALIGN - 1) & ~(SOL_IMAGE_ALIGN - 1))
 
-    memset(fp, 0, sizeof (*fp));
+#define SOL_IMAGE_HEAD    SOL_IMAGE_ALIGN
+#define SOL_IMAGE_ENTRY   16
+#define SOL_IMAGE_TAIL    ((int) SOL_IMAGE_PAD(sizeof (struct b_ball)))
 
-    if ((fin = fs_open(filename, "r")))
-    {
-        res = sol_load_head(fin, fp);
-        fs_close(fin);
-    }
-    return res;
+#define SOL_PACK_CHUNK    32768         /* packed bytes read at a time       */
+#define SOL_PACK_RATIO    1032          /* deflate's best compression ratio  */
+
+#define SECT(id, c, v) {                \
+    id,                                 \
+    offsetof(struct s_base, c),         \
+    offsetof(struct s_base, v),         \
+    sizeof (*((struct s_base *) 0)->v)  \
 }
 
-void sol_free_base(struct s_base *fp)
+static const struct sol_sect
 {
-    if (fp->av) free(fp->av);
-    if (fp->mv) free(fp->mv);
-    if (fp->vv) free(fp->vv);
-    if (fp->ev) free(fp->ev);
-    if (fp->sv) free(fp->sv);
-    if (fp->tv) free(fp->tv);
-    if (fp->ov) free(fp->ov);
-    if (fp->gv) free(fp->gv);
-    if (fp->lv) free(fp->lv);
-    if (fp->nv) free(fp->nv);
-    if (fp->pv) free(fp->pv);
-    if (fp->bv) free(fp->bv);
-    if (fp->hv) free(fp->hv);
-    if (fp->zv) free(fp->zv);
-    if (fp->jv) free(fp->jv);
-    if (fp->xv) free(fp->xv);
-    if (fp->rv) free(fp->rv);
-    if (fp->uv) free(fp->uv);
-    if (fp->wv) free(fp->wv);
-    if (fp->dv) free(fp->dv);
-    if (fp->iv) free(fp->iv);
+    int    id;
+    size_t c;                           /* offset of the count member        */
+    size_t v;                           /* offset of the vector member       */
+    size_t size;                        /* element size                      */
+} sol_sects[] = {
+    SECT('a', ac, av),
+    SECT('d', dc, dv),
+    SECT('m', mc, mv),
+    SECT('v', vc, vv),
+    SECT('e', ec, ev),
+    SECT('s', sc, sv),
+    SECT('t', tc, tv),
+    SECT('o', oc, ov),
+    SECT('g', gc, gv),
+    SECT('l', lc, lv),
+    SECT('n', nc, nv),
+    SECT('p', pc, pv),
+    SECT('b', bc, bv),
+    SECT('h', hc, hv),
+    SECT('z', zc, zv),
+    SECT('j', jc, jv),
+    SECT('x', xc, xv),
+    SECT('r', rc, rv),
+    SECT('u', uc, uv),
+    SECT('w', wc, wv),
+    SECT('i', ic, iv),
+    SECT('k', kc, kv),
+    SECT('y', yc, yv),
+    SECT('c', cc, cv),
+    SECT('q', qc, qv)
+};
 
-    memset(fp, 0, sizeof (*fp));
-}
+#undef SECT
 
-/*---------------------------------------------------------------------------*/
+#define SECT_C(fp, sp) (*(int *)   ((char *) (fp) + (sp)->c))
+#define SECT_V(fp, sp) (*(void **) ((char *) (fp) + (sp)->v))
 
-static void sol_stor_mtrl(fs_file fout, struct b_mtrl *mp)
+static const struct sol_sect *sol_sect(int id)
 {
-    put_array(fout, mp->d, 4);
-    put_array(fout, mp->a, 4);
-    put_array(fout, mp->s, 4);
-    put_array(fout, mp->e, 4);
-    put_array(fout, mp->h, 1);
-    put_index(fout, mp->fl);
+    int i;
 
-    fs_write(mp->f, 1, PATHMAX, fout);
+    for (i = 0; i < ARRAYSIZE(sol_sects); i++)
+        if (sol_sects[i].id == id)
+            return sol_sects + i;
 
-    if (mp->fl & M_ALPHA_TEST)
-    {
-        put_index(fout, mp->alpha_func);
-        put_float(fout, mp->alpha_ref);
-    }
+    return NULL;
 }
 
-static void sol_stor_vert(fs_file fout, struct b_vert *vp)
+static int swap_word(int w)
 {
-    put_array(fout,  vp->p, 3);
-}
+    unsigned int u = (unsigned int) w;
 
-static void sol_stor_edge(fs_file fout, struct b_edge *ep)
-{
-    put_index(fout, ep->vi);
-    put_index(fout, ep->vj);
+    return (int) ((u >> 24) | ((u >> 8) & 0xff00) |
+                  ((u & 0xff00) << 8) | (u << 24));
 }
 
-static void sol_stor_side(fs_file fout, struct b_side *sp)
+static void swap_words(void *p, size_t n)
 {
-    put_array(fout, sp->n, 3);
-    put_float(fout, sp->d);
-}
+    int *w = (int *) p;
+    size_t i;
 
-static void sol_stor_texc(fs_file fout, struct b_texc *tp)
-{
-    put_array(fout,  tp->u, 2);
+    for (i = 0; i < n; i++)
+        w[i] = swap_word(w[i]);
 }
 
-static void sol_stor_offs(fs_file fout, struct b_offs *op)
+static void swap_halfs(void *p, size_t n)
 {
-    put_index(fout, op->ti);
-    put_index(fout, op->si);
-    put_index(fout, op->vi);
-}
+    unsigned short *h = (unsigned short *) p;
+    size_t i;
 
-static void sol_stor_geom(fs_file fout, struct b_geom *gp)
-{
-    put_index(fout, gp->mi);
-    put_index(fout, gp->oi);
-    put_index(fout, gp->oj);
-    put_index(fout, gp->ok);
+    for (i = 0; i < n; i++)
+        h[i] = (unsigned short) ((h[i] >> 8) | (h[i] << 8));
 }
 
-static void sol_stor_lump(fs_file fout, struct b_lump *lp)
+/*
+ * Swap the words of N elements of section SP.  Text is left alone, as
+ * are material file names.  Packed vertices are made of half words.
+ */
+static void sol_swap_sect(const struct sol_sect *sp, void *p, int n)
 {
-    put_index(fout, lp->fl);
-    put_index(fout, lp->v0);
-    put_index(fout, lp->vc);
-    put_index(fout, lp->e0);
-    put_index(fout, lp->ec);
-    put_index(fout, lp->g0);
-    put_index(fout, lp->gc);
-    put_index(fout, lp->s0);
-    put_index(fout, lp->sc);
-}
+    int i;
 
-static void sol_stor_node(fs_file fout, struct b_node *np)
-{
-    put_index(fout, np->si);
-    put_index(fout, np->ni);
-    put_index(fout, np->nj);
-    put_index(fout, np->l0);
-    put_index(fout, np->lc);
-}
+    if (sp->id == 'a')
+        return;
 
-static void sol_stor_path(fs_file fout, struct b_path *pp)
-{
-    put_array(fout, pp->p, 3);
-    put_float(fout, pp->t);
-    put_index(fout, pp->pi);
-    put_index(fout, pp->f);
-    put_index(fout, pp->s);
-    put_index(fout, pp->fl);
+    if (sp->id == 'q')
+    {
+        swap_halfs(p, sp->size * n / sizeof (short));
+        return;
+    }
 
-    if (pp->fl & P_ORIENTED)
-        put_array(fout, pp->e, 4);
-}
+    if (sp->id == 'm')
+    {
+        const size_t f0 = offsetof(struct b_mtrl, f);
+        const size_t f1 = f0 + PATHMAX;
 
-static void sol_stor_body(fs_file fout, struct b_body *bp)
-{
-    put_index(fout, bp->pi);
-    put_index(fout, bp->pj);
-    put_index(fout, bp->ni);
-    put_index(fout, bp->l0);
-    put_index(fout, bp->lc);
-    put_index(fout, bp->g0);
-    put_index(fout, bp->gc);
-}
+        for (i = 0; i < n; i++)
+        {
+            char *mp = (char *) p + sp->size * i;
 
-static void sol_stor_item(fs_file fout, struct b_item *hp)
-{
-    put_array(fout, hp->p, 3);
-    put_index(fout, hp->t);
-    put_index(fout, hp->n);
+            swap_words(mp,      f0               / sizeof (int));
+            swap_words(mp + f1, (sp->size - f1) / sizeof (int));
+        }
+        return;
+    }
+
+    swap_words(p, sp->size * n / sizeof (int));
 }
 
-static void sol_stor_goal(fs_file fout, struct b_goal *zp)
+/*
+ * Check for an image.  Leave the stream at the start of the file and
+ * return the image version and the swap flag if it is one, else 0.
+ */
+static int sol_file_image(fs_file fin, int *swap)
 {
-    put_array(fout, zp->p, 3);
-    put_float(fout, zp->r);
+    int head[2];
+
+    if (fs_read(head, sizeof (head), 1, fin) != 1)
+        return 0;
+
+    fs_seek(fin, 0, SEEK_SET);
+
+    if (head[0] == SOL_MAGIC)
+        *swap = 0;
+    else if (swap_word(head[0]) == SOL_MAGIC)
+        *swap = 1;
+    else
+        return 0;
+
+    if (*swap)
+        head[1] = swap_word(head[1]);
+
+    if (head[1] == SOL_VERSION_IMAGE || head[1] == SOL_VERSION_PACK)
+        return head[1];
+
+    return 0;
 }
 
-static void sol_stor_swch(fs_file fout, struct b_swch *xp)
+/*
+ * Parse the header and section table of an image of LEN bytes at DATA
+ * and return the section count, or -1 if it is malformed.  The table is
+ * swapped in place if needed.  Sections must lie past the table, so that
+ * swapping or inflating one cannot change the table being walked.
+ */
+static int sol_image_head(int *data, int len, int swap)
 {
-    put_array(fout, xp->p, 3);
-    put_float(fout, xp->r);
-    put_index(fout, xp->pi);
-    put_float(fout, xp->t);
-    put_float(fout, xp->t);
-    put_index(fout, xp->f);
-    put_index(fout, xp->f);
-    put_index(fout, xp->i);
+    int n, i, end;
+
+    if (len < SOL_IMAGE_HEAD)
+        return -1;
+
+    if (swap)
+        swap_words(data, 3);
+
+    n = data[2];
+
+    if (n < 0 || n > (len - SOL_IMAGE_HEAD) / SOL_IMAGE_ENTRY)
+        return -1;
+
+    end   = SOL_IMAGE_HEAD + n * SOL_IMAGE_ENTRY;
+    data += SOL_IMAGE_HEAD / sizeof (int);
+
+    if (swap)
+        swap_words(data, n * SOL_IMAGE_ENTRY / sizeof (int));
+
+    for (i = 0; i < n; i++)
+    {
+        const int *ep = data + i * SOL_IMAGE_ENTRY / sizeof (int);
+        const struct sol_sect *sp;
+
+        if (!(sp = sol_sect(ep[0])))
+            continue;
+
+        if (ep[1] < 0 || ep[2] != (int) sp->size || ep[3] < 0 ||
+            ep[3] % sizeof (int) || (ep[1] && ep[3] < end) ||
+            ep[3] > len || ep[1] > (len - ep[3]) / (int) sp->size)
+            return -1;
+    }
+    return n;
 }
 
-static void sol_stor_bill(fs_file fout, struct b_bill *rp)
+/*
+ * Check the length LEN of the image in FIN, as given by its header if
+ * packed.  It must leave room to pad the image and add a ball, and a
+ * packed image can't inflate to more than deflate's best ratio allows.
+ */
+static int sol_image_len(fs_file fin, int len, int pack)
 {
-    put_index(fout, rp->fl);
-    put_index(fout, rp->mi);
-    put_float(fout, rp->t);
-    put_float(fout, rp->d);
-    put_array(fout, rp->w,  3);
-    put_array(fout, rp->h,  3);
-    put_array(fout, rp->rx, 3);
-    put_array(fout, rp->ry, 3);
-    put_array(fout, rp->rz, 3);
-    put_array(fout, rp->p,  3);
+    if (len < SOL_IMAGE_HEAD ||
+        len > INT_MAX - SOL_IMAGE_ALIGN - SOL_IMAGE_TAIL)
+        return 0;
+
+    if (pack && len / SOL_PACK_RATIO > fs_length(fin))
+        return 0;
+
+    return 1;
 }
 
-static void sol_stor_jump(fs_file fout, struct b_jump *jp)
+/*
+ * Packed bytes are read through one buffer shared by all sections, so
+ * that a load takes few reads and no more memory than the buffer.
+ */
+struct sol_pack
 {
-    put_array(fout, jp->p, 3);
-    put_array(fout, jp->q, 3);
-    put_float(fout, jp->r);
-}
+    fs_file        fin;
+    unsigned char *buf;
+    unsigned char *p;                   /* next unused byte                  */
+    int            n;                   /* unused byte count                 */
+};
 
-static void sol_stor_ball(fs_file fout, struct b_ball *bp)
+/*
+ * Point P at up to LEN of the next packed bytes and return their count,
+ * or 0 at the end of the file.
+ */
+static int sol_pack_take(struct sol_pack *in, unsigned char **p, int len)
 {
-    put_array(fout, bp->p, 3);
-    put_float(fout, bp->r);
+    if (len <= 0)
+        return 0;
+
+    if (in->n == 0)
+    {
+        in->p = in->buf;
+
+        if ((in->n = fs_read(in->buf, 1, SOL_PACK_CHUNK, in->fin)) <= 0)
+        {
+            in->n = 0;
+            return 0;
+        }
+    }
+
+    len = MIN(len, in->n);
+
+    *p = in->p;
+
+    in->p += len;
+    in->n -= len;
+
+    return len;
 }
 
-static void sol_stor_view(fs_file fout, struct b_view *wp)
+static int sol_pack_skip(struct sol_pack *in, int plen)
 {
-    put_array(fout,  wp->p, 3);
-    put_array(fout,  wp->q, 3);
+    unsigned char *p;
+    int n;
+
+    while (plen > 0 && (n = sol_pack_take(in, &p, plen)))
+        plen -= n;
+
+    return plen == 0;
 }
 
-static void sol_stor_dict(fs_file fout, struct b_dict *dp)
+/*
+ * Inflate the next zlib stream of PLEN packed bytes into exactly LEN
+ * bytes at DST.
+ */
+static int sol_read_pack(struct sol_pack *in, void *dst, int len, int plen)
 {
-    put_index(fout, dp->ai);
-    put_index(fout, dp->aj);
+    z_stream zs;
+    int ret = Z_OK;
+
+    memset(&zs, 0, sizeof (zs));
+
+    if (inflateInit(&zs) != Z_OK)
+        return 0;
+
+    zs.next_out  = (Bytef *) dst;
+    zs.avail_out = (uInt) len;
+
+    while (ret == Z_OK)
+    {
+        if (zs.avail_in == 0)
+        {
+            unsigned char *p;
+            int n;
+
+            if (!(n = sol_pack_take(in, &p, plen)))
+                break;
+
+            zs.next_in  = p;
+            zs.avail_in = (uInt) n;
+
+            plen -= n;
+        }
+        ret = inflate(&zs, Z_NO_FLUSH);
+    }
+
+    inflateEnd(&zs);
+
+    return (ret == Z_STREAM_END && zs.avail_out == 0 &&
+            zs.avail_in == 0 && plen == 0);
 }
 
-static void sol_stor_file(fs_file fout, struct s_base *fp)
+/*
+ * Read the packed lengths of N sections following the table of a packed
+ * image and return them, or NULL.
+ */
+static int *sol_read_plen(fs_file fin, int n, int swap)
 {
+    int *plen;
     int i;
-    int magic   = SOL_MAGIC;
-    int version = SOL_VERSION_CURR;
-
-    put_index(fout, magic);
-    put_index(fout, version);
-
-    put_index(fout, fp->ac);
-    put_index(fout, fp->dc);
-    put_index(fout, fp->mc);
-    put_index(fout, fp->vc);
-    put_index(fout, fp->ec);
-    put_index(fout, fp->sc);
-    put_index(fout, fp->tc);
-    put_index(fout, fp->oc);
-    put_index(fout, fp->gc);
-    put_index(fout, fp->lc);
-    put_index(fout, fp->nc);
-    put_index(fout, fp->pc);
-    put_index(fout, fp->bc);
-    put_index(fout, fp->hc);
-    put_index(fout, fp->zc);
-    put_index(fout, fp->jc);
-    put_index(fout, fp->xc);
-    put_index(fout, fp->rc);
-    put_index(fout, fp->uc);
-    put_index(fout, fp->wc);
-    put_index(fout, fp->ic);
-
-    fs_write(fp->av, 1, fp->ac, fout);
-
-    for (i = 0; i < fp->dc; i++) sol_stor_dict(fout, fp->dv + i);
-    for (i = 0; i < fp->mc; i++) sol_stor_mtrl(fout, fp->mv + i);
-    for (i = 0; i < fp->vc; i++) sol_stor_vert(fout, fp->vv + i);
-    for (i = 0; i < fp->ec; i++) sol_stor_edge(fout, fp->ev + i);
-    for (i = 0; i < fp->sc; i++) sol_stor_side(fout, fp->sv + i);
-    for (i = 0; i < fp->tc; i++) sol_stor_texc(fout, fp->tv + i);
-    for (i = 0; i < fp->oc; i++) sol_stor_offs(fout, fp->ov + i);
-    for (i = 0; i < fp->gc; i++) sol_stor_geom(fout, fp->gv + i);
-    for (i = 0; i < fp->lc; i++) sol_stor_lump(fout, fp->lv + i);
-    for (i = 0; i < fp->nc; i++) sol_stor_node(fout, fp->nv + i);
-    for (i = 0; i < fp->pc; i++) sol_stor_path(fout, fp->pv + i);
-    for (i = 0; i < fp->bc; i++) sol_stor_body(fout, fp->bv + i);
-    for (i = 0; i < fp->hc; i++) sol_stor_item(fout, fp->hv + i);
-    for (i = 0; i < fp->zc; i++) sol_stor_goal(fout, fp->zv + i);
-    for (i = 0; i < fp->jc; i++) sol_stor_jump(fout, fp->jv + i);
-    for (i = 0; i < fp->xc; i++) sol_stor_swch(fout, fp->xv + i);
-    for (i = 0; i < fp->rc; i++) sol_stor_bill(fout, fp->rv + i);
-    for (i = 0; i < fp->uc; i++) sol_stor_ball(fout, fp->uv + i);
-    for (i = 0; i < fp->wc; i++) sol_stor_view(fout, fp->wv + i);
-    for (i = 0; i < fp->ic; i++) put_index(fout, fp->iv[i]);
-}
-
-int sol_stor_base(struct s_base *fp, const char *filename)
-{
-    fs_file fout;
 
-    if ((fout = fs_open(filename, "w")))
-    {
-        sol_stor_file(fout, fp);
-        fs_close(fout);
+    if (!(plen = (int *) calloc(n + 1, sizeof (int))))
+        return NULL;
 
-        return 1;
+    if (n && fs_read(plen, sizeof (int), n, fin) != n)
+    {
+        free(plen);
+        return NULL;
     }
-    return 0;
+
+    if (swap)
+        swap_words(plen, n);
+
+    for (i = 0; i < n; i++)
+        if (plen[i] < 0)
+        {
+            free(plen);
+            return NULL;
+        }
+
+    return plen;
+}
+
+/*
+ * Read the table and the known sections of a packed image of LEN bytes,
+ * the header of which is already at DATA.  Return the section count,
+ * or -1.  Each section is inflated in place.
+ */
+static int sol_load_pack(fs_file fin, char *data, int len, int swap)
+{
+    struct sol_pack in;
+    int *plen;
+    int n, i;
+
+    n = swap ? swap_word(((int *) data)[2]) : ((int *) data)[2];
+
+    if (n < 0 || n > (len - SOL_IMAGE_HEAD) / SOL_IMAGE_ENTRY)
+        return -1;
+
+    if (n && fs_read(data + SOL_IMAGE_HEAD, SOL_IMAGE_ENTRY, n, fin) != n)
+        return -1;
+
+    if (sol_image_head((int *) data, len, swap) < 0)
+        return -1;
+
+    if (!(plen = sol_read_plen(fin, n, swap)))
+        return -1;
+
+    memset(&in, 0, sizeof (in));
+
+    in.fin = fin;
+
+    if (!(in.buf = (unsigned char *) malloc(SOL_PACK_CHUNK)))
+    {
+        free(plen);
+        return -1;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        const int *ep = (int *) (data + SOL_IMAGE_HEAD + i * SOL_IMAGE_ENTRY);
+        const struct sol_sect *sp;
+
+        if ((sp = sol_sect(ep[0])) && ep[1])
+        {
+            if (!sol_read_pack(&in, data + ep[3], (int) sp->size * ep[1],
+                               plen[i]))
+                break;
+        }
+        else if (!sol_pack_skip(&in, plen[i]))
+            break;
+    }
+
+    free(in.buf);
+    free(plen);
+
+    return i < n ? -1 : n;
+}
+
+/*
+ * Reproduce the fix-ups done by the stream reader.
+ */
+static void sol_load_fix(struct s_base *fp)
+{
+    int i;
+
+    for (i = 0; i < fp->pc; i++)
+    {
+        struct b_path *pp = fp->pv + i;
+
+        pp->tm = TIME_TO_MS(pp->t);
+        pp->t  = MS_TO_TIME(pp->tm);
+
+        if (!(pp->fl & P_ORIENTED))
+        {
+            pp->e[0] = 1.0f;
+            pp->e[1] = 0.0f;
+            pp->e[2] = 0.0f;
+            pp->e[3] = 0.0f;
+        }
+    }
+
+    for (i = 0; i < fp->bc; i++)
+        if (fp->bv[i].pj < 0)
+            fp->bv[i].pj = fp->bv[i].pi;
+
+    for (i = 0; i < fp->xc; i++)
+    {
+        struct b_swch *xp = fp->xv + i;
+
+        xp->tm = TIME_TO_MS(xp->t);
+        xp->t  = MS_TO_TIME(xp->tm);
+    }
+}
+
+static int sol_load_image(fs_file fin, struct s_base *fp, int swap, int pack)
+{
+    const int tail = SOL_IMAGE_TAIL;
+
+    int head[SOL_IMAGE_HEAD / sizeof (int)];
+    char *data;
+    int len, pad, n, i;
+
+    /* A packed image gives its unpacked length in the header. */
+
+    if (pack)
+    {
+        if (fs_read(head, sizeof (head), 1, fin) != 1)
+            return 0;
+
+        len = swap ? swap_word(head[3]) : head[3];
+    }
+    else
+        len = fs_length(fin);
+
+    if (!sol_image_len(fin, len, pack))
+        return 0;
+
+    /* Leave room for a default ball at the end. */
+
+    pad = SOL_IMAGE_PAD(len);
+
+    if (!(data = (char *) malloc(pad + tail)))
+        return 0;
+
+    if (pack)
+    {
+        memcpy(data, head, sizeof (head));
+
+        n = sol_load_pack(fin, data, len, swap);
+    }
+    else if (fs_read(data, len, 1, fin) == 1)
+        n = sol_image_head((int *) data, len, swap);
+    else
+        n = -1;
+
+    if (n < 0)
+    {
+        free(data);
+        return 0;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        const int *ep = (int *) (data + SOL_IMAGE_HEAD + i * SOL_IMAGE_ENTRY);
+        const struct sol_sect *sp = sol_sect(ep[0]);
+
+        const int c = ep[1];
+        const int o = ep[3];
+
+        if (sp && c)
+        {
+            if (swap)
+                sol_swap_sect(sp, data + o, c);
+
+            SECT_C(fp, sp) = c;
+            SECT_V(fp, sp) = data + o;
+        }
+    }
+
+    fp->data = data;
+
+    sol_load_fix(fp);
+
+    /* Magically "fix" all of our code. */
+
+    if (!fp->uc)
+    {
+        memset(data + pad, 0, tail);
+
+        fp->uc = 1;
+        fp->uv = (struct b_ball *) (data + pad);
+    }
+
+    return 1;
+}
+
+/*
+ * Read only the text and dictionary sections of an image.
+ */
+static int sol_load_image_head(fs_file fin, struct s_base *fp, int swap,
+                               int pack)
+{
+    int head[SOL_IMAGE_HEAD / sizeof (int)];
+    int *table;
+    int *plen = NULL;
+    struct sol_pack in;
+    int len, n, i, pos;
+
+    memset(&in, 0, sizeof (in));
+
+    if (fs_read(head, sizeof (head), 1, fin) != 1)
+        return 0;
+
+    if (pack)
+        len = swap ? swap_word(head[3]) : head[3];
+    else
+        len = fs_length(fin);
+
+    n = swap ? swap_word(head[2]) : head[2];
+
+    if (!sol_image_len(fin, len, pack) ||
+        n < 0 || n > (len - SOL_IMAGE_HEAD) / SOL_IMAGE_ENTRY)
+        return 0;
+
+    if (!(table = (int *) malloc(SOL_IMAGE_HEAD + n * SOL_IMAGE_ENTRY)))
+        return 0;
+
+    memcpy(table, head, sizeof (head));
+
+    if (fs_read(table + SOL_IMAGE_HEAD / sizeof (int),
+                SOL_IMAGE_ENTRY, n, fin) != n ||
+        sol_image_head(table, len, swap) < 0 ||
+        (pack && !(plen   = sol_read_plen(fin, n, swap))) ||
+        (pack && !(in.buf = (unsigned char *) malloc(SOL_PACK_CHUNK))))
+    {
+        free(plen);
+        free(table);
+        return 0;
+    }
+
+    in.fin = fin;
+
+    pos = SOL_IMAGE_HEAD + n * (SOL_IMAGE_ENTRY + (int) sizeof (int));
+
+    for (i = 0; i < n; i++)
+    {
+        const int *ep = table + (SOL_IMAGE_HEAD + i * SOL_IMAGE_ENTRY) /
+                                sizeof (int);
+        const struct sol_sect *sp = sol_sect(ep[0]);
+        void *p;
+
+        if (sp && (sp->id == 'a' || sp->id == 'd') && ep[1])
+        {
+            if ((p = calloc(ep[1], sp->size)))
+            {
+                if (pack)
+                {
+                    fs_seek(fin, pos, SEEK_SET);
+                    in.n = 0;
+                    sol_read_pack(&in, p, (int) sp->size * ep[1], plen[i]);
+                }
+                else
+                {
+                    fs_seek(fin, ep[3], SEEK_SET);
+                    fs_read(p, sp->size, ep[1], fin);
+                }
+
+                if (swap)
+                    sol_swap_sect(sp, p, ep[1]);
+
+                SECT_C(fp, sp) = ep[1];
+                SECT_V(fp, sp) = p;
+            }
+        }
+        if (pack)
+            pos += plen[i];
+    }
+
+    free(in.buf);
+    free(plen);
+    free(table);
+
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Structural validation.  Every index a SOL stores is checked against
+ * the count of the vector it refers to, in one pass over each vector.
+ * Nodes must come before their children, so that descending the tree
+ * always ends.  sol_load_base rejects a file that fails this, so code
+ * working on a loaded base follows its indices without checking them.
+ */
+
+#define CHECK_I(i, c)     ((unsigned int) (i) < (unsigned int) (c))
+#define CHECK_J(i, c)     ((i) == -1 || CHECK_I(i, c))
+#define CHECK_R(i0, n, c) ((i0) >= 0 && (n) >= 0 && (i0) <= (c) - (n))
+
+/*
+ * Check that the N indices at I0 in the index vector are all below C.
+ */
+static int check_indx(const struct s_base *fp, int i0, int n, int c)
+{
+    int i;
+
+    if (!CHECK_R(i0, n, fp->ic))
+        return 0;
+
+    for (i = i0; i < i0 + n; i++)
+        if (!CHECK_I(fp->iv[i], c))
+            return 0;
+
+    return 1;
+}
+
+static int check_mesh(const struct s_base *fp, const struct b_mesh *kp)
+{
+    int i;
+
+    if (!CHECK_I(kp->bi, fp->bc) ||
+        !CHECK_I(kp->mi, fp->mc) ||
+        !CHECK_R(kp->o0, kp->oc, fp->yc) ||
+        !CHECK_I(kp->gc, fp->yc / 3 + 1) ||
+        !CHECK_R(kp->g0, kp->gc * 3, fp->yc))
+        return 0;
+
+    if ((fp->cc && !CHECK_R(kp->c0, kp->oc, fp->cc)) ||
+        (fp->qc && !CHECK_R(kp->q0, kp->oc, fp->qc)))
+        return 0;
+
+    /* A short has 15 bits past its sign, all of which may be fraction. */
+
+    if (fp->qc && (!CHECK_I(kp->qp, 16) || !CHECK_I(kp->qt, 16)))
+        return 0;
+
+    /* Offs indices, then triangles indexing those offs. */
+
+    for (i = 0; i < kp->oc; i++)
+        if (!CHECK_I(fp->yv[kp->o0 + i], fp->oc))
+            return 0;
+
+    for (i = 0; i < kp->gc * 3; i++)
+        if (!CHECK_I(fp->yv[kp->g0 + i], kp->oc))
+            return 0;
+
+    return 1;
+}
+
+/*
+ * Check the text and dictionary, the only vectors sol_load_meta reads.
+ */
+static int check_dict(const struct s_base *fp)
+{
+    int i;
+
+    /* Text must end in a NUL, so that any offset into it is a string. */
+
+    if (fp->ac && fp->av[fp->ac - 1])
+        return 0;
+
+    for (i = 0; i < fp->dc; i++)
+    {
+        const struct b_dict *dp = fp->dv + i;
+
+        if (!CHECK_I(dp->ai, fp->ac) || !CHECK_I(dp->aj, fp->ac))
+            return 0;
+    }
+
+    return 1;
+}
+
+int sol_check_base(const struct s_base *fp)
+{
+    int i;
+
+    if (!check_dict(fp))
+        return 0;
+
+    for (i = 0; i < fp->mc; i++)
+        if (!memchr(fp->mv[i].f, 0, PATHMAX))
+            return 0;
+
+    for (i = 0; i < fp->ec; i++)
+    {
+        const struct b_edge *ep = fp->ev + i;
+
+        if (!CHECK_I(ep->vi, fp->vc) || !CHECK_I(ep->vj, fp->vc))
+            return 0;
+    }
+
+    for (i = 0; i < fp->oc; i++)
+    {
+        const struct b_offs *op = fp->ov + i;
+
+        if (!CHECK_I(op->ti, fp->tc) ||
+            !CHECK_I(op->si, fp->sc) ||
+            !CHECK_I(op->vi, fp->vc))
+            return 0;
+    }
+
+    for (i = 0; i < fp->gc; i++)
+    {
+        const struct b_geom *gp = fp->gv + i;
+
+        if (!CHECK_I(gp->mi, fp->mc) ||
+            !CHECK_I(gp->oi, fp->oc) ||
+            !CHECK_I(gp->oj, fp->oc) ||
+            !CHECK_I(gp->ok, fp->oc))
+            return 0;
+    }
+
+    for (i = 0; i < fp->lc; i++)
+    {
+        const struct b_lump *lp = fp->lv + i;
+
+        if (!check_indx(fp, lp->v0, lp->vc, fp->vc) ||
+            !check_indx(fp, lp->e0, lp->ec, fp->ec) ||
+            !check_indx(fp, lp->g0, lp->gc, fp->gc) ||
+            !check_indx(fp, lp->s0, lp->sc, fp->sc))
+            return 0;
+    }
+
+    for (i = 0; i < fp->nc; i++)
+    {
+        const struct b_node *np = fp->nv + i;
+
+        if ((np->ni != -1 && (np->ni <= i || np->ni >= fp->nc)) ||
+            (np->nj != -1 && (np->nj <= i || np->nj >= fp->nc)))
+            return 0;
+
+        if ((np->ni != -1 || np->nj != -1) && !CHECK_I(np->si, fp->sc))
+            return 0;
+
+        if (!CHECK_R(np->l0, np->lc, fp->lc))
+            return 0;
+    }
+
+    for (i = 0; i < fp->pc; i++)
+        if (!CHECK_I(fp->pv[i].pi, fp->pc))
+            return 0;
+
+    for (i = 0; i < fp->bc; i++)
+    {
+        const struct b_body *bp = fp->bv + i;
+
+        if (!CHECK_J(bp->pi, fp->pc) ||
+            !CHECK_J(bp->pj, fp->pc) ||
+            !CHECK_I(bp->ni, fp->nc) ||
+            !CHECK_R(bp->l0, bp->lc, fp->lc) ||
+            !check_indx(fp, bp->g0, bp->gc, fp->gc))
+            return 0;
+    }
+
+    /* A switch may name a path in a level that has none. */
+
+    for (i = 0; i < fp->xc; i++)
+    {
+        const struct b_swch *xp = fp->xv + i;
+
+        if ((fp->pc && !CHECK_I(xp->pi, fp->pc)) || !CHECK_I(xp->f, 2))
+            return 0;
+    }
+
+    for (i = 0; i < fp->rc; i++)
+        if (!CHECK_I(fp->rv[i].mi, fp->mc))
+            return 0;
+
+    for (i = 0; i < fp->kc; i++)
+        if (!check_mesh(fp, fp->kv + i))
+            return 0;
+
+    return 1;
+}
+
+#undef CHECK_R
+#undef CHECK_J
+#undef CHECK_I
+
+/*---------------------------------------------------------------------------*/
+
+int sol_load_base(struct s_base *fp, const char *filename)
+{
+    fs_file fin;
+    int res = 0;
+    int swap, v;
+
+    memset(fp, 0, sizeof (*fp));
+
+    if ((fin = fs_open(filename, "r")))
+    {
+        if ((v = sol_file_image(fin, &swap)))
+            res = sol_load_image(fin, fp, swap, v == SOL_VERSION_PACK);
+        else
+            res = sol_load_file(fin, fp);
+
+        fs_close(fin);
+
+        if (!(res && sol_check_base(fp)))
+        {
+            sol_free_base(fp);
+            res = 0;
+        }
+    }
+    return res;
+}
+
+int sol_load_meta(struct s_base *fp, const char *filename)
+{
+    fs_file fin;
+    int res = 0;
+    int swap, v;
+
+    memset(fp, 0, sizeof (*fp));
+
+    if ((fin = fs_open(filename, "r")))
+    {
+        if ((v = sol_file_image(fin, &swap)))
+            res = sol_load_image_head(fin, fp, swap, v == SOL_VERSION_PACK);
+        else
+            res = sol_load_head(fin, fp);
+
+        fs_close(fin);
+
+        if (!(res && check_dict(fp)))
+        {
+            sol_free_base(fp);
+            res = 0;
+        }
+    }
+    return res;
+}
+
+void sol_free_base(struct s_base *fp)
+{
+    if (fp->data)
+    {
+        free(fp->data);
+        memset(fp, 0, sizeof (*fp));
+        return;
+    }
+
+    if (fp->av) free(fp->av);
+    if (fp->mv) free(fp->mv);
+    if (fp->vv) free(fp->vv);
+    if (fp->ev) free(fp->ev);
+    if (fp->sv) free(fp->sv);
+    if (fp->tv) free(fp->tv);
+    if (fp->ov) free(fp->ov);
+    if (fp->gv) free(fp->gv);
+    if (fp->lv) free(fp->lv);
+    if (fp->nv) free(fp->nv);
+    if (fp->pv) free(fp->pv);
+    if (fp->bv) free(fp->bv);
+    if (fp->hv) free(fp->hv);
+    if (fp->zv) free(fp->zv);
+    if (fp->jv) free(fp->jv);
+    if (fp->xv) free(fp->xv);
+    if (fp->rv) free(fp->rv);
+    if (fp->uv) free(fp->uv);
+    if (fp->wv) free(fp->wv);
+    if (fp->dv) free(fp->dv);
+    if (fp->iv) free(fp->iv);
+    if (fp->kv) free(fp->kv);
+    if (fp->yv) free(fp->yv);
+    if (fp->cv) free(fp->cv);
+    if (fp->qv) free(fp->qv);
+
+    memset(fp, 0, sizeof (*fp));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int sol_stor_sect(fs_file fout, const struct sol_sect *sp,
+                         const void *p, int n, int swap)
+{
+    size_t len = sp->size * n;
+    void *buf;
+    int res;
+
+    if (!swap || sp->id == 'a')
+        return fs_write(p, 1, len, fout) == (int) len;
+
+    if (!(buf = malloc(len)))
+        return 0;
+
+    memcpy(buf, p, len);
+    sol_swap_sect(sp, buf, n);
+
+    res = (fs_write(buf, 1, len, fout) == (int) len);
+
+    free(buf);
+
+    return res;
+}
+
+/*
+ * Deflate N elements of section SP, swapped if needed, into a new
+ * buffer at OUT.  Return the packed length, or -1.
+ */
+static int sol_pack_sect(const struct sol_sect *sp, const void *p, int n,
+                         int swap, unsigned char **out)
+{
+    const uLong len = (uLong) (sp->size * n);
+
+    uLongf plen = compressBound(len);
+    void *buf = NULL;
+    int res = -1;
+
+    if (swap && sp->id != 'a')
+    {
+        if (!(buf = malloc(len)))
+            return -1;
+
+        memcpy(buf, p, len);
+        sol_swap_sect(sp, buf, n);
+
+        p = buf;
+    }
+
+    if ((*out = (unsigned char *) malloc(plen)))
+    {
+        if (compress2(*out, &plen, (const Bytef *) p, len,
+                      Z_BEST_COMPRESSION) == Z_OK)
+            res = (int) plen;
+        else
+        {
+            free(*out);
+            *out = NULL;
+        }
+    }
+
+    free(buf);
+
+    return res;
+}
+
+/*
+ * Write the packed lengths and data of all sections.
+ */
+static int sol_stor_pack(fs_file fout, struct s_base *fp, int swap)
+{
+    const int n = ARRAYSIZE(sol_sects);
+
+    unsigned char *data[ARRAYSIZE(sol_sects)];
+    int            plen[ARRAYSIZE(sol_sects)];
+    int res = 1;
+    int i;
+
+    memset(data, 0, sizeof (data));
+    memset(plen, 0, sizeof (plen));
+
+    for (i = 0; i < n && res; i++)
+    {
+        const struct sol_sect *sp = sol_sects + i;
+        const int c = SECT_C(fp, sp);
+
+        if (c && (plen[i] = sol_pack_sect(sp, SECT_V(fp, sp), c, swap,
+                                          data + i)) < 0)
+            res = 0;
+    }
+
+    if (res)
+    {
+        int word[ARRAYSIZE(sol_sects)];
+
+        memcpy(word, plen, sizeof (word));
+
+        if (swap)
+            swap_words(word, n);
+
+        res = (fs_write(word, sizeof (word), 1, fout) == 1);
+    }
+
+    for (i = 0; i < n && res; i++)
+        if (plen[i] && fs_write(data[i], 1, plen[i], fout) != plen[i])
+            res = 0;
+
+    for (i = 0; i < n; i++)
+        free(data[i]);
+
+    return res;
+}
+
+static int sol_stor_file(fs_file fout, struct s_base *fp, int swap, int pack)
+{
+    static const char zero[SOL_IMAGE_ALIGN];
+
+    const int n = ARRAYSIZE(sol_sects);
+
+    int head[SOL_IMAGE_HEAD / sizeof (int)];
+    int table[ARRAYSIZE(sol_sects)][SOL_IMAGE_ENTRY / sizeof (int)];
+    int off, end = 0, i;
+
+    memset(head, 0, sizeof (head));
+
+    off = SOL_IMAGE_PAD(SOL_IMAGE_HEAD + n * SOL_IMAGE_ENTRY);
+
+    for (i = 0; i < n; i++)
+    {
+        const struct sol_sect *sp = sol_sects + i;
+        const int c = SECT_C(fp, sp);
+
+        table[i][0] = sp->id;
+        table[i][1] = c;
+        table[i][2] = (int) sp->size;
+        table[i][3] = off;
+
+        end = off + (int) sp->size * c;
+        off = SOL_IMAGE_PAD(end);
+    }
+
+    head[0] = SOL_MAGIC;
+    head[1] = pack ? SOL_VERSION_PACK : SOL_VERSION_CURR;
+    head[2] = n;
+    head[3] = pack ? end : 0;
+
+    if (swap)
+    {
+        swap_words(head,  ARRAYSIZE(head));
+        swap_words(table, sizeof (table) / sizeof (int));
+    }
+
+    if (fs_write(head,  sizeof (head),  1, fout) != 1 ||
+        fs_write(table, sizeof (table), 1, fout) != 1)
+        return 0;
+
+    if (pack)
+        return sol_stor_pack(fout, fp, swap);
+
+    off = SOL_IMAGE_HEAD + sizeof (table);
+
+    for (i = 0; i < n; i++)
+    {
+        const struct sol_sect *sp = sol_sects + i;
+        const int c = SECT_C(fp, sp);
+        const int pad = SOL_IMAGE_PAD(off) - off;
+
+        if (pad && fs_write(zero, 1, pad, fout) != pad)
+            return 0;
+
+        if (c && !sol_stor_sect(fout, sp, SECT_V(fp, sp), c, swap))
+            return 0;
+
+        off += pad + (int) sp->size * c;
+    }
+
+    return 1;
+}
+
+int sol_stor_base(struct s_base *fp, const char *filename, int order)
+{
+    const int one = 1;
+    const int big = !*(const char *) &one;
+    const int pack = (order & SOL_PACK);
+
+    fs_file fout;
+    int res = 0;
+    int swap;
+
+    order &= ~SOL_PACK;
+
+    swap = ((order == SOL_ORDER_BIG    && !big) ||
+            (order == SOL_ORDER_LITTLE &&  big));
+
+    if ((fout = fs_open(filename, "w")))
+    {
+        res = sol_stor_file(fout, fp, swap, pack);
+        fs_close(fout);
+    }
+    return res;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -51,7 +51,11 @@
  *     u  User          (struct b_ball)
  *     w  Viewpoint     (struct b_view)
  *     d  Dictionary    (struct b_dict)
+ *     k  Mesh          (struct b_mesh)
+ *     c  Draw vertex   (struct b_cvrt)
+ *     q  Packed vertex (struct b_qvrt)
  *     i  Index         (int)
+ *     y  Mesh index    (int)
  *     a  Text          (char)
  *
  * The Ys are as follows:
@@ -72,7 +76,7 @@
  * Those members that do not conform to this convention are explicitly
  * documented with a comment.
  *
- * These prefixes are still available: c k q y.
+ * All prefixes are now taken.
  */
 
 /*
@@ -283,6 +287,40 @@ struct b_dict
     int aj;
 };
 
+/*
+ * A draw batch: the geoms of one body with one material, merged and
+ * ordered for the vertex cache.  The mesh index holds OC offs indices
+ * at O0, then GC triangles at G0 as triples of indices into those offs.
+ * Optionally, the vertices of those offs are also stored ready to draw,
+ * OC of them from C0 as floats and from Q0 as fixed point numbers with
+ * QP fraction bits for positions, 14 for normals and QT for texcoords.
+ */
+struct b_mesh
+{
+    int bi;
+    int mi;
+    int o0, oc;
+    int g0, gc;
+    int c0;
+    int q0;
+    int qp;                                    /* position fraction bits     */
+    int qt;                                    /* texcoord fraction bits     */
+};
+
+struct b_cvrt
+{
+    float p[3];                                /* position                   */
+    float n[3];                                /* normal                     */
+    float t[2];                                /* texture coordinate         */
+};
+
+struct b_qvrt
+{
+    short p[3];                                /* position                   */
+    short n[3];                                /* normal                     */
+    short t[2];                                /* texture coordinate         */
+};
+
 struct s_base
 {
     int ac;
@@ -305,7 +343,11 @@ struct s_base
     int uc;
     int wc;
     int dc;
+    int kc;
+    int cc;
+    int qc;
     int ic;
+    int yc;
 
     char          *av;
     struct b_mtrl *mv;
@@ -327,20 +369,42 @@ struct s_base
     struct b_ball *uv;
     struct b_view *wv;
     struct b_dict *dv;
+    struct b_mesh *kv;
+    struct b_cvrt *cv;
+    struct b_qvrt *qv;
     int           *iv;
+    int           *yv;
 
     /*
      * A mapping from internal to cached material indices.
      */
     int *mtrls;
+
+    /*
+     * Image buffer the vectors above point into, if loaded from one.
+     */
+    void *data;
 };
 
 /*---------------------------------------------------------------------------*/
 
+/* Byte orders for sol_stor_base, optionally combined with SOL_PACK. */
+
+enum
+{
+    SOL_ORDER_NATIVE = 0,
+    SOL_ORDER_LITTLE,
+    SOL_ORDER_BIG
+};
+
+#define SOL_PACK 0x10                          /* deflate each section       */
+
 int  sol_load_base(struct s_base *, const char *);
 int  sol_load_meta(struct s_base *, const char *);
 void sol_free_base(struct s_base *);
-int  sol_stor_base(struct s_base *, const char *);
+int  sol_stor_base(struct s_base *, const char *, int);
+
+int  sol_check_base(const struct s_base *);
 
 /*---------------------------------------------------------------------------*/
 